@@ -6,6 +6,121 @@
     (((cap) < 8) ? (8) : ((cap) * 2))
 
 
+/*
+* everything that only lives while one module is compiled -- AST nodes, the lists hanging off them,
+* string literals being unescaped by the scanner, and the emitter's per-function scratch -- is carved
+* out of the arena in state->astarena, which tin_state_compilemodule releases in one go once the module
+* has been emitted. nothing allocated here is freed on its own, and none of it counts towards the gc
+* threshold: a node the optimizer drops is simply left behind.
+*/
+
+void tin_astarena_init(TinAstArena* arena)
+{
+    arena->head = NULL;
+    arena->last = NULL;
+    arena->blockcount = 0;
+    arena->allocations = 0;
+    arena->bytesused = 0;
+    arena->bytesreserved = 0;
+}
+
+/* frees every block at once; the counters are left alone, so they can still be reported */
+void tin_astarena_destroy(TinAstArena* arena)
+{
+    TinAstArenaBlock* block;
+    TinAstArenaBlock* next;
+    for(block = arena->head; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    arena->head = NULL;
+    arena->last = NULL;
+}
+
+static size_t tin_astarena_round(size_t size)
+{
+    return (size + (TIN_AST_ARENAALIGN - 1)) & ~(size_t)(TIN_AST_ARENAALIGN - 1);
+}
+
+static TinAstArenaBlock* tin_astarena_makeblock(TinState* state, TinAstArena* arena, size_t size)
+{
+    size_t header;
+    TinAstArenaBlock* block;
+    header = tin_astarena_round(sizeof(TinAstArenaBlock));
+    block = (TinAstArenaBlock*)malloc(header + size);
+    if(block == NULL)
+    {
+        tin_state_raiseerror(state, RUNTIME_ERROR, "internal error: failed to allocate %d bytes\n", (int)(header + size));
+        exit(111);
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    block->data = (uint8_t*)block + header;
+    arena->blockcount++;
+    arena->bytesreserved += size;
+    return block;
+}
+
+void* tin_astarena_alloc(TinState* state, size_t size)
+{
+    void* pointer;
+    TinAstArena* arena;
+    TinAstArenaBlock* block;
+    arena = state->astarena;
+    size = tin_astarena_round(size);
+    arena->allocations++;
+    arena->bytesused += size;
+    block = arena->head;
+    if(block == NULL || block->size - block->used < size)
+    {
+        /* a big request gets a block of its own, kept behind the current one so its tail isn't wasted */
+        if(block != NULL && size > TIN_AST_ARENABLOCKSIZE / 4)
+        {
+            block = tin_astarena_makeblock(state, arena, size);
+            block->next = arena->head->next;
+            arena->head->next = block;
+            block->used = size;
+            return block->data;
+        }
+        block = tin_astarena_makeblock(state, arena, size > TIN_AST_ARENABLOCKSIZE ? size : TIN_AST_ARENABLOCKSIZE);
+        block->next = arena->head;
+        arena->head = block;
+    }
+    pointer = block->data + block->used;
+    block->used += size;
+    arena->last = pointer;
+    return pointer;
+}
+
+/* like realloc; the most recent allocation grows in place if its block has room */
+void* tin_astarena_grow(TinState* state, void* pointer, size_t oldsize, size_t newsize)
+{
+    size_t offset;
+    void* fresh;
+    TinAstArena* arena;
+    TinAstArenaBlock* block;
+    arena = state->astarena;
+    block = arena->head;
+    if(pointer != NULL && pointer == arena->last)
+    {
+        offset = (size_t)((uint8_t*)pointer - block->data);
+        if(block->size - offset >= tin_astarena_round(newsize))
+        {
+            arena->bytesused += tin_astarena_round(newsize) - (block->used - offset);
+            block->used = offset + tin_astarena_round(newsize);
+            return pointer;
+        }
+    }
+    fresh = tin_astarena_alloc(state, newsize);
+    if(oldsize > 0)
+    {
+        memcpy(fresh, pointer, oldsize);
+    }
+    return fresh;
+}
+
 void tin_exprlist_init(TinAstExprList* array)
 {
     array->values = NULL;
@@ -13,12 +128,6 @@ void tin_exprlist_init(TinAstExprList* array)
     array->count = 0;
 }
 
-void tin_exprlist_destroy(TinState* state, TinAstExprList* array)
-{
-    tin_gcmem_freearray(state, sizeof(TinAstExpression*), array->values, array->capacity);
-    tin_exprlist_init(array);
-}
-
 void tin_exprlist_push(TinState* state, TinAstExprList* array, TinAstExpression* value)
 {
     size_t oldcapacity;
@@ -26,7 +135,7 @@ void tin_exprlist_push(TinState* state, TinAstExprList* array, TinAstExpression*
     {
         oldcapacity = array->capacity;
         array->capacity = TIN_CCAST_GROWCAPACITY(oldcapacity);
-        array->values = (TinAstExpression**)tin_gcmem_growarray(state, array->values, sizeof(TinAstExpression*), oldcapacity, array->capacity);
+        array->values = (TinAstExpression**)tin_astarena_grow(state, array->values, sizeof(TinAstExpression*) * oldcapacity, sizeof(TinAstExpression*) * array->capacity);
     }
     array->values[array->count] = value;
     array->count++;
@@ -50,312 +159,25 @@ void tin_paramlist_init(TinAstParamList* array)
     array->count = 0;
 }
 
-void tin_paramlist_destroy(TinState* state, TinAstParamList* array)
-{
-    tin_gcmem_freearray(state, sizeof(TinAstParameter), array->values, array->capacity);
-    tin_paramlist_init(array);
-}
-
 void tin_paramlist_push(TinState* state, TinAstParamList* array, TinAstParameter value)
 {
     if(array->capacity < array->count + 1)
     {
         size_t oldcapacity = array->capacity;
         array->capacity = TIN_CCAST_GROWCAPACITY(oldcapacity);
-        array->values = (TinAstParameter*)tin_gcmem_growarray(state, array->values, sizeof(TinAstParameter), oldcapacity, array->capacity);
+        array->values = (TinAstParameter*)tin_astarena_grow(state, array->values, sizeof(TinAstParameter) * oldcapacity, sizeof(TinAstParameter) * array->capacity);
     }
     array->values[array->count] = value;
     array->count++;
 }
 
-void tin_paramlist_destroyvalues(TinState* state, TinAstParamList* parameters)
-{
-    size_t i;
-    for(i = 0; i < parameters->count; i++)
-    {
-        tin_ast_destroyexpression(state, parameters->values[i].defaultexpr);
-    }
-    tin_paramlist_destroy(state, parameters);
-}
-
-void tin_ast_destroyexprlist(TinState* state, TinAstExprList* expressions)
-{
-    size_t i;
-    if(expressions == NULL)
-    {
-        return;
-    }
-    for(i = 0; i < expressions->count; i++)
-    {
-        tin_ast_destroyexpression(state, expressions->values[i]);
-    }
-    tin_exprlist_destroy(state, expressions);
-}
-
-void tin_ast_destroystmtlist(TinState* state, TinAstExprList* statements)
-{
-    size_t i;
-    if(statements == NULL)
-    {
-        return;
-    }
-    for(i = 0; i < statements->count; i++)
-    {
-        tin_ast_destroyexpression(state, statements->values[i]);
-    }
-    tin_exprlist_destroy(state, statements);
-}
-
-void tin_ast_destroyexpression(TinState* state, TinAstExpression* expr)
-{
-    if(expr == NULL)
-    {
-        return;
-    }
-    switch(expr->type)
-    {
-        case TINEXPR_LITERAL:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstLiteralExpr), 0);
-            }
-            break;
-        case TINEXPR_BINARY:
-            {
-                TinAstBinaryExpr* herex = (TinAstBinaryExpr*)expr;
-                if(!herex->ignoreleft)
-                {
-                    tin_ast_destroyexpression(state, herex->left);
-                }
-                tin_ast_destroyexpression(state, herex->right);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstBinaryExpr), 0);
-            }
-            break;
-
-        case TINEXPR_UNARY:
-            {
-                tin_ast_destroyexpression(state, ((TinAstUnaryExpr*)expr)->right);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstUnaryExpr), 0);
-            }
-            break;
-        case TINEXPR_VAREXPR:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstVarExpr), 0);
-            }
-            break;
-        case TINEXPR_ASSIGN:
-            {
-                TinAstAssignExpr* herex = (TinAstAssignExpr*)expr;
-                tin_ast_destroyexpression(state, herex->to);
-                tin_ast_destroyexpression(state, herex->value);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstAssignExpr), 0);
-            }
-            break;
-        case TINEXPR_CALL:
-            {
-                TinAstCallExpr* herex = (TinAstCallExpr*)expr;
-                tin_ast_destroyexpression(state, herex->callee);
-                tin_ast_destroyexpression(state, herex->init);
-                tin_ast_destroyexprlist(state, &herex->args);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstCallExpr), 0);
-            }
-            break;
-
-        case TINEXPR_GET:
-        {
-            tin_ast_destroyexpression(state, ((TinAstGetExpr*)expr)->where);
-            tin_gcmem_memrealloc(state, expr, sizeof(TinAstGetExpr), 0);
-            break;
-        }
-
-        case TINEXPR_SET:
-        {
-            TinAstSetExpr* herex = (TinAstSetExpr*)expr;
-
-            tin_ast_destroyexpression(state, herex->where);
-            tin_ast_destroyexpression(state, herex->value);
-
-            tin_gcmem_memrealloc(state, expr, sizeof(TinAstSetExpr), 0);
-            break;
-        }
-
-        case TINEXPR_LAMBDA:
-            {
-                TinAstFunctionExpr* herex = (TinAstFunctionExpr*)expr;
-                tin_paramlist_destroyvalues(state, &herex->parameters);
-                tin_ast_destroyexpression(state, herex->body);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstFunctionExpr), 0);
-            }
-            break;
-        case TINEXPR_ARRAY:
-            {
-                tin_ast_destroyexprlist(state, &((TinAstArrayExpr*)expr)->values);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstArrayExpr), 0);
-            }
-            break;
-        case TINEXPR_OBJECT:
-            {
-                TinAstObjectExpr* map = (TinAstObjectExpr*)expr;
-                tin_ast_destroyexprlist(state, &map->keys);
-                tin_ast_destroyexprlist(state, &map->values);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstObjectExpr), 0);
-            }
-            break;
-        case TINEXPR_SUBSCRIPT:
-            {
-                TinAstIndexExpr* herex = (TinAstIndexExpr*)expr;
-                tin_ast_destroyexpression(state, herex->array);
-                tin_ast_destroyexpression(state, herex->index);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstIndexExpr), 0);
-            }
-            break;
-        case TINEXPR_THIS:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstThisExpr), 0);
-            }
-            break;
-        case TINEXPR_SUPER:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstSuperExpr), 0);
-            }
-            break;
-        case TINEXPR_RANGE:
-            {
-                TinAstRangeExpr* herex = (TinAstRangeExpr*)expr;
-                tin_ast_destroyexpression(state, herex->from);
-                tin_ast_destroyexpression(state, herex->to);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstRangeExpr), 0);
-            }
-            break;
-        case TINEXPR_TERNARY:
-            {
-                TinAstTernaryExpr* herex = (TinAstTernaryExpr*)expr;
-                tin_ast_destroyexpression(state, herex->condition);
-                tin_ast_destroyexpression(state, herex->ifbranch);
-                tin_ast_destroyexpression(state, herex->elsebranch);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstTernaryExpr), 0);
-            }
-            break;
-        case TINEXPR_INTERPOLATION:
-            {
-                tin_ast_destroyexprlist(state, &((TinAstStrInterExpr*)expr)->expressions);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstStrInterExpr), 0);
-            }
-            break;
-        case TINEXPR_REFERENCE:
-            {
-                tin_ast_destroyexpression(state, ((TinAstRefExpr*)expr)->to);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstRefExpr), 0);
-            }
-            break;
-        case TINEXPR_EXPRESSION:
-            {
-                tin_ast_destroyexpression(state, ((TinAstExprExpr*)expr)->expression);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstExprExpr), 0);
-            }
-            break;
-        case TINEXPR_BLOCK:
-            {
-                tin_ast_destroystmtlist(state, &((TinAstBlockExpr*)expr)->statements);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstBlockExpr), 0);
-            }
-            break;
-        case TINEXPR_VARSTMT:
-            {
-                tin_ast_destroyexpression(state, ((TinAstAssignVarExpr*)expr)->init);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstAssignVarExpr), 0);
-            }
-            break;
-        case TINEXPR_IFSTMT:
-            {
-                TinAstIfExpr* stmt = (TinAstIfExpr*)expr;
-                tin_ast_destroyexpression(state, stmt->condition);
-                tin_ast_destroyexpression(state, stmt->ifbranch);
-                tin_ast_destroy_allocdexprlist(state, stmt->elseifconds);
-                tin_ast_destry_allocdstmtlist(state, stmt->elseifbranches);
-                tin_ast_destroyexpression(state, stmt->elsebranch);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstIfExpr), 0);
-            }
-            break;
-        case TINEXPR_WHILE:
-            {
-                TinAstWhileExpr* stmt = (TinAstWhileExpr*)expr;
-                tin_ast_destroyexpression(state, stmt->condition);
-                tin_ast_destroyexpression(state, stmt->body);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstWhileExpr), 0);
-            }
-            break;
-        case TINEXPR_FOR:
-            {
-                TinAstForExpr* stmt = (TinAstForExpr*)expr;
-                tin_ast_destroyexpression(state, stmt->increment);
-                tin_ast_destroyexpression(state, stmt->condition);
-                tin_ast_destroyexpression(state, stmt->init);
-
-                tin_ast_destroyexpression(state, stmt->var);
-                tin_ast_destroyexpression(state, stmt->body);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstForExpr), 0);
-            }
-            break;
-        case TINEXPR_CONTINUE:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstContinueExpr), 0);
-            }
-            break;
-        case TINEXPR_BREAK:
-            {
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstBreakExpr), 0);
-            }
-            break;
-        case TINEXPR_FUNCTION:
-            {
-                TinAstFunctionExpr* stmt = (TinAstFunctionExpr*)expr;
-                tin_ast_destroyexpression(state, stmt->body);
-                tin_paramlist_destroyvalues(state, &stmt->parameters);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstFunctionExpr), 0);
-            }
-            break;
-        case TINEXPR_RETURN:
-            {
-                tin_ast_destroyexpression(state, ((TinAstReturnExpr*)expr)->expression);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstReturnExpr), 0);
-            }
-            break;
-        case TINEXPR_METHOD:
-            {
-                TinAstMethodExpr* stmt = (TinAstMethodExpr*)expr;
-                tin_paramlist_destroyvalues(state, &stmt->parameters);
-                tin_ast_destroyexpression(state, stmt->body);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstMethodExpr), 0);
-            }
-            break;
-        case TINEXPR_CLASS:
-            {
-                tin_ast_destroystmtlist(state, &((TinAstClassExpr*)expr)->fields);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstClassExpr), 0);
-            }
-            break;
-        case TINEXPR_FIELD:
-            {
-                TinAstFieldExpr* stmt = (TinAstFieldExpr*)expr;
-                tin_ast_destroyexpression(state, stmt->getter);
-                tin_ast_destroyexpression(state, stmt->setter);
-                tin_gcmem_memrealloc(state, expr, sizeof(TinAstFieldExpr), 0);
-            }
-            break;
-        default:
-            {
-                tin_state_raiseerror(state, COMPILE_ERROR, "Unknown expression type %d", (int)expr->type);
-            }
-            break;
-    }
-}
-
 static TinAstExpression* tin_ast_allocexpr(TinState* state, uint64_t line, size_t size, TinAstExprType type)
 {
     TinAstExpression* object;
-    object = (TinAstExpression*)tin_gcmem_memrealloc(state, NULL, 0, size);
+    object = (TinAstExpression*)tin_astarena_alloc(state, size);
     object->type = type;
     object->line = line;
+    object->column = 0;
     return object;
 }
 
@@ -528,9 +350,10 @@ TinAstRefExpr* tin_ast_make_referenceexpr(TinState* state, size_t line, TinAstEx
 static TinAstExpression* tin_ast_allocstmt(TinState* state, uint64_t line, size_t size, TinAstExprType type)
 {
     TinAstExpression* object;
-    object = (TinAstExpression*)tin_gcmem_memrealloc(state, NULL, 0, size);
+    object = (TinAstExpression*)tin_astarena_alloc(state, size);
     object->type = type;
     object->line = line;
+    object->column = 0;
     return object;
 }
 
@@ -673,45 +496,15 @@ TinAstFieldExpr* tin_ast_make_fieldexpr(TinState* state, size_t line, TinString*
 TinAstExprList* tin_ast_allocexprlist(TinState* state)
 {
     TinAstExprList* expressions;
-    expressions = (TinAstExprList*)tin_gcmem_memrealloc(state, NULL, 0, sizeof(TinAstExprList));
+    expressions = (TinAstExprList*)tin_astarena_alloc(state, sizeof(TinAstExprList));
     tin_exprlist_init(expressions);
     return expressions;
 }
 
-void tin_ast_destroy_allocdexprlist(TinState* state, TinAstExprList* expressions)
-{
-    size_t i;
-    if(expressions == NULL)
-    {
-        return;
-    }
-    for(i = 0; i < expressions->count; i++)
-    {
-        tin_ast_destroyexpression(state, expressions->values[i]);
-    }
-    tin_exprlist_destroy(state, expressions);
-    tin_gcmem_memrealloc(state, expressions, sizeof(TinAstExprList), 0);
-}
-
 TinAstExprList* tin_ast_allocate_stmtlist(TinState* state)
 {
     TinAstExprList* statements;
-    statements = (TinAstExprList*)tin_gcmem_memrealloc(state, NULL, 0, sizeof(TinAstExprList));
+    statements = (TinAstExprList*)tin_astarena_alloc(state, sizeof(TinAstExprList));
     tin_exprlist_init(statements);
     return statements;
 }
-
-void tin_ast_destry_allocdstmtlist(TinState* state, TinAstExprList* statements)
-{
-    size_t i;
-    if(statements == NULL)
-    {
-        return;
-    }
-    for(i = 0; i < statements->count; i++)
-    {
-        tin_ast_destroyexpression(state, statements->values[i]);
-    }
-    tin_exprlist_destroy(state, statements);
-    tin_gcmem_memrealloc(state, statements, sizeof(TinAstExprList), 0);
-}
@@ -17,12 +17,6 @@ static inline void tin_uintlist_init(TinUintList* array)
     array->count = 0;
 }
 
-static inline void tin_uintlist_destroy(TinState* state, TinUintList* array)
-{
-    tin_gcmem_freearray(state, sizeof(size_t), array->values, array->capacity);
-    tin_uintlist_init(array);
-}
-
 static inline void tin_uintlist_push(TinState* state, TinUintList* array, size_t value)
 {
     size_t oldcapacity;
@@ -30,7 +24,7 @@ static inline void tin_uintlist_push(TinState* state, TinUintList* array, size_t
     {
         oldcapacity = array->capacity;
         array->capacity = TIN_CCEMIT_GROWCAPACITY(oldcapacity);
-        array->values = (size_t*)tin_gcmem_growarray(state, array->values, sizeof(size_t), oldcapacity, array->capacity);
+        array->values = (size_t*)tin_astarena_grow(state, array->values, sizeof(size_t) * oldcapacity, sizeof(size_t) * array->capacity);
     }
     array->values[array->count] = value;
     array->count++;
@@ -62,12 +56,6 @@ void tin_privlist_init(TinAstPrivList* array)
     array->count = 0;
 }
 
-void tin_privlist_destroy(TinState* state, TinAstPrivList* array)
-{
-    tin_gcmem_freearray(state, sizeof(TinAstPrivate), array->values, array->capacity);
-    tin_privlist_init(array);
-}
-
 void tin_privlist_push(TinState* state, TinAstPrivList* array, TinAstPrivate value)
 {
     size_t oldcapacity;
@@ -75,7 +63,7 @@ void tin_privlist_push(TinState* state, TinAstPrivList* array, TinAstPrivate val
     {
         oldcapacity = array->capacity;
         array->capacity = TIN_CCEMIT_GROWCAPACITY(oldcapacity);
-        array->values = (TinAstPrivate*)tin_gcmem_growarray(state, array->values, sizeof(TinAstPrivate), oldcapacity, array->capacity);
+        array->values = (TinAstPrivate*)tin_astarena_grow(state, array->values, sizeof(TinAstPrivate) * oldcapacity, sizeof(TinAstPrivate) * array->capacity);
     }
     array->values[array->count] = value;
     array->count++;
@@ -87,12 +75,6 @@ void tin_loclist_init(TinAstLocList* array)
     array->count = 0;
 }
 
-void tin_loclist_destroy(TinState* state, TinAstLocList* array)
-{
-    tin_gcmem_freearray(state, sizeof(TinAstLocal), array->values, array->capacity);
-    tin_loclist_init(array);
-}
-
 void tin_loclist_push(TinState* state, TinAstLocList* array, TinAstLocal value)
 {
     size_t oldcapacity;
@@ -100,7 +82,7 @@ void tin_loclist_push(TinState* state, TinAstLocList* array, TinAstLocal value)
     {
         oldcapacity = array->capacity;
         array->capacity = TIN_CCEMIT_GROWCAPACITY(oldcapacity);
-        array->values = (TinAstLocal*)tin_gcmem_growarray(state, array->values, sizeof(TinAstLocal), oldcapacity, array->capacity);
+        array->values = (TinAstLocal*)tin_astarena_grow(state, array->values, sizeof(TinAstLocal) * oldcapacity, sizeof(TinAstLocal) * array->capacity);
     }
     array->values[array->count] = value;
     array->count++;
@@ -118,6 +100,7 @@ void tin_astemit_init(TinState* state, TinAstEmitter* emt)
 {
     emt->state = state;
     emt->loopstart = 0;
+    emt->column = 0;
     emt->emitref = 0;
     emt->classname = NULL;
     emt->compiler = NULL;
@@ -130,20 +113,22 @@ void tin_astemit_init(TinState* state, TinAstEmitter* emt)
     tin_uintlist_init(&emt->continues);
 }
 
+/* the lists live in the arena of the last compilation, which is gone by now */
 void tin_astemit_destroy(TinAstEmitter* emt)
 {
-    tin_uintlist_destroy(emt->state, &emt->breaks);
-    tin_uintlist_destroy(emt->state, &emt->continues);
+    tin_privlist_init(&emt->privates);
+    tin_uintlist_init(&emt->breaks);
+    tin_uintlist_init(&emt->continues);
 }
 
-static void tin_astemit_emit1byte(TinAstEmitter* emt, uint16_t line, uint8_t byte)
+static void tin_astemit_emit1byte(TinAstEmitter* emt, size_t line, uint8_t byte)
 {
     if(line < emt->lastline)
     {
         // Egor-fail proofing
         line = emt->lastline;
     }
-    tin_chunk_push(emt->state, emt->chunk, byte, line);
+    tin_chunk_push(emt->state, emt->chunk, byte, line, emt->column);
     emt->lastline = line;
 }
 
@@ -227,21 +212,41 @@ static const int8_t stack_effects[] =
     /* OP_REFUPVAL */ 1,
     /* OP_REFFIELD */ -1,
     /* OP_REFSET */ -1,
+    /* OP_TAILCALL */ 0,
+    /* OP_LOCALSETPOP */ -1,
+    /* OP_LOCALLOCALARITH */ 1,
+    /* OP_LOCALCONSTARITH */ 1,
+    /* OP_LOCALLOCALBRANCH */ 0,
+    /* OP_LOCALCONSTBRANCH */ 0,
+    /* OP_LOCALINCR */ 0,
+    /* OP_MATHADDINT */ -1,
+    /* OP_MATHADDFLOAT */ -1,
+    /* OP_MATHSUBINT */ -1,
+    /* OP_MATHSUBFLOAT */ -1,
+    /* OP_MATHMULTINT */ -1,
+    /* OP_MATHMULTFLOAT */ -1,
+    /* OP_LESSTHANINT */ -1,
+    /* OP_LESSTHANFLOAT */ -1,
+    /* OP_GREATERTHANINT */ -1,
+    /* OP_GREATERTHANFLOAT */ -1,
+    /* OP_GETINDEXARRAY */ -1,
+    /* OP_FIELDGETSLOT */ -1,
+    /* OP_GETINDEXTYPED */ -1,
 };
 
-static void tin_astemit_emit2bytes(TinAstEmitter* emt, uint16_t line, uint8_t a, uint8_t b)
+static void tin_astemit_emit2bytes(TinAstEmitter* emt, size_t line, uint8_t a, uint8_t b)
 {
     if(line < emt->lastline)
     {
         // Egor-fail proofing
         line = emt->lastline;
     }
-    tin_chunk_push(emt->state, emt->chunk, a, line);
-    tin_chunk_push(emt->state, emt->chunk, b, line);
+    tin_chunk_push(emt->state, emt->chunk, a, line, emt->column);
+    tin_chunk_push(emt->state, emt->chunk, b, line, emt->column);
     emt->lastline = line;
 }
 
-static void tin_astemit_emit1op(TinAstEmitter* emt, uint16_t line, TinOpCode op)
+static void tin_astemit_emit1op(TinAstEmitter* emt, size_t line, TinOpCode op)
 {
     TinAstCompiler* compiler;
     compiler = emt->compiler;
@@ -253,7 +258,7 @@ static void tin_astemit_emit1op(TinAstEmitter* emt, uint16_t line, TinOpCode op)
     }
 }
 
-static void tin_astemit_emit2ops(TinAstEmitter* emt, uint16_t line, TinOpCode a, TinOpCode b)
+static void tin_astemit_emit2ops(TinAstEmitter* emt, size_t line, TinOpCode a, TinOpCode b)
 {
     TinAstCompiler* compiler;
     compiler = emt->compiler;
@@ -265,7 +270,7 @@ static void tin_astemit_emit2ops(TinAstEmitter* emt, uint16_t line, TinOpCode a,
     }
 }
 
-static void tin_astemit_emitvaryingop(TinAstEmitter* emt, uint16_t line, TinOpCode op, uint8_t arg)
+static void tin_astemit_emitvaryingop(TinAstEmitter* emt, size_t line, TinOpCode op, uint8_t arg)
 {
     TinAstCompiler* compiler;
     compiler = emt->compiler;
@@ -277,7 +282,7 @@ static void tin_astemit_emitvaryingop(TinAstEmitter* emt, uint16_t line, TinOpCo
     }
 }
 
-static void tin_astemit_emitargedop(TinAstEmitter* emt, uint16_t line, TinOpCode op, uint8_t arg)
+static void tin_astemit_emitargedop(TinAstEmitter* emt, size_t line, TinOpCode op, uint8_t arg)
 {
     TinAstCompiler* compiler;
     compiler = emt->compiler;
@@ -289,12 +294,12 @@ static void tin_astemit_emitargedop(TinAstEmitter* emt, uint16_t line, TinOpCode
     }
 }
 
-static void tin_astemit_emitshort(TinAstEmitter* emt, uint16_t line, uint16_t value)
+static void tin_astemit_emitshort(TinAstEmitter* emt, size_t line, uint16_t value)
 {
     tin_astemit_emit2bytes(emt, line, (uint8_t)((value >> 8) & 0xff), (uint8_t)(value & 0xff));
 }
 
-static void tin_astemit_emitbyteorshort(TinAstEmitter* emt, uint16_t line, uint8_t a, uint8_t b, uint16_t index)
+static void tin_astemit_emitbyteorshort(TinAstEmitter* emt, size_t line, uint8_t a, uint8_t b, uint16_t index)
 {
     if(index > UINT8_MAX)
     {
@@ -378,7 +383,7 @@ static TinFunction* tin_compiler_end(TinAstEmitter* emt, TinString* name)
         emt->compiler->skipreturn = true;
     }
     function = emt->compiler->function;
-    tin_loclist_destroy(emt->state, &emt->compiler->locals);
+    tin_chunk_freeconstindex(emt->state, &function->chunk);
     emt->compiler = (TinAstCompiler*)emt->compiler->enclosing;
     emt->chunk = emt->compiler == NULL ? NULL : &emt->compiler->function->chunk;
     if(name != NULL)
@@ -386,7 +391,7 @@ static TinFunction* tin_compiler_end(TinAstEmitter* emt, TinString* name)
         function->name = name;
     }
 #ifdef TIN_TRACE_CHUNK
-    tin_disassemble_chunk(&function->chunk, function->name->data, NULL);
+    tin_disassemble_chunk(emt->state, &function->chunk, function->name->data, NULL);
 #endif
     return function;
 }
@@ -396,7 +401,7 @@ static void tin_astemit_beginscope(TinAstEmitter* emt)
     emt->compiler->scopedepth++;
 }
 
-static void tin_astemit_endscope(TinAstEmitter* emt, uint16_t line)
+static void tin_astemit_endscope(TinAstEmitter* emt, size_t line)
 {
     TinAstLocList* locals;
     TinAstCompiler* compiler;
@@ -428,6 +433,17 @@ static uint16_t tin_astemit_addconstant(TinAstEmitter* emt, size_t line, TinValu
     return constant;
 }
 
+/* emits the inline cache slot operand of OP_FIELDGET, OP_FIELDSET and OP_INVOKE* */
+static void tin_astemit_emitcacheslot(TinAstEmitter* emt, size_t line)
+{
+    if(emt->chunk->icachecount >= UINT16_MAX)
+    {
+        tin_astemit_raiseerror(emt, line, "too many field accesses for one chunk");
+        return;
+    }
+    tin_astemit_emitshort(emt, line, tin_chunk_addcache(emt->state, emt->chunk));
+}
+
 static size_t tin_astemit_emitconstant(TinAstEmitter* emt, size_t line, TinValue value)
 {
     size_t constant;
@@ -652,7 +668,7 @@ static void tin_astemit_patchloopjumps(TinAstEmitter* emt, TinUintList* breaks,
     {
         tin_astemit_patchjump(emt, tin_uintlist_get(breaks, i), line);
     }
-    tin_uintlist_destroy(emt->state, breaks);
+    tin_uintlist_init(breaks);
 }
 
 static bool tin_astemit_emitparamlist(TinAstEmitter* emt, TinAstParamList* parameters, size_t line)
@@ -1036,7 +1052,9 @@ static bool tin_astemit_doemitassign(TinAstEmitter* emt, TinAstExpression* expr)
         tin_astemit_emitexpression(emt, getexpr->where);
         tin_astemit_emitexpression(emt, assignexpr->value);
         tin_astemit_emitconstant(emt, emt->lastline, tin_value_fromobject(tin_string_copy(emt->state, getexpr->name, getexpr->length)));
-        tin_astemit_emit2ops(emt, emt->lastline, OP_FIELDSET, OP_POP);
+        tin_astemit_emit1op(emt, emt->lastline, OP_FIELDSET);
+        tin_astemit_emitcacheslot(emt, emt->lastline);
+        tin_astemit_emit1op(emt, emt->lastline, OP_POP);
     }
     else if(assignexpr->to->type == TINEXPR_SUBSCRIPT)
     {
@@ -1118,6 +1136,7 @@ static bool tin_astemit_doemitcall(TinAstEmitter* emt, TinAstExpression* expr)
             tin_astemit_emitshort(emt, emt->lastline,
                        tin_astemit_addconstant(emt, emt->lastline,
                                     tin_value_fromobject(tin_string_copy(emt->state, getexpr->name, getexpr->length))));
+            tin_astemit_emitcacheslot(emt, emt->lastline);
         }
         else
         {
@@ -1197,6 +1216,10 @@ static bool tin_astemit_doemitget(TinAstEmitter* emt, TinAstExpression* expr)
             tin_astemit_emitconstant(emt, emt->lastline,
                           tin_value_fromobject(tin_string_copy(emt->state, getexpr->name, getexpr->length)));
             tin_astemit_emit1op(emt, emt->lastline, ref ? OP_REFFIELD : OP_FIELDGET);
+            if(!ref)
+            {
+                tin_astemit_emitcacheslot(emt, emt->lastline);
+            }
         }
         tin_astemit_patchjump(emt, getexpr->jump, emt->lastline);
     }
@@ -1204,6 +1227,10 @@ static bool tin_astemit_doemitget(TinAstEmitter* emt, TinAstExpression* expr)
     {
         tin_astemit_emitconstant(emt, emt->lastline, tin_value_fromobject(tin_string_copy(emt->state, getexpr->name, getexpr->length)));
         tin_astemit_emit1op(emt, emt->lastline, ref ? OP_REFFIELD : OP_FIELDGET);
+        if(!ref)
+        {
+            tin_astemit_emitcacheslot(emt, emt->lastline);
+        }
     }
     return true;
 }
@@ -1216,6 +1243,7 @@ static bool tin_astemit_doemitset(TinAstEmitter* emt, TinAstExpression* expr)
     tin_astemit_emitexpression(emt, setexpr->value);
     tin_astemit_emitconstant(emt, emt->lastline, tin_value_fromobject(tin_string_copy(emt->state, setexpr->name, setexpr->length)));
     tin_astemit_emit1op(emt, emt->lastline, OP_FIELDSET);
+    tin_astemit_emitcacheslot(emt, emt->lastline);
     return true;
 }
 
@@ -1381,6 +1409,7 @@ static bool tin_astemit_doemitinterpolation(TinAstEmitter* emt, TinAstExpression
     tin_astemit_emitvaryingop(emt, emt->lastline, OP_INVOKEMETHOD, 0);
     tin_astemit_emitshort(emt, emt->lastline,
                tin_astemit_addconstant(emt, emt->lastline, tin_value_makestring(emt->state, "join")));
+    tin_astemit_emitcacheslot(emt, emt->lastline);
     return true;
 }
 
@@ -1469,7 +1498,7 @@ static bool tin_astemit_doemitifstmt(TinAstEmitter* emt, TinAstExpression* expr)
     }
     /* important: endjumps must be N*sizeof(uint64_t) - merely allocating N isn't enough! */
     //uint64_t endjumps[ifstmt->elseifbranches == NULL ? 1 : ifstmt->elseifbranches->count];
-    endjumps = (uint64_t*)malloc(sizeof(uint64_t) * (ifstmt->elseifbranches == NULL ? 1 : ifstmt->elseifbranches->count));
+    endjumps = (uint64_t*)tin_astarena_alloc(emt->state, sizeof(uint64_t) * (ifstmt->elseifbranches == NULL ? 1 : ifstmt->elseifbranches->count));
     if(ifstmt->elseifbranches != NULL)
     {
         for(i = 0; i < ifstmt->elseifbranches->count; i++)
@@ -1510,7 +1539,6 @@ static bool tin_astemit_doemitifstmt(TinAstEmitter* emt, TinAstExpression* expr)
             tin_astemit_patchjump(emt, endjumps[i], ifstmt->elseifbranches->values[i]->line);
         }
     }
-    free(endjumps);
     return true;
 }
 
@@ -1647,7 +1675,8 @@ static bool tin_astemit_doemitforstmt(TinAstEmitter* emt, TinAstExpression* expr
         tin_astemit_emitbyteorshort(emt, emt->lastline, OP_LOCALGET, OP_LOCALLONGGET, iterator);
         tin_astemit_emitvaryingop(emt, emt->lastline, OP_INVOKEMETHOD, 1);
         tin_astemit_emitshort(emt, emt->lastline,
-                   tin_astemit_addconstant(emt, emt->lastline, tin_value_makestring(emt->state, "iterator")));
+                   tin_astemit_addconstant(emt, emt->lastline, tin_value_fromobject(emt->state->symbols[TINSYM_ITERATOR])));
+        tin_astemit_emitcacheslot(emt, emt->lastline);
         tin_astemit_emitbyteorshort(emt, emt->lastline, OP_LOCALSET, OP_LOCALLONGSET, iterator);
         // If iter is null, just get out of the loop
         exitjump = tin_astemit_emitjump(emt, OP_JUMPIFNULLPOP, emt->lastline);
@@ -1660,7 +1689,8 @@ static bool tin_astemit_doemitforstmt(TinAstEmitter* emt, TinAstExpression* expr
         tin_astemit_emitbyteorshort(emt, emt->lastline, OP_LOCALGET, OP_LOCALLONGGET, iterator);
         tin_astemit_emitvaryingop(emt, emt->lastline, OP_INVOKEMETHOD, 1);
         tin_astemit_emitshort(emt, emt->lastline,
-                   tin_astemit_addconstant(emt, emt->lastline, tin_value_makestring(emt->state, "iteratorValue")));
+                   tin_astemit_addconstant(emt, emt->lastline, tin_value_fromobject(emt->state->symbols[TINSYM_ITERATORVALUE])));
+        tin_astemit_emitcacheslot(emt, emt->lastline);
         tin_astemit_emitbyteorshort(emt, emt->lastline, OP_LOCALSET, OP_LOCALLONGSET, localcnt);
         if(forstmt->body != NULL)
         {
@@ -1731,6 +1761,30 @@ static bool tin_astemit_doemitcontinue(TinAstEmitter* emt, TinAstExpression* exp
     return true;
 }
 
+/*
+* a call of a plain function (no method, super or object initializer) ends with OP_CALLFUNCTION argc name;
+* if it is returned right away, it becomes a tail call. module level returns are left alone.
+*/
+static void tin_astemit_marktailcall(TinAstEmitter* emt, TinAstExpression* subexpr)
+{
+    size_t offset;
+    TinAstCallExpr* callexpr;
+    if(subexpr->type != TINEXPR_CALL || emt->compiler->type == TINFUNC_SCRIPT || emt->chunk->count < 4)
+    {
+        return;
+    }
+    callexpr = (TinAstCallExpr*)subexpr;
+    if(callexpr->callee->type == TINEXPR_GET || callexpr->callee->type == TINEXPR_SUPER || callexpr->init != NULL)
+    {
+        return;
+    }
+    offset = emt->chunk->count - 4;
+    if(emt->chunk->code[offset] == OP_CALLFUNCTION)
+    {
+        emt->chunk->code[offset] = OP_TAILCALL;
+    }
+}
+
 static bool tin_astemit_doemitreturn(TinAstEmitter* emt, TinAstExpression* expr)
 {
     TinAstExpression* subexpr;
@@ -1747,6 +1801,7 @@ static bool tin_astemit_doemitreturn(TinAstEmitter* emt, TinAstExpression* expr)
     else
     {
         tin_astemit_emitexpression(emt, subexpr);
+        tin_astemit_marktailcall(emt, subexpr);
     }
     tin_astemit_emit1op(emt, emt->lastline, OP_RETURN);
     if(emt->compiler->scopedepth == 0)
@@ -1835,7 +1890,7 @@ static bool tin_astemit_doemitmethod(TinAstEmitter* emt, TinAstExpression* expr)
     TinFunction* function;
     TinAstMethodExpr* mthstmt;
     mthstmt = (TinAstMethodExpr*)expr;
-    constructor = memcmp(mthstmt->name->data, TIN_VALUE_CTORNAME, strlen(TIN_VALUE_CTORNAME)) == 0;
+    constructor = (mthstmt->name == emt->state->symbols[TINSYM_CONSTRUCTOR]);
     if(constructor && mthstmt->isstatic)
     {
         tin_astemit_raiseerror(emt, expr->line, "constructors cannot be static (at least for now)");
@@ -1994,12 +2049,8 @@ static bool tin_astemit_doemitexpression(TinAstEmitter* emt, TinAstExpression* e
     return true;
 }
 
-static bool tin_astemit_emitexpression(TinAstEmitter* emt, TinAstExpression* expr)
+static bool tin_astemit_dispatchexpression(TinAstEmitter* emt, TinAstExpression* expr)
 {
-    if(expr == NULL)
-    {
-        return false;
-    }
     switch(expr->type)
     {
         case TINEXPR_LITERAL:
@@ -2261,6 +2312,25 @@ static bool tin_astemit_emitexpression(TinAstEmitter* emt, TinAstExpression* exp
     return false;
 }
 
+/* the code of $expr is tagged with its column, and the code around it with that of the enclosing expression */
+static bool tin_astemit_emitexpression(TinAstEmitter* emt, TinAstExpression* expr)
+{
+    bool result;
+    size_t column;
+    if(expr == NULL)
+    {
+        return false;
+    }
+    column = emt->column;
+    if(expr->column != 0)
+    {
+        emt->column = expr->column;
+    }
+    result = tin_astemit_dispatchexpression(emt, expr);
+    emt->column = column;
+    return result;
+}
+
 TinModule* tin_astemit_modemit(TinAstEmitter* emt, TinAstExprList* statements, TinString* module_name)
 {
     size_t i;
@@ -2328,7 +2398,10 @@ TinModule* tin_astemit_modemit(TinAstEmitter* emt, TinAstExprList* statements, T
             module->privates[i] = tin_value_makenull(emt->state);
         }
     }
-    tin_privlist_destroy(emt->state, &emt->privates);
+    /* these point into the arena, which is released once the module is done */
+    tin_privlist_init(&emt->privates);
+    tin_uintlist_init(&emt->breaks);
+    tin_uintlist_init(&emt->continues);
     if(tin_astopt_isoptenabled(TINOPTSTATE_PRIVATENAMES))
     {
         tin_table_destroy(emt->state, &emt->module->privnames->values);
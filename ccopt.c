@@ -45,7 +45,8 @@ static const char* optimization_level_descriptions[TINOPTLEVEL_TOTAL]
 
 static const char* optimization_names[TINOPTSTATE_TOTAL]
 = { "constant-folding", "literal-folding", "unused-var",    "unreachable-code",
-    "empty-body",       "line-info",       "private-names", "c-for" };
+    "empty-body",       "line-info",       "private-names", "c-for",
+    "superinstructions" };
 
 static const char* optimization_descriptions[TINOPTSTATE_TOTAL]
 = { "Replaces constants in code with their values.",
@@ -55,7 +56,8 @@ static const char* optimization_descriptions[TINOPTSTATE_TOTAL]
     "Removes loops with empty bodies.",
     "Removes line information from chunks to save on space.",
     "Removes names of the private locals from modules (they are indexed by id at runtime).",
-    "Replaces for-in loops with c-style for loops where it can." };
+    "Replaces for-in loops with c-style for loops where it can.",
+    "Fuses common instruction sequences into single instructions." };
 
 static bool optimization_states[TINOPTSTATE_TOTAL];
 
@@ -130,7 +132,6 @@ static void tin_astopt_endscope(TinAstOptimizer* optimizer)
         if(remove_unused && !variables->values[variables->count - 1].used)
         {
             variable = &variables->values[variables->count - 1];
-            tin_ast_destroyexpression(optimizer->state, *variable->declaration);
             *variable->declaration = NULL;
         }
         variables->count--;
@@ -336,7 +337,6 @@ static TinValue tin_astopt_attemptoptbinary(TinAstOptimizer* optimizer, TinAstBi
             else if(number == 1)
             {
                 tin_astopt_optdbg("reducing expression to literal '1'");
-                tin_ast_destroyexpression(optimizer->state, left ? expression->right : expression->left);
                 expression->left = branch;
                 expression->right = NULL;
             }
@@ -344,14 +344,12 @@ static TinValue tin_astopt_attemptoptbinary(TinAstOptimizer* optimizer, TinAstBi
         else if((op == TINTOK_PLUS || op == TINTOK_MINUS) && number == 0)
         {
             tin_astopt_optdbg("reducing expression that would result in '0' to literal '0'");
-            tin_ast_destroyexpression(optimizer->state, left ? expression->right : expression->left);
             expression->left = branch;
             expression->right = NULL;
         }
         else if(((left && op == TINTOK_SLASH) || op == TINTOK_DOUBLESTAR) && number == 1)
         {
             tin_astopt_optdbg("reducing expression that would result in '1' to literal '1'");
-            tin_ast_destroyexpression(optimizer->state, left ? expression->right : expression->left);
             expression->left = branch;
             expression->right = NULL;
         }
@@ -438,7 +436,6 @@ static void tin_astopt_optforstmt(TinState* state, TinAstOptimizer* optimizer, T
     tin_astopt_endscope(optimizer);
     if(tin_astopt_isoptenabled(TINOPTSTATE_EMPTYBODY) && tin_astopt_isemptyexpr(stmt->body))
     {
-        tin_ast_destroyexpression(optimizer->state, expression);
         *slot = NULL;
         return;
     }
@@ -470,10 +467,7 @@ static void tin_astopt_optforstmt(TinState* state, TinAstOptimizer* optimizer, T
     TinAstExpression* increment
     = (TinAstExpression*)tin_ast_make_assignexpr(state, line, var_get, (TinAstExpression*)assign_value);
     stmt->increment = (TinAstExpression*)increment;
-    range->from = NULL;
-    range->to = NULL;
     stmt->cstyle = true;
-    tin_ast_destroyexpression(state, (TinAstExpression*)range);
 }
 
 static void tin_astopt_optwhilestmt(TinState* state, TinAstOptimizer* optimizer, TinAstExpression* expression, TinAstExpression** slot)
@@ -488,7 +482,6 @@ static void tin_astopt_optwhilestmt(TinState* state, TinAstOptimizer* optimizer,
         optimized = tin_astopt_evalexpr(optimizer, stmt->condition);
         if(!tin_value_isnull(optimized) && tin_value_isfalsey(optimized))
         {
-            tin_ast_destroyexpression(optimizer->state, expression);
             *slot = NULL;
             return;
         }
@@ -496,7 +489,6 @@ static void tin_astopt_optwhilestmt(TinState* state, TinAstOptimizer* optimizer,
     tin_astopt_optexpression(optimizer, &stmt->body);
     if(tin_astopt_isoptenabled(TINOPTSTATE_EMPTYBODY) && tin_astopt_isemptyexpr(stmt->body))
     {
-        tin_ast_destroyexpression(optimizer->state, expression);
         *slot = NULL;
     }
 }
@@ -519,9 +511,7 @@ static void tin_astopt_optifstmt(TinState* state, TinAstOptimizer* optimizer, Ti
     optimized = empty ? tin_astopt_evalexpr(optimizer, stmt->condition) : tin_value_makenull(optimizer->state);
     if((!tin_value_isnull(optimized) && tin_value_isfalsey(optimized)) || (dead && tin_astopt_isemptyexpr(stmt->ifbranch)))
     {
-        tin_ast_destroyexpression(state, stmt->condition);
         stmt->condition = NULL;
-        tin_ast_destroyexpression(state, stmt->ifbranch);
         stmt->ifbranch = NULL;
     }
     if(stmt->elseifconds != NULL)
@@ -534,9 +524,7 @@ static void tin_astopt_optifstmt(TinState* state, TinAstOptimizer* optimizer, Ti
             {
                 if(empty && tin_astopt_isemptyexpr(stmt->elseifbranches->values[i]))
                 {
-                    tin_ast_destroyexpression(state, stmt->elseifconds->values[i]);
                     stmt->elseifconds->values[i] = NULL;
-                    tin_ast_destroyexpression(state, stmt->elseifbranches->values[i]);
                     stmt->elseifbranches->values[i] = NULL;
                     continue;
                 }
@@ -545,9 +533,7 @@ static void tin_astopt_optifstmt(TinState* state, TinAstOptimizer* optimizer, Ti
                     value = tin_astopt_evalexpr(optimizer, stmt->elseifconds->values[i]);
                     if(!tin_value_isnull(value) && tin_value_isfalsey(value))
                     {
-                        tin_ast_destroyexpression(state, stmt->elseifconds->values[i]);
                         stmt->elseifconds->values[i] = NULL;
-                        tin_ast_destroyexpression(state, stmt->elseifbranches->values[i]);
                         stmt->elseifbranches->values[i] = NULL;
                     }
                 }
@@ -568,7 +554,6 @@ static void tin_astopt_optblockstmt(TinState* state, TinAstOptimizer* optimizer,
     stmt = (TinAstBlockExpr*)expression;
     if(stmt->statements.count == 0)
     {
-        tin_ast_destroyexpression(state, expression);
         *slot = NULL;
         return;
     }
@@ -590,7 +575,6 @@ static void tin_astopt_optblockstmt(TinState* state, TinAstOptimizer* optimizer,
                     step = stmt->statements.values[j];
                     if(step != NULL)
                     {
-                        tin_ast_destroyexpression(state, step);
                         stmt->statements.values[j] = NULL;
                     }
                 }
@@ -601,7 +585,6 @@ static void tin_astopt_optblockstmt(TinState* state, TinAstOptimizer* optimizer,
     }
     if(!found && tin_astopt_isoptenabled(TINOPTSTATE_EMPTYBODY))
     {
-        tin_ast_destroyexpression(optimizer->state, expression);
         *slot = NULL;
     }
 }
@@ -652,7 +635,6 @@ static void tin_astopt_optexpression(TinAstOptimizer* optimizer, TinAstExpressio
                     if(!tin_value_isnull(optimized))
                     {
                         *slot = (TinAstExpression*)tin_ast_make_literalexpr(state, expression->line, optimized);
-                        tin_ast_destroyexpression(state, expression);
                         break;
                     }
                 }
@@ -744,16 +726,13 @@ static void tin_astopt_optexpression(TinAstOptimizer* optimizer, TinAstExpressio
                     if(tin_value_isfalsey(optimized))
                     {
                         *slot = expr->elsebranch;
-                        expr->elsebranch = NULL;// So that it doesn't get freed
                     }
                     else
                     {
                         *slot = expr->ifbranch;
-                        expr->ifbranch = NULL;// So that it doesn't get freed
                     }
 
                     tin_astopt_optexpression(optimizer, slot);
-                    tin_ast_destroyexpression(state, expression);
                 }
                 else
                 {
@@ -780,7 +759,6 @@ static void tin_astopt_optexpression(TinAstOptimizer* optimizer, TinAstExpressio
                     if(variable->constant && !tin_value_isnull(variable->constvalue))
                     {
                         *slot = (TinAstExpression*)tin_ast_make_literalexpr(state, expression->line, variable->constvalue);
-                        tin_ast_destroyexpression(state, expression);
                     }
                 }
             }
@@ -907,6 +885,114 @@ void tin_astopt_optast(TinAstOptimizer* optimizer, TinAstExprList* statements)
     tin_varlist_destroy(optimizer->state, &optimizer->variables);
 }
 
+/*
+* bytecode peephole pass, run over every function of a module once it has been emitted.
+*
+* a superinstruction only replaces the first opcode of the sequence it stands for; its operands and the
+* instructions after it stay where they are. so code size, jump offsets and line info don't change, a jump
+* into the middle of a fused sequence still runs the original instructions, and the vm can fall back to
+* the first instruction of a sequence (and go on with the second) whenever the fast path doesn't apply.
+*/
+static bool tin_astopt_isfusablearith(uint8_t op)
+{
+    switch(op)
+    {
+        case OP_MATHADD:
+        case OP_MATHSUB:
+        case OP_MATHMULT:
+        case OP_MATHPOWER:
+        case OP_MATHDIV:
+        case OP_MATHMOD:
+        case OP_BINAND:
+        case OP_BINOR:
+        case OP_BINXOR:
+        case OP_LEFTSHIFT:
+        case OP_RIGHTSHIFT:
+        case OP_EQUAL:
+        case OP_GREATERTHAN:
+        case OP_GREATEREQUAL:
+        case OP_LESSTHAN:
+        case OP_LESSEQUAL:
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+static bool tin_astopt_iscomparison(uint8_t op)
+{
+    return op == OP_EQUAL || op == OP_GREATERTHAN || op == OP_GREATEREQUAL || op == OP_LESSTHAN || op == OP_LESSEQUAL;
+}
+
+/* fuses the sequence starting at $offset, if there is one; returns its length, or 0 */
+static size_t tin_astopt_fuseat(TinChunk* chunk, size_t offset)
+{
+    uint8_t* code;
+    size_t left;
+    code = &chunk->code[offset];
+    left = chunk->count - offset;
+    if(code[0] == OP_LOCALSET && left >= 3 && code[2] == OP_POP)
+    {
+        code[0] = OP_LOCALSETPOP;
+        return 3;
+    }
+    if(code[0] != OP_LOCALGET || left < 5 || (code[2] != OP_LOCALGET && code[2] != OP_CONSTVALUE))
+    {
+        return 0;
+    }
+    /* local = local +/- constant, i.e. "i++", "i += 1", "i = i - 2" */
+    if(left >= 8 && code[2] == OP_CONSTVALUE && (code[4] == OP_MATHADD || code[4] == OP_MATHSUB)
+    && code[5] == OP_LOCALSET && code[6] == code[1] && code[7] == OP_POP)
+    {
+        code[0] = OP_LOCALINCR;
+        return 8;
+    }
+    if(left >= 8 && tin_astopt_iscomparison(code[4]) && code[5] == OP_JUMPIFFALSE)
+    {
+        code[0] = (code[2] == OP_LOCALGET) ? OP_LOCALLOCALBRANCH : OP_LOCALCONSTBRANCH;
+        return 8;
+    }
+    if(tin_astopt_isfusablearith(code[4]))
+    {
+        code[0] = (code[2] == OP_LOCALGET) ? OP_LOCALLOCALARITH : OP_LOCALCONSTARITH;
+        return 5;
+    }
+    return 0;
+}
+
+static void tin_astopt_optchunk(TinChunk* chunk)
+{
+    size_t i;
+    size_t offset;
+    size_t fused;
+    TinValue value;
+    for(i = 0; i < tin_vallist_count(&chunk->constants); i++)
+    {
+        value = tin_vallist_get(&chunk->constants, i);
+        if(tin_value_isfunction(value))
+        {
+            tin_astopt_optchunk(&tin_value_asfunction(value)->chunk);
+        }
+    }
+    offset = 0;
+    while(offset < chunk->count)
+    {
+        fused = tin_astopt_fuseat(chunk, offset);
+        offset += (fused > 0) ? fused : tin_chunk_oplength(chunk, offset);
+    }
+}
+
+void tin_astopt_optbytecode(TinState* state, TinModule* module)
+{
+    (void)state;
+    if(!tin_astopt_isoptenabled(TINOPTSTATE_SUPERINSTRUCTIONS))
+    {
+        return;
+    }
+    tin_astopt_optchunk(&module->mainfunction->chunk);
+}
+
 static void tin_astopt_setupstates()
 {
     tin_astopt_setoptlevel(TINOPTLEVEL_DEBUG);
@@ -1,5 +1,6 @@
 
 #include <stdlib.h>
+#include <string.h>
 #include <setjmp.h>
 #include "priv.h"
 
@@ -411,11 +412,21 @@ static TinAstExpression* tin_astparser_parseblock(TinAstParser* prs)
     return (TinAstExpression*)statement;
 }
 
+/* expressions get the column of the token they start with (infix ones that of their operator), unless they have one already */
+static void tin_astparser_setcolumn(TinAstExpression* expr, size_t column)
+{
+    if(expr != NULL && expr->column == 0)
+    {
+        expr->column = column;
+    }
+}
+
 static TinAstExpression* tin_astparser_parseprecedence(TinAstParser* prs, TinAstPrecedence precedence, bool err, bool ignsemi)
 {
     bool expisnewline;
     bool gotisnewline;
     bool canassign;
+    size_t column;
     size_t explen;
     size_t gotlen;
     size_t nllen;
@@ -447,14 +458,18 @@ static TinAstExpression* tin_astparser_parseprecedence(TinAstParser* prs, TinAst
         }
     }
     canassign = precedence <= TINPREC_ASSIGNMENT;
+    column = prs->previous.column;
     expr = prefixrule(prs, canassign);
+    tin_astparser_setcolumn(expr, column);
     tin_astparser_ignorenewlines(prs, ignsemi);
     while(precedence <= tin_astparser_getrule(prs->current.type)->precedence)
     {
         tin_astparser_ignorenewlines(prs, true);
         tin_astparser_advance(prs);
         infixrule = tin_astparser_getrule(prs->previous.type)->infix;
+        column = prs->previous.column;
         expr = infixrule(prs, expr, canassign);
+        tin_astparser_setcolumn(expr, column);
     }
     if(err && canassign && tin_astparser_match(prs, TINTOK_ASSIGN))
     {
@@ -1167,7 +1182,7 @@ static TinAstExpression* tin_astparser_rulesuper(TinAstParser* prs, bool canassi
     if(!(tin_astparser_match(prs, TINTOK_DOT) || tin_astparser_match(prs, TINTOK_SMALLARROW)))
     {
         expression = (TinAstExpression*)tin_ast_make_superexpr(
-        prs->state, line, tin_string_copy(prs->state, TIN_VALUE_CTORNAME, strlen(TIN_VALUE_CTORNAME)), false);
+        prs->state, line, prs->state->symbols[TINSYM_CONSTRUCTOR], false);
         tin_astparser_consume(prs, TINTOK_PARENOPEN, "'(' after 'super'");
         return tin_astparser_rulecall(prs, expression, false);
     }
@@ -1206,14 +1221,9 @@ static TinAstExpression* tin_astparser_rulereference(TinAstParser* prs, bool can
 
 
 
-static TinAstExpression* tin_astparser_parsestatement(TinAstParser* prs)
+static TinAstExpression* tin_astparser_doparsestatement(TinAstParser* prs)
 {
     TinAstExpression* expression;
-    tin_astparser_ignorenewlines(prs, true);
-    if(setjmp(prs_jmpbuffer))
-    {
-        return NULL;
-    }
     if(tin_astparser_match(prs, TINTOK_KWVAR) || tin_astparser_match(prs, TINTOK_KWCONST))
     {
         return tin_astparser_parsevar_declaration(prs, true);
@@ -1258,6 +1268,32 @@ static TinAstExpression* tin_astparser_parsestatement(TinAstParser* prs)
     return (TinAstExpression*)tin_ast_make_exprstmt(prs->state, prs->previous.line, expression);
 }
 
+/*
+* statements nest, and each one is a recovery point for tin_astparser_sync. the enclosing one's
+* prs_jmpbuffer is put back once a statement is done, so an error after it never jumps into a
+* frame that has already returned.
+*/
+static TinAstExpression* tin_astparser_parsestatement(TinAstParser* prs)
+{
+    size_t column;
+    jmp_buf enclosing;
+    TinAstExpression* statement;
+    tin_astparser_ignorenewlines(prs, true);
+    column = prs->current.column;
+    memcpy(enclosing, prs_jmpbuffer, sizeof(jmp_buf));
+    if(setjmp(prs_jmpbuffer))
+    {
+        statement = NULL;
+    }
+    else
+    {
+        statement = tin_astparser_doparsestatement(prs);
+    }
+    memcpy(prs_jmpbuffer, enclosing, sizeof(jmp_buf));
+    tin_astparser_setcolumn(statement, column);
+    return statement;
+}
+
 static TinAstExpression* tin_astparser_parseexpression(TinAstParser* prs, bool ignsemi)
 {
     tin_astparser_ignorenewlines(prs, ignsemi);
@@ -1624,7 +1660,7 @@ static TinAstExpression* tin_astparser_parsemethod(TinAstParser* prs, bool issta
     return (TinAstExpression*)method;
 }
 
-static TinAstExpression* tin_astparser_parseclass(TinAstParser* prs)
+static TinAstExpression* tin_astparser_doparseclass(TinAstParser* prs)
 {
     bool finishedparsingfields;
     bool fieldisstatic;
@@ -1635,10 +1671,6 @@ static TinAstExpression* tin_astparser_parseclass(TinAstParser* prs)
     TinAstClassExpr* klass;
     TinAstExpression* var;
     TinAstExpression* method;
-    if(setjmp(prs_jmpbuffer))
-    {
-        return NULL;
-    }
     line = prs->previous.line;
     isstatic = prs->previous.type == TINTOK_KWSTATIC;
     if(isstatic)
@@ -1662,7 +1694,7 @@ static TinAstExpression* tin_astparser_parseclass(TinAstParser* prs)
     tin_astparser_consume(prs, TINTOK_BRACEOPEN, "'{' before class body");
     tin_astparser_ignorenewlines(prs, true);
     finishedparsingfields = false;
-    while(!tin_astparser_check(prs, TINTOK_BRACECLOSE))
+    while(!tin_astparser_check(prs, TINTOK_BRACECLOSE) && !prs_is_at_end(prs))
     {
         fieldisstatic = false;
         if(tin_astparser_match(prs, TINTOK_KWSTATIC))
@@ -1698,6 +1730,24 @@ static TinAstExpression* tin_astparser_parseclass(TinAstParser* prs)
     return (TinAstExpression*)klass;
 }
 
+/* a recovery point like tin_astparser_parsestatement, for errors between the methods of a class */
+static TinAstExpression* tin_astparser_parseclass(TinAstParser* prs)
+{
+    jmp_buf enclosing;
+    TinAstExpression* klass;
+    memcpy(enclosing, prs_jmpbuffer, sizeof(jmp_buf));
+    if(setjmp(prs_jmpbuffer))
+    {
+        klass = NULL;
+    }
+    else
+    {
+        klass = tin_astparser_doparseclass(prs);
+    }
+    memcpy(prs_jmpbuffer, enclosing, sizeof(jmp_buf));
+    return klass;
+}
+
 static void tin_astparser_sync(TinAstParser* prs)
 {
     prs->panicmode = false;
@@ -1734,11 +1784,14 @@ static void tin_astparser_sync(TinAstParser* prs)
 
 static TinAstExpression* tin_astparser_parsedeclaration(TinAstParser* prs)
 {
+    size_t column;
     TinAstExpression* statement;
     statement = NULL;
+    column = prs->current.column;
     if(tin_astparser_match(prs, TINTOK_KWCLASS) || tin_astparser_match(prs, TINTOK_KWSTATIC))
     {
         statement = tin_astparser_parseclass(prs);
+        tin_astparser_setcolumn(statement, column);
     }
     else
     {
@@ -16,12 +16,6 @@ void tin_bytelist_init(TinAstByteList* bl)
     bl->count = 0;
 }
 
-void tin_bytelist_destroy(TinState* state, TinAstByteList* bl)
-{
-    tin_gcmem_freearray(state, sizeof(uint8_t), bl->values, bl->capacity);
-    tin_bytelist_init(bl);
-}
-
 void tin_bytelist_push(TinState* state, TinAstByteList* bl, uint8_t value)
 {
     size_t oldcap;
@@ -29,7 +23,7 @@ void tin_bytelist_push(TinState* state, TinAstByteList* bl, uint8_t value)
     {
         oldcap = bl->capacity;
         bl->capacity = TIN_CCSCAN_GROWCAPACITY(oldcap);
-        bl->values = (uint8_t*)tin_gcmem_growarray(state, bl->values, sizeof(uint8_t), oldcap, bl->capacity);
+        bl->values = (uint8_t*)tin_astarena_grow(state, bl->values, oldcap, bl->capacity);
     }
     bl->values[bl->count] = value;
     bl->count++;
@@ -48,6 +42,7 @@ static inline bool tin_lexutil_isalpha(char c)
 void tin_astlex_init(TinState* state, TinAstScanner* scn, const char* filename, const char* source, size_t srclength)
 {
     scn->line = 1;
+    scn->linestart = source;
     scn->start = source;
     scn->srclength = srclength;
     scn->current = source;
@@ -64,6 +59,7 @@ static TinAstToken tin_astlex_maketoken(TinAstScanner* scn, TinAstTokType type)
     token.start = scn->start;
     token.length = (size_t)(scn->current - scn->start);
     token.line = scn->line;
+    token.column = (scn->start >= scn->linestart) ? (size_t)(scn->start - scn->linestart) + 1 : 0;
     return token;
 }
 
@@ -80,6 +76,7 @@ static TinAstToken tin_astlex_makeerrortoken(TinAstScanner* scn, const char* fmt
     token.start = result->data;
     token.length = tin_string_getlength(result);
     token.line = scn->line;
+    token.column = (size_t)(scn->current - scn->linestart) + 1;
     return token;
 }
 
@@ -198,6 +195,7 @@ static bool tin_astlex_skipspace(TinAstScanner* scn)
                             if(tin_astlex_peekcurrent(scn) == '\n')
                             {
                                 scn->line++;
+                                scn->linestart = scn->current + 1;
                             }
                             tin_astlex_advance(scn);
                         }
@@ -253,6 +251,7 @@ static TinAstToken tin_astlex_scanstring(TinAstScanner* scn, bool interpolation)
             case '\n':
                 {
                     scn->line++;
+                    scn->linestart = scn->current;
                     tin_bytelist_push(state, &bytes, c);
                 }
                 break;
@@ -332,7 +331,6 @@ static TinAstToken tin_astlex_scanstring(TinAstScanner* scn, bool interpolation)
     }
     token = tin_astlex_maketoken(scn, stringtype);
     token.value = tin_value_fromobject(tin_string_copy(state, (const char*)bytes.values, bytes.count));
-    tin_bytelist_destroy(state, &bytes);
     return token;
 }
 
@@ -673,6 +671,7 @@ TinAstToken tin_astlex_scantoken(TinAstScanner* scn)
     {
         token = tin_astlex_maketoken(scn, TINTOK_NEWLINE);
         scn->line++;
+        scn->linestart = scn->current;
         return token;
     }
     scn->start = scn->current;
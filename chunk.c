@@ -12,24 +12,183 @@ void tin_chunk_init(TinState* state, TinChunk* chunk)
     chunk->capacity = 0;
     chunk->code = NULL;
     chunk->haslineinfo = true;
-    chunk->linecount = 0;
+    chunk->linelength = 0;
     chunk->linecap = 0;
-    chunk->lines = NULL;
+    chunk->lineinfo = NULL;
+    chunk->checkpointcount = 0;
+    chunk->checkpointcap = 0;
+    chunk->checkpoints = NULL;
+    chunk->lastlinepc = 0;
+    chunk->lastline = 0;
+    chunk->lastcolumn = 0;
+    chunk->lineentries = 0;
+    chunk->icachecount = 0;
+    chunk->icaches = NULL;
+    chunk->globalrefcount = 0;
+    chunk->globalrefs = NULL;
+    chunk->codeinimage = false;
+    chunk->constindex = NULL;
+    chunk->constindexcap = 0;
+    chunk->constindexcount = 0;
     tin_vallist_init(state, &chunk->constants);
 }
 
 void tin_chunk_destroy(TinState* state, TinChunk* chunk)
 {
-    tin_gcmem_freearray(state, sizeof(uint8_t), chunk->code, chunk->capacity);
-    tin_gcmem_freearray(state, sizeof(uint16_t), chunk->lines, chunk->linecap);
+    if(!chunk->codeinimage)
+    {
+        tin_gcmem_freearray(state, sizeof(uint8_t), chunk->code, chunk->capacity);
+    }
+    tin_gcmem_freearray(state, sizeof(uint8_t), chunk->lineinfo, chunk->linecap);
+    tin_gcmem_freearray(state, sizeof(TinLineCheckpoint), chunk->checkpoints, chunk->checkpointcap);
+    if(chunk->icaches != NULL)
+    {
+        tin_gcmem_freearray(state, sizeof(TinInlineCache), chunk->icaches, chunk->icachecount);
+    }
+    if(chunk->globalrefs != NULL)
+    {
+        tin_gcmem_freearray(state, sizeof(TinValue*), chunk->globalrefs, chunk->globalrefcount);
+    }
+    tin_chunk_freeconstindex(state, chunk);
     tin_vallist_destroy(state, &chunk->constants);
     tin_chunk_init(state, chunk);
 }
 
-void tin_chunk_push(TinState* state, TinChunk* chunk, uint8_t byte, uint16_t line)
+/*
+* the line table.
+*
+* every instruction byte is pushed with the line and column it came from. whenever those change, an entry
+* is added to $chunk->lineinfo, holding the distance in bytes from the pc of the previous entry, the
+* difference to its line, and the column (0 if unknown). the first entry is relative to pc 0 and line 0,
+* and an entry holds for every byte up to the next one.
+* an entry starts with a byte holding the pc distance in bits 3-6 and the line difference (zigzag
+* encoded) in bits 0-2, if they fit (below 16, and within -3..3); otherwise that byte is
+* TIN_CHUNK_LINEESCAPE, and both follow as LEB128. the column follows as LEB128. so a typical entry
+* takes 2 bytes, whatever the size of the file.
+*
+* every TIN_CHUNK_LINECHECKPOINT-th entry is also remembered, decoded, in $chunk->checkpoints, so a
+* lookup is a binary search over those and decodes at most TIN_CHUNK_LINECHECKPOINT entries.
+*/
+
+#define TIN_CHUNK_LINEESCAPE 0x07
+
+static void tin_chunk_linebyte(TinState* state, TinChunk* chunk, uint8_t byte)
+{
+    size_t oldcapacity;
+    if(chunk->linecap < chunk->linelength + 1)
+    {
+        oldcapacity = chunk->linecap;
+        chunk->linecap = TIN_CHUNK_GROWCAPACITY(oldcapacity);
+        chunk->lineinfo = (uint8_t*)tin_gcmem_growarray(state, chunk->lineinfo, sizeof(uint8_t), oldcapacity, chunk->linecap);
+    }
+    chunk->lineinfo[chunk->linelength] = byte;
+    chunk->linelength++;
+}
+
+static void tin_chunk_writeuleb(TinState* state, TinChunk* chunk, uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        tin_chunk_linebyte(state, chunk, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    tin_chunk_linebyte(state, chunk, (uint8_t)value);
+}
+
+/* zigzag, so that small negative deltas stay small */
+static uint64_t tin_chunk_zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t tin_chunk_unzigzag(uint64_t value)
+{
+    return (int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static bool tin_chunk_readuleb(const uint8_t* data, size_t length, size_t* position, uint64_t* value)
+{
+    int shift;
+    uint8_t byte;
+    *value = 0;
+    shift = 0;
+    do
+    {
+        if(*position >= length || shift > 63)
+        {
+            return false;
+        }
+        byte = data[*position];
+        (*position)++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return true;
+}
+
+/* decodes the entry at $position into $pc, $line and $column, which hold the previous entry */
+static bool tin_chunk_readentry(const uint8_t* data, size_t length, size_t* position, size_t* pc, size_t* line, size_t* column)
+{
+    uint8_t head;
+    uint64_t pcdelta;
+    uint64_t linedelta;
+    uint64_t col;
+    if(*position >= length)
+    {
+        return false;
+    }
+    head = data[*position];
+    (*position)++;
+    if(head == TIN_CHUNK_LINEESCAPE)
+    {
+        if(!tin_chunk_readuleb(data, length, position, &pcdelta) || !tin_chunk_readuleb(data, length, position, &linedelta))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        pcdelta = head >> 3;
+        linedelta = head & 0x07;
+    }
+    if(!tin_chunk_readuleb(data, length, position, &col))
+    {
+        return false;
+    }
+    *pc += (size_t)pcdelta;
+    *line += (size_t)tin_chunk_unzigzag(linedelta);
+    *column = (size_t)col;
+    return true;
+}
+
+/* called for every entry once it is the last one; $offset is where the next one starts */
+static void tin_chunk_noteentry(TinState* state, TinChunk* chunk, size_t offset)
+{
+    size_t oldcapacity;
+    TinLineCheckpoint* checkpoint;
+    if((chunk->lineentries % TIN_CHUNK_LINECHECKPOINT) == 0)
+    {
+        if(chunk->checkpointcap < chunk->checkpointcount + 1)
+        {
+            oldcapacity = chunk->checkpointcap;
+            chunk->checkpointcap = TIN_CHUNK_GROWCAPACITY(oldcapacity);
+            chunk->checkpoints = (TinLineCheckpoint*)tin_gcmem_growarray(state, chunk->checkpoints, sizeof(TinLineCheckpoint), oldcapacity, chunk->checkpointcap);
+        }
+        checkpoint = &chunk->checkpoints[chunk->checkpointcount];
+        checkpoint->pc = (uint32_t)chunk->lastlinepc;
+        checkpoint->line = (uint32_t)chunk->lastline;
+        checkpoint->column = (uint32_t)chunk->lastcolumn;
+        checkpoint->offset = (uint32_t)offset;
+        chunk->checkpointcount++;
+    }
+    chunk->lineentries++;
+}
+
+void tin_chunk_push(TinState* state, TinChunk* chunk, uint8_t byte, size_t line, size_t column)
 {
-    size_t value;
-    size_t lineindex;
+    size_t pc;
+    size_t pcdelta;
+    uint64_t linedelta;
     size_t oldcapacity;
     if(chunk->capacity < chunk->count + 1)
     {
@@ -37,84 +196,261 @@ void tin_chunk_push(TinState* state, TinChunk* chunk, uint8_t byte, uint16_t lin
         chunk->capacity = TIN_CHUNK_GROWCAPACITY(oldcapacity + 2);
         chunk->code = (uint8_t*)tin_gcmem_growarray(state, chunk->code, sizeof(uint8_t), oldcapacity, chunk->capacity + 2);
     }
+    pc = chunk->count;
     chunk->code[chunk->count] = byte;
     chunk->count++;
     if(!chunk->haslineinfo)
     {
         return;
     }
-    if(chunk->linecap < chunk->linecount + 2)
+    if(chunk->lineentries > 0 && line == chunk->lastline && column == chunk->lastcolumn)
     {
-        oldcapacity = chunk->linecap;
-        chunk->linecap = TIN_CHUNK_GROWCAPACITY(chunk->linecap + 2);
-        chunk->lines = (uint16_t*)tin_gcmem_growarray(state, chunk->lines, sizeof(uint16_t), oldcapacity, chunk->linecap + 2);
-        if(oldcapacity == 0)
+        return;
+    }
+    pcdelta = pc - chunk->lastlinepc;
+    linedelta = tin_chunk_zigzag((int64_t)line - (int64_t)chunk->lastline);
+    if(pcdelta < 16 && linedelta < TIN_CHUNK_LINEESCAPE)
+    {
+        tin_chunk_linebyte(state, chunk, (uint8_t)((pcdelta << 3) | linedelta));
+    }
+    else
+    {
+        tin_chunk_linebyte(state, chunk, TIN_CHUNK_LINEESCAPE);
+        tin_chunk_writeuleb(state, chunk, pcdelta);
+        tin_chunk_writeuleb(state, chunk, linedelta);
+    }
+    tin_chunk_writeuleb(state, chunk, column);
+    chunk->lastlinepc = pc;
+    chunk->lastline = line;
+    chunk->lastcolumn = column;
+    tin_chunk_noteentry(state, chunk, chunk->linelength);
+}
+
+/* sets the line table of $chunk to a copy of $length bytes at $data (as written by tin_chunk_push). false if they don't decode */
+bool tin_chunk_setlineinfo(TinState* state, TinChunk* chunk, const uint8_t* data, size_t length)
+{
+    size_t position;
+    tin_gcmem_freearray(state, sizeof(uint8_t), chunk->lineinfo, chunk->linecap);
+    chunk->lineinfo = (uint8_t*)tin_gcmem_allocate(state, sizeof(uint8_t), length);
+    memcpy(chunk->lineinfo, data, length);
+    chunk->linelength = length;
+    chunk->linecap = length;
+    chunk->checkpointcount = 0;
+    chunk->lastlinepc = 0;
+    chunk->lastline = 0;
+    chunk->lastcolumn = 0;
+    chunk->lineentries = 0;
+    position = 0;
+    while(position < length)
+    {
+        if(!tin_chunk_readentry(data, length, &position, &chunk->lastlinepc, &chunk->lastline, &chunk->lastcolumn))
+        {
+            return false;
+        }
+        tin_chunk_noteentry(state, chunk, position);
+    }
+    return true;
+}
+
+/* the line and column of the instruction byte at $offset. both are 0 if the chunk has no line info */
+void tin_chunk_getposition(TinChunk* chunk, size_t offset, size_t* line, size_t* column)
+{
+    size_t lo;
+    size_t hi;
+    size_t mid;
+    size_t pc;
+    size_t nextpc;
+    size_t nextline;
+    size_t nextcolumn;
+    size_t position;
+    TinLineCheckpoint* checkpoint;
+    *line = 0;
+    *column = 0;
+    if(!chunk->haslineinfo || chunk->checkpointcount == 0)
+    {
+        return;
+    }
+    /* the last checkpoint at or before $offset; the first one is at pc 0 */
+    lo = 0;
+    hi = chunk->checkpointcount;
+    while(hi - lo > 1)
+    {
+        mid = lo + ((hi - lo) / 2);
+        if(chunk->checkpoints[mid].pc <= offset)
+        {
+            lo = mid;
+        }
+        else
         {
-            chunk->lines[0] = 0;
-            chunk->lines[1] = 0;
+            hi = mid;
         }
     }
-    lineindex = chunk->linecount;
-    value = chunk->lines[lineindex];
-    if(value != 0 && value != line)
+    checkpoint = &chunk->checkpoints[lo];
+    pc = checkpoint->pc;
+    *line = checkpoint->line;
+    *column = checkpoint->column;
+    position = checkpoint->offset;
+    while(position < chunk->linelength)
     {
-        chunk->linecount += 2;
-        lineindex = chunk->linecount;
-        chunk->lines[lineindex + 1] = 0;
+        nextpc = pc;
+        nextline = *line;
+        nextcolumn = *column;
+        if(!tin_chunk_readentry(chunk->lineinfo, chunk->linelength, &position, &nextpc, &nextline, &nextcolumn) || nextpc > offset)
+        {
+            break;
+        }
+        pc = nextpc;
+        *line = nextline;
+        *column = nextcolumn;
     }
-    chunk->lines[lineindex] = line;
-    chunk->lines[lineindex + 1]++;
 }
 
-size_t tin_chunk_addconst(TinState* state, TinChunk* chunk, TinValue constant)
+size_t tin_chunk_getline(TinChunk* chunk, size_t offset)
 {
-    size_t i;
-    TinValue itm;
-    TinState** cst;
-    cst = &state;
-    for(i = 0; i < tin_vallist_count(&chunk->constants); i++)
+    size_t line;
+    size_t column;
+    tin_chunk_getposition(chunk, offset, &line, &column);
+    return line;
+}
+
+/*
+* string and number constants are deduplicated by value, through an open-addressed index of
+* constant indices (plus one, so that 0 is an empty slot) that lives while the chunk is emitted.
+* other constants (functions, classes) are unique anyway, and are just appended.
+*/
+static bool tin_chunk_constkey(TinValue value, uint32_t* hash)
+{
+    uint64_t bits;
+    double floatval;
+    if(tin_value_isstring(value))
+    {
+        *hash = tin_string_gethash(tin_value_asstring(value));
+        return true;
+    }
+    if(!tin_value_isnumber(value))
+    {
+        return false;
+    }
+    if(tin_value_isfixednumber(value))
+    {
+        bits = (uint64_t)tin_value_asrawfixednumber(value);
+    }
+    else
+    {
+        /* bitwise, so that 0 and -0 stay apart */
+        floatval = tin_value_asrawfloatnumber(value);
+        memcpy(&bits, &floatval, sizeof(uint64_t));
+        bits ^= UINT64_C(0x9E3779B97F4A7C15);
+    }
+    bits ^= bits >> 33;
+    bits *= UINT64_C(0xFF51AFD7ED558CCD);
+    bits ^= bits >> 33;
+    *hash = (uint32_t)bits;
+    return true;
+}
+
+static bool tin_chunk_constequal(TinValue a, TinValue b)
+{
+    TinString* sa;
+    TinString* sb;
+    double fa;
+    double fb;
+    if(tin_value_isstring(a))
     {
-        itm = tin_vallist_get(&chunk->constants, i);
-        if(&itm == &constant)
+        if(!tin_value_isstring(b))
         {
-            return i;
+            return false;
         }
+        sa = tin_value_asstring(a);
+        sb = tin_value_asstring(b);
+        /* long strings aren't interned, so equal ones needn't be the same object */
+        return sa == sb || (tin_string_getlength(sa) == tin_string_getlength(sb)
+            && memcmp(sa->data, sb->data, tin_string_getlength(sa)) == 0);
     }
-    tin_state_pushvalueroot(state, constant);
-    tin_vallist_push(*cst, &chunk->constants, constant);
-    tin_state_poproot(state);
-    return tin_vallist_count(&chunk->constants) - 1;
+    if(!tin_value_isnumber(b) || tin_value_isfixednumber(a) != tin_value_isfixednumber(b))
+    {
+        return false;
+    }
+    if(tin_value_isfixednumber(a))
+    {
+        return tin_value_asrawfixednumber(a) == tin_value_asrawfixednumber(b);
+    }
+    fa = tin_value_asrawfloatnumber(a);
+    fb = tin_value_asrawfloatnumber(b);
+    return memcmp(&fa, &fb, sizeof(double)) == 0;
 }
 
-size_t tin_chunk_getline(TinChunk* chunk, size_t offset)
+static void tin_chunk_growconstindex(TinState* state, TinChunk* chunk)
 {
     size_t i;
-    size_t rle;
-    size_t line;
-    size_t index;
-    if(!chunk->haslineinfo)
+    size_t slot;
+    size_t oldcap;
+    uint32_t hash;
+    uint32_t* oldindex;
+    TinValue value;
+    oldcap = chunk->constindexcap;
+    oldindex = chunk->constindex;
+    chunk->constindexcap = TIN_CHUNK_GROWCAPACITY(oldcap);
+    chunk->constindex = (uint32_t*)tin_gcmem_allocate(state, sizeof(uint32_t), chunk->constindexcap);
+    memset(chunk->constindex, 0, sizeof(uint32_t) * chunk->constindexcap);
+    chunk->constindexcount = 0;
+    for(i = 0; i < tin_vallist_count(&chunk->constants); i++)
     {
-        return 0;
+        value = tin_vallist_get(&chunk->constants, i);
+        if(tin_chunk_constkey(value, &hash))
+        {
+            slot = hash & (chunk->constindexcap - 1);
+            while(chunk->constindex[slot] != 0)
+            {
+                slot = (slot + 1) & (chunk->constindexcap - 1);
+            }
+            chunk->constindex[slot] = (uint32_t)(i + 1);
+            chunk->constindexcount++;
+        }
     }
-    rle = 0;
-    line = 0;
-    index = 0;
-    for(i = 0; i < offset + 1; i++)
+    tin_gcmem_freearray(state, sizeof(uint32_t), oldindex, oldcap);
+}
+
+size_t tin_chunk_addconst(TinState* state, TinChunk* chunk, TinValue constant)
+{
+    size_t slot;
+    size_t index;
+    uint32_t hash;
+    tin_state_pushvalueroot(state, constant);
+    slot = 0;
+    if(tin_chunk_constkey(constant, &hash))
     {
-        if(rle > 0)
+        /* kept at most half full */
+        if((chunk->constindexcount + 1) * 2 > chunk->constindexcap)
         {
-            rle--;
-            continue;
+            tin_chunk_growconstindex(state, chunk);
         }
-        line = chunk->lines[index];
-        rle = chunk->lines[index + 1];
-        if(rle > 0)
+        slot = hash & (chunk->constindexcap - 1);
+        while(chunk->constindex[slot] != 0)
         {
-            rle--;
+            index = chunk->constindex[slot] - 1;
+            if(tin_chunk_constequal(constant, tin_vallist_get(&chunk->constants, index)))
+            {
+                tin_state_poproot(state);
+                return index;
+            }
+            slot = (slot + 1) & (chunk->constindexcap - 1);
         }
-        index += 2;
+        chunk->constindex[slot] = (uint32_t)(tin_vallist_count(&chunk->constants) + 1);
+        chunk->constindexcount++;
     }
-    return line;
+    tin_vallist_push(state, &chunk->constants, constant);
+    tin_state_poproot(state);
+    return tin_vallist_count(&chunk->constants) - 1;
+}
+
+/* drops the index of tin_chunk_addconst once the chunk is complete; it is rebuilt if more constants get added */
+void tin_chunk_freeconstindex(TinState* state, TinChunk* chunk)
+{
+    tin_gcmem_freearray(state, sizeof(uint32_t), chunk->constindex, chunk->constindexcap);
+    chunk->constindex = NULL;
+    chunk->constindexcap = 0;
+    chunk->constindexcount = 0;
 }
 
 void tin_chunk_shrink(TinState* state, TinChunk* chunk)
@@ -126,23 +462,199 @@ void tin_chunk_shrink(TinState* state, TinChunk* chunk)
         chunk->capacity = chunk->count;
         chunk->code = (uint8_t*)tin_gcmem_growarray(state, chunk->code, sizeof(uint8_t), oldcapacity, chunk->capacity);
     }
-    if(chunk->linecap > chunk->linecount)
+    if(chunk->linecap > chunk->linelength)
     {
         oldcapacity = chunk->linecap;
-        chunk->linecap = chunk->linecount + 2;
-        chunk->lines = (uint16_t*)tin_gcmem_growarray(state, chunk->lines, sizeof(uint16_t), oldcapacity, chunk->linecap);
+        chunk->linecap = chunk->linelength;
+        chunk->lineinfo = (uint8_t*)tin_gcmem_growarray(state, chunk->lineinfo, sizeof(uint8_t), oldcapacity, chunk->linecap);
+    }
+}
+
+/*
+* reserves a new inline cache slot. the index is emitted as a short
+* right after the operands of the instruction that uses it.
+*/
+uint16_t tin_chunk_addcache(TinState* state, TinChunk* chunk)
+{
+    (void)state;
+    chunk->icachecount++;
+    return (uint16_t)(chunk->icachecount - 1);
+}
+
+TinInlineCache* tin_chunk_getcache(TinState* state, TinChunk* chunk, uint16_t index)
+{
+    if(chunk->icaches == NULL)
+    {
+        chunk->icaches = (TinInlineCache*)tin_gcmem_allocate(state, sizeof(TinInlineCache), chunk->icachecount);
+        memset(chunk->icaches, 0, sizeof(TinInlineCache) * chunk->icachecount);
+    }
+    return &chunk->icaches[index];
+}
+
+/*
+* global instructions keep the name constant as their operand, so the bytecode does not
+* depend on the vm that runs it. the cell for each name is looked up once, on first use,
+* and remembered here under the constant index.
+*/
+TinValue* tin_chunk_getglobalref(TinState* state, TinChunk* chunk, uint16_t index)
+{
+    TinValue* cell;
+    if(chunk->globalrefs == NULL)
+    {
+        chunk->globalrefcount = tin_vallist_count(&chunk->constants);
+        chunk->globalrefs = (TinValue**)tin_gcmem_allocate(state, sizeof(TinValue*), chunk->globalrefcount);
+        memset(chunk->globalrefs, 0, sizeof(TinValue*) * chunk->globalrefcount);
+    }
+    cell = chunk->globalrefs[index];
+    if(cell == NULL)
+    {
+        cell = tin_vm_globalcell(state, tin_value_asstring(tin_vallist_get(&chunk->constants, index)));
+        chunk->globalrefs[index] = cell;
+    }
+    return cell;
+}
+
+/* the length in bytes of the instruction at $offset, including its operands */
+size_t tin_chunk_oplength(TinChunk* chunk, size_t offset)
+{
+    TinValue function;
+    switch(chunk->code[offset])
+    {
+        case OP_CONSTVALUE:
+        case OP_LOCALSET:
+        case OP_LOCALGET:
+        case OP_PRIVATESET:
+        case OP_PRIVATEGET:
+        case OP_UPVALSET:
+        case OP_UPVALGET:
+        case OP_VARARG:
+        case OP_REFUPVAL:
+            return 2;
+        case OP_CONSTLONG:
+        case OP_GLOBALSET:
+        case OP_GLOBALGET:
+        case OP_LOCALLONGSET:
+        case OP_LOCALLONGGET:
+        case OP_PRIVATELONGSET:
+        case OP_PRIVATELONGGET:
+        case OP_JUMPIFFALSE:
+        case OP_JUMPIFNULL:
+        case OP_JUMPIFNULLPOP:
+        case OP_JUMPALWAYS:
+        case OP_JUMPBACK:
+        case OP_AND:
+        case OP_OR:
+        case OP_NULLOR:
+        case OP_MAKECLASS:
+        case OP_FIELDGET:
+        case OP_FIELDSET:
+        case OP_MAKEMETHOD:
+        case OP_FIELDSTATIC:
+        case OP_FIELDDEFINE:
+        case OP_GETSUPERMETHOD:
+        case OP_POPLOCALS:
+        case OP_REFGLOBAL:
+        case OP_REFPRIVATE:
+        case OP_REFLOCAL:
+        case OP_LOCALSETPOP:
+        case OP_FIELDGETSLOT:
+            return 3;
+        case OP_CALLFUNCTION:
+        case OP_TAILCALL:
+        case OP_INVOKESUPER:
+        case OP_INVOKESUPERIGNORING:
+            return 4;
+        case OP_LOCALLOCALARITH:
+        case OP_LOCALCONSTARITH:
+            return 5;
+        case OP_INVOKEMETHOD:
+        case OP_INVOKEIGNORING:
+            return 6;
+        case OP_LOCALLOCALBRANCH:
+        case OP_LOCALCONSTBRANCH:
+        case OP_LOCALINCR:
+            return 8;
+        case OP_MAKECLOSURE:
+            {
+                function = tin_vallist_get(&chunk->constants, (chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+                return 3 + (tin_value_asfunction(function)->upvalcount * 2);
+            }
+            break;
+        default:
+            break;
+    }
+    return 1;
+}
+
+/* the instruction the vm quickened into $op, or $op itself */
+uint8_t tin_chunk_genericop(uint8_t op)
+{
+    switch(op)
+    {
+        case OP_MATHADDINT:
+        case OP_MATHADDFLOAT:
+            return OP_MATHADD;
+        case OP_MATHSUBINT:
+        case OP_MATHSUBFLOAT:
+            return OP_MATHSUB;
+        case OP_MATHMULTINT:
+        case OP_MATHMULTFLOAT:
+            return OP_MATHMULT;
+        case OP_LESSTHANINT:
+        case OP_LESSTHANFLOAT:
+            return OP_LESSTHAN;
+        case OP_GREATERTHANINT:
+        case OP_GREATERTHANFLOAT:
+            return OP_GREATERTHAN;
+        case OP_GETINDEXARRAY:
+        case OP_GETINDEXTYPED:
+            return OP_GETINDEX;
+        case OP_FIELDGETSLOT:
+            return OP_FIELDGET;
+        default:
+            break;
+    }
+    return op;
+}
+
+/*
+* copies the code of $chunk to $dest (which must hold chunk->count bytes) as the compiler emitted it,
+* i.e. with every quickened instruction put back to its generic form.
+* superinstructions are stepped over like the OP_LOCALGET or OP_LOCALSET they replaced, since the rest
+* of their sequence is still in place, and may have been quickened as well.
+*/
+void tin_chunk_copygeneric(TinChunk* chunk, uint8_t* dest)
+{
+    size_t i;
+    size_t length;
+    uint8_t op;
+    memcpy(dest, chunk->code, chunk->count);
+    i = 0;
+    while(i < chunk->count)
+    {
+        op = chunk->code[i];
+        if(op >= OP_LOCALSETPOP && op <= OP_LOCALINCR)
+        {
+            length = 2;
+        }
+        else
+        {
+            length = tin_chunk_oplength(chunk, i);
+        }
+        dest[i] = tin_chunk_genericop(op);
+        i += length;
     }
 }
 
 void tin_chunk_emitbyte(TinState* state, TinChunk* chunk, uint8_t byte)
 {
-    tin_chunk_push(state, chunk, byte, 1);
+    tin_chunk_push(state, chunk, byte, 1, 0);
 }
 
 void tin_chunk_emit2bytes(TinState* state, TinChunk* chunk, uint8_t a, uint8_t b)
 {
-    tin_chunk_push(state, chunk, a, 1);
-    tin_chunk_push(state, chunk, b, 1);
+    tin_chunk_push(state, chunk, a, 1, 0);
+    tin_chunk_push(state, chunk, b, 1, 0);
 }
 
 void tin_chunk_emitshort(TinState* state, TinChunk* chunk, uint16_t value)
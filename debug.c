@@ -4,6 +4,7 @@
 
 void tin_disassemble_module(TinState* state, TinModule* module, const char* source)
 {
+    tin_function_ensureloaded(state, module->mainfunction);
     tin_disassemble_chunk(state, &module->mainfunction->chunk, module->mainfunction->name->data, source);
 }
 
@@ -22,6 +23,7 @@ void tin_disassemble_chunk(TinState* state, TinChunk* chunk, const char* name, c
         if(tin_value_isfunction(value))
         {
             function = tin_value_asfunction(value);
+            tin_function_ensureloaded(state, function);
             tin_disassemble_chunk(state, &function->chunk, function->name->data, source);
         }
     }
@@ -73,7 +75,7 @@ static size_t print_short_op(TinState* state, TinWriter* wr, const char* name, T
     slot = (uint16_t)(chunk->code[offset + 1] << 8);
     slot |= chunk->code[offset + 2];
     tin_writer_writeformat(wr, "%s%-16s%s %4d\n", COLOR_YELLOW, name, COLOR_RESET, slot);
-    return offset + 2;
+    return offset + 3;
 }
 
 static size_t print_jump_op(TinState* state, TinWriter* wr, const char* name, int sign, TinChunk* chunk, size_t offset)
@@ -86,18 +88,102 @@ static size_t print_jump_op(TinState* state, TinWriter* wr, const char* name, in
     return offset + 3;
 }
 
-static size_t print_invoke_op(TinState* state, TinWriter* wr, const char* name, TinChunk* chunk, size_t offset)
+static size_t print_cached_op(TinState* state, TinWriter* wr, const char* name, TinChunk* chunk, size_t offset)
+{
+    uint16_t slot;
+    (void)state;
+    slot = (uint16_t)(chunk->code[offset + 1] << 8);
+    slot |= chunk->code[offset + 2];
+    tin_writer_writeformat(wr, "%s%-16s%s [ic %d]\n", COLOR_YELLOW, name, COLOR_RESET, slot);
+    return offset + 3;
+}
+
+static size_t print_invoke_op(TinState* state, TinWriter* wr, const char* name, TinChunk* chunk, size_t offset, bool cached)
 {
     uint8_t arg_count;
-    uint8_t constant;
+    uint16_t constant;
+    uint16_t slot;
     (void)state;
     arg_count = chunk->code[offset + 1];
-    constant = chunk->code[offset + 2];
+    constant = (uint16_t)(chunk->code[offset + 2] << 8);
     constant |= chunk->code[offset + 3];
     tin_writer_writeformat(wr, "%s%-16s%s (%d args) %4d '", COLOR_YELLOW, name, COLOR_RESET, arg_count, constant);
     tin_towriter_value(state, wr, tin_vallist_get(&chunk->constants, constant), true);
-    tin_writer_writeformat(wr, "'\n");
-    return offset + 4;
+    if(!cached)
+    {
+        tin_writer_writeformat(wr, "'\n");
+        return offset + 4;
+    }
+    slot = (uint16_t)(chunk->code[offset + 4] << 8);
+    slot |= chunk->code[offset + 5];
+    tin_writer_writeformat(wr, "' [ic %d]\n", slot);
+    return offset + 6;
+}
+
+static const char* fused_op_symbol(uint8_t op)
+{
+    switch(tin_chunk_genericop(op))
+    {
+        case OP_MATHADD: return "+";
+        case OP_MATHSUB: return "-";
+        case OP_MATHMULT: return "*";
+        case OP_MATHPOWER: return "**";
+        case OP_MATHDIV: return "/";
+        case OP_MATHMOD: return "%";
+        case OP_BINAND: return "&";
+        case OP_BINOR: return "|";
+        case OP_BINXOR: return "^";
+        case OP_LEFTSHIFT: return "<<";
+        case OP_RIGHTSHIFT: return ">>";
+        case OP_EQUAL: return "==";
+        case OP_GREATERTHAN: return ">";
+        case OP_GREATEREQUAL: return ">=";
+        case OP_LESSTHAN: return "<";
+        case OP_LESSEQUAL: return "<=";
+        default:
+            break;
+    }
+    return "??";
+}
+
+/*
+* superinstructions are printed as one line, with the operands of the sequence they stand for:
+* "slot op slot", "slot op 'constant'", followed by the jump target for the branching ones.
+*/
+static size_t print_fused_op(TinState* state, TinWriter* wr, const char* name, TinChunk* chunk, size_t offset)
+{
+    bool isconst;
+    bool isbranch;
+    uint8_t* code;
+    uint16_t jump;
+    size_t length;
+    code = &chunk->code[offset];
+    length = tin_chunk_oplength(chunk, offset);
+    if(code[0] == OP_LOCALSETPOP)
+    {
+        tin_writer_writeformat(wr, "%s%-16s%s %4d\n", COLOR_YELLOW, name, COLOR_RESET, code[1]);
+        return offset + length;
+    }
+    isconst = (code[0] == OP_LOCALCONSTARITH || code[0] == OP_LOCALCONSTBRANCH || code[0] == OP_LOCALINCR);
+    isbranch = (code[0] == OP_LOCALLOCALBRANCH || code[0] == OP_LOCALCONSTBRANCH);
+    tin_writer_writeformat(wr, "%s%-16s%s %4d %s ", COLOR_YELLOW, name, COLOR_RESET, code[1], fused_op_symbol(code[4]));
+    if(isconst)
+    {
+        tin_writer_writeformat(wr, "'");
+        tin_towriter_value(state, wr, tin_vallist_get(&chunk->constants, code[3]), true);
+        tin_writer_writeformat(wr, "'");
+    }
+    else
+    {
+        tin_writer_writeformat(wr, "%d", code[3]);
+    }
+    if(isbranch)
+    {
+        jump = (uint16_t)((code[6] << 8) | code[7]);
+        tin_writer_writeformat(wr, " else -> %d", (int)(offset + length + jump));
+    }
+    tin_writer_writeformat(wr, "\n");
+    return offset + length;
 }
 
 size_t tin_disassemble_instruction(TinState* state, TinChunk* chunk, size_t offset, const char* source)
@@ -250,7 +336,9 @@ size_t tin_disassemble_instruction(TinState* state, TinChunk* chunk, size_t offs
         case OP_NULLOR:
             return print_jump_op(state, wr, "OP_NULLOR", 1, chunk, offset);
         case OP_CALLFUNCTION:
-            return print_byte_op(state, wr, "OP_CALLFUNCTION", chunk, offset);
+            return print_invoke_op(state, wr, "OP_CALLFUNCTION", chunk, offset, false);
+        case OP_TAILCALL:
+            return print_invoke_op(state, wr, "OP_TAILCALL", chunk, offset, false);
         case OP_MAKECLOSURE:
             {
                 offset++;
@@ -276,9 +364,9 @@ size_t tin_disassemble_instruction(TinState* state, TinChunk* chunk, size_t offs
             return print_constant_op(state, wr, "OP_MAKECLASS", chunk, offset, true);
 
         case OP_FIELDGET:
-            return print_simple_op(state, wr, "OP_FIELDGET", offset);
+            return print_cached_op(state, wr, "OP_FIELDGET", chunk, offset);
         case OP_FIELDSET:
-            return print_simple_op(state, wr, "OP_FIELDSET", offset);
+            return print_cached_op(state, wr, "OP_FIELDSET", chunk, offset);
 
         case OP_GETINDEX:
             return print_simple_op(state, wr, "OP_GETINDEX", offset);
@@ -301,13 +389,13 @@ size_t tin_disassemble_instruction(TinState* state, TinChunk* chunk, size_t offs
         case OP_FIELDDEFINE:
             return print_constant_op(state, wr, "OP_FIELDDEFINE", chunk, offset, true);
         case OP_INVOKEMETHOD:
-            return print_invoke_op(state, wr, "OP_INVOKEMETHOD", chunk, offset);
+            return print_invoke_op(state, wr, "OP_INVOKEMETHOD", chunk, offset, true);
         case OP_INVOKESUPER:
-            return print_invoke_op(state, wr, "OP_INVOKESUPER", chunk, offset);
+            return print_invoke_op(state, wr, "OP_INVOKESUPER", chunk, offset, false);
         case OP_INVOKEIGNORING:
-            return print_invoke_op(state, wr, "OP_INVOKEIGNORING", chunk, offset);
+            return print_invoke_op(state, wr, "OP_INVOKEIGNORING", chunk, offset, true);
         case OP_INVOKESUPERIGNORING:
-            return print_invoke_op(state, wr, "OP_INVOKESUPERIGNORING", chunk, offset);
+            return print_invoke_op(state, wr, "OP_INVOKESUPERIGNORING", chunk, offset, false);
         case OP_CLASSINHERIT:
             return print_simple_op(state, wr, "OP_CLASSINHERIT", offset);
         case OP_ISCLASS:
@@ -328,6 +416,44 @@ size_t tin_disassemble_instruction(TinState* state, TinChunk* chunk, size_t offs
             return print_constant_op(state, wr, "OP_REFGLOBAL", chunk, offset, true);
         case OP_REFSET:
             return print_simple_op(state, wr, "OP_REFSET", offset);
+        case OP_LOCALSETPOP:
+            return print_fused_op(state, wr, "OP_LOCALSETPOP", chunk, offset);
+        case OP_LOCALLOCALARITH:
+            return print_fused_op(state, wr, "OP_LOCALLOCALARITH", chunk, offset);
+        case OP_LOCALCONSTARITH:
+            return print_fused_op(state, wr, "OP_LOCALCONSTARITH", chunk, offset);
+        case OP_LOCALLOCALBRANCH:
+            return print_fused_op(state, wr, "OP_LOCALLOCALBRANCH", chunk, offset);
+        case OP_LOCALCONSTBRANCH:
+            return print_fused_op(state, wr, "OP_LOCALCONSTBRANCH", chunk, offset);
+        case OP_LOCALINCR:
+            return print_fused_op(state, wr, "OP_LOCALINCR", chunk, offset);
+        case OP_MATHADDINT:
+            return print_simple_op(state, wr, "OP_MATHADDINT", offset);
+        case OP_MATHADDFLOAT:
+            return print_simple_op(state, wr, "OP_MATHADDFLOAT", offset);
+        case OP_MATHSUBINT:
+            return print_simple_op(state, wr, "OP_MATHSUBINT", offset);
+        case OP_MATHSUBFLOAT:
+            return print_simple_op(state, wr, "OP_MATHSUBFLOAT", offset);
+        case OP_MATHMULTINT:
+            return print_simple_op(state, wr, "OP_MATHMULTINT", offset);
+        case OP_MATHMULTFLOAT:
+            return print_simple_op(state, wr, "OP_MATHMULTFLOAT", offset);
+        case OP_LESSTHANINT:
+            return print_simple_op(state, wr, "OP_LESSTHANINT", offset);
+        case OP_LESSTHANFLOAT:
+            return print_simple_op(state, wr, "OP_LESSTHANFLOAT", offset);
+        case OP_GREATERTHANINT:
+            return print_simple_op(state, wr, "OP_GREATERTHANINT", offset);
+        case OP_GREATERTHANFLOAT:
+            return print_simple_op(state, wr, "OP_GREATERTHANFLOAT", offset);
+        case OP_GETINDEXARRAY:
+            return print_simple_op(state, wr, "OP_GETINDEXARRAY", offset);
+        case OP_FIELDGETSLOT:
+            return print_cached_op(state, wr, "OP_FIELDGETSLOT", chunk, offset);
+        case OP_GETINDEXTYPED:
+            return print_simple_op(state, wr, "OP_GETINDEXTYPED", offset);
         default:
             {
                 tin_writer_writeformat(wr, "Unknown opcode %d\n", instruction);
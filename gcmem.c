@@ -4,51 +4,412 @@
 #include <time.h>
 #include "priv.h"
 
+#if defined(TIN_GC_PARALLELMARK)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#if defined(TIN_OS_UNIXLIKE)
+    #include <sys/mman.h>
+    #define TIN_SLAB_USEMMAP
+#elif defined(TIN_OS_WINDOWS)
+    #include <malloc.h>
+#endif
+
 
 #define TIN_GCMEM_GROWCAPACITY(cap) \
     (((cap) < 8) ? (8) : ((cap) * 2))
 
+/*
+* the collector is generational, without moving anything:
+*
+* every object lives in a slab (see below), and its mark bit lives in the mark bitmap of that slab.
+* an object whose mark bit is set survived a collection, and is "old"; newer objects are young.
+* mark bits of old objects stay set, so a minor collection stops tracing at them, and
+* costs about as much as the young objects that are still reachable, instead of the whole heap.
+* a sweep just compares the allocation bitmap with the mark bitmap of each slab; only the headers
+* of dead objects are touched, to free them.
+*
+* that only works if every young object that is referenced from an old one is found
+* some other way. stores into arrays, maps, instances, closures and upvalues go through
+* tin_gcmem_writebarrier, which puts the old object into the remembered set, which the next
+* minor collection scans. fibers, modules, classes, functions, references and userdata get
+* mutated all over the place, so these are "watched" instead: every minor collection
+* scans all of them.
+*
+* a major collection clears all mark bitmaps and works like the old stop-the-world collector.
+*/
 
-#if 0
-static TinObject g_stackmem[1024 * (1024 * 4)];
-static size_t g_objcount = 0;
-#endif
 
-TinObject* tin_object_allocobject(TinState* state, size_t size, TinObjType type, bool islight)
+/*
+* size classes: cell sizes are multiples of TIN_SLAB_GRANULARITY, which covers every
+* fixed-size object struct (and instances with a few inline slots) without much waste.
+* slabs are aligned to TIN_SLAB_SIZE, so the slab of a cell is found by masking its address,
+* and its bit in the bitmaps of the slab by the offset of the cell.
+* anything bigger than TIN_SLAB_MAXSIZE gets a slab of its own.
+*/
+static size_t tin_slab_headersize()
 {
-    TinObject* obj;
-    islight = false;
-    if(islight)
-    {
-        #if 0
-            int ofs = g_objcount; 
-            obj = &g_stackmem[ofs];
-            g_objcount += 1;
-        #else
-            goto forcealloc;
-        #endif
-        obj->mustfree = false;
+    return ((sizeof(TinSlab) + TIN_SLAB_GRANULARITY - 1) / TIN_SLAB_GRANULARITY) * TIN_SLAB_GRANULARITY;
+}
+
+static inline TinSlab* tin_slab_of(const void* ptr)
+{
+    return (TinSlab*)((uintptr_t)ptr & ~((uintptr_t)TIN_SLAB_SIZE - 1));
+}
+
+static inline size_t tin_slab_bitof(const void* ptr)
+{
+    return ((uintptr_t)ptr & ((uintptr_t)TIN_SLAB_SIZE - 1)) / TIN_SLAB_GRANULARITY;
+}
+
+static inline bool tin_slab_ismarked(const void* ptr)
+{
+    size_t bit;
+    bit = tin_slab_bitof(ptr);
+    return (tin_slab_of(ptr)->markbits[bit / 64] >> (bit % 64)) & 1;
+}
+
+bool tin_gcmem_ismarked(TinObject* object)
+{
+    return tin_slab_ismarked(object);
+}
+
+void tin_slab_init(TinState* state)
+{
+    size_t i;
+    TinSlabClass* sc;
+    for(i = 0; i < TIN_SLAB_CLASSCOUNT; i++)
+    {
+        sc = &state->gcslabs[i];
+        sc->cellsize = (i + 1) * TIN_SLAB_GRANULARITY;
+        sc->cellsperslab = (TIN_SLAB_SIZE - tin_slab_headersize()) / sc->cellsize;
+        sc->partial = NULL;
+        sc->full = NULL;
+        sc->slabcount = 0;
+        sc->livecount = 0;
+        sc->allocations = 0;
+    }
+    state->gcallslabs = NULL;
+    state->gcspareslabs = NULL;
+    state->gcsparecount = 0;
+}
+
+static void tin_slab_unlink(TinSlab** list, TinSlab* slab)
+{
+    if(slab->prev != NULL)
+    {
+        slab->prev->next = slab->next;
     }
     else
     {
-        forcealloc:
-        obj = (TinObject*)tin_gcmem_memrealloc(state, NULL, 0, size);
-        obj->mustfree = true;
+        *list = slab->next;
     }
-    obj->type = type;
-    obj->marked = false;
-    obj->next = state->vm->gcobjects;
-    state->vm->gcobjects = obj;
-    #ifdef TIN_LOG_ALLOCATION
-        fprintf(stderr, "%p allocate %ld for %s\n", (void*)obj, size, tin_tostring_typename(type));
+    if(slab->next != NULL)
+    {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+static void tin_slab_link(TinSlab** list, TinSlab* slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if(*list != NULL)
+    {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+/* every slab in use is on state->gcallslabs, which is what the sweep walks */
+static void tin_slab_linkall(TinState* state, TinSlab* slab)
+{
+    slab->allprev = NULL;
+    slab->allnext = state->gcallslabs;
+    if(state->gcallslabs != NULL)
+    {
+        state->gcallslabs->allprev = slab;
+    }
+    state->gcallslabs = slab;
+}
+
+static void tin_slab_unlinkall(TinState* state, TinSlab* slab)
+{
+    if(slab->allprev != NULL)
+    {
+        slab->allprev->allnext = slab->allnext;
+    }
+    else
+    {
+        state->gcallslabs = slab->allnext;
+    }
+    if(slab->allnext != NULL)
+    {
+        slab->allnext->allprev = slab->allprev;
+    }
+}
+
+/*
+* slabs come straight from mmap: aligned_alloc() has to over-allocate by up to the alignment,
+* which would waste almost half of the memory at this size.
+* $size plus the alignment is mapped, and whatever is outside of the aligned slab gets unmapped again.
+* without mmap, the C runtime's aligned allocator is used after all.
+*/
+static void* tin_slab_mapaligned(TinState* state, size_t size)
+{
+#if defined(TIN_SLAB_USEMMAP)
+    uintptr_t base;
+    uintptr_t aligned;
+    uint8_t* region;
+    region = (uint8_t*)mmap(NULL, size + TIN_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED)
+    {
+        tin_state_raiseerror(state, RUNTIME_ERROR, "internal error: failed to allocate a slab of %zu bytes\n", size);
+        exit(111);
+    }
+    base = (uintptr_t)region;
+    aligned = (base + TIN_SLAB_SIZE - 1) & ~((uintptr_t)TIN_SLAB_SIZE - 1);
+    if(aligned > base)
+    {
+        munmap(region, aligned - base);
+    }
+    if(aligned + size < base + size + TIN_SLAB_SIZE)
+    {
+        munmap((void*)(aligned + size), (base + size + TIN_SLAB_SIZE) - (aligned + size));
+    }
+    return (void*)aligned;
+#else
+    void* region;
+    #if defined(TIN_OS_WINDOWS)
+        region = _aligned_malloc(size, TIN_SLAB_SIZE);
+    #else
+        /* aligned_alloc wants a multiple of the alignment */
+        region = aligned_alloc(TIN_SLAB_SIZE, (size + TIN_SLAB_SIZE - 1) & ~((size_t)TIN_SLAB_SIZE - 1));
     #endif
-    return obj;
+    if(region == NULL)
+    {
+        tin_state_raiseerror(state, RUNTIME_ERROR, "internal error: failed to allocate a slab of %zu bytes\n", size);
+        exit(111);
+    }
+    return region;
+#endif
 }
 
-void* tin_gcmem_memrealloc(TinState* state, void* pointer, size_t oldsize, size_t newsize)
+static void tin_slab_unmap(void* slab, size_t size)
+{
+#if defined(TIN_SLAB_USEMMAP)
+    munmap(slab, size);
+#elif defined(TIN_OS_WINDOWS)
+    (void)size;
+    _aligned_free(slab);
+#else
+    (void)size;
+    free(slab);
+#endif
+}
+
+static TinSlab* tin_slab_make(TinState* state, TinSlabClass* sc)
+{
+    size_t i;
+    uint8_t* cell;
+    TinSlab* slab;
+    if(state->gcspareslabs != NULL)
+    {
+        slab = state->gcspareslabs;
+        state->gcspareslabs = slab->next;
+        state->gcsparecount--;
+    }
+    else
+    {
+        slab = (TinSlab*)tin_slab_mapaligned(state, TIN_SLAB_SIZE);
+    }
+    slab->sizeclass = sc;
+    slab->mapsize = TIN_SLAB_SIZE;
+    slab->livecount = 0;
+    slab->freelist = NULL;
+    memset(slab->allocbits, 0, sizeof(slab->allocbits));
+    memset(slab->markbits, 0, sizeof(slab->markbits));
+    cell = ((uint8_t*)slab) + tin_slab_headersize();
+    /* link the cells back to front, so they are handed out in address order */
+    for(i = sc->cellsperslab; i > 0; i--)
+    {
+        *(void**)(cell + ((i - 1) * sc->cellsize)) = slab->freelist;
+        slab->freelist = cell + ((i - 1) * sc->cellsize);
+    }
+    sc->slabcount++;
+    tin_slab_link(&sc->partial, slab);
+    tin_slab_linkall(state, slab);
+    return slab;
+}
+
+void* tin_slab_allocate(TinState* state, size_t size)
+{
+    size_t bit;
+    void* cell;
+    TinSlab* slab;
+    TinSlabClass* sc;
+    if(size > TIN_SLAB_MAXSIZE)
+    {
+        slab = (TinSlab*)tin_slab_mapaligned(state, tin_slab_headersize() + size);
+        slab->sizeclass = NULL;
+        slab->mapsize = tin_slab_headersize() + size;
+        slab->livecount = 1;
+        slab->freelist = NULL;
+        slab->next = NULL;
+        slab->prev = NULL;
+        memset(slab->allocbits, 0, sizeof(slab->allocbits));
+        memset(slab->markbits, 0, sizeof(slab->markbits));
+        tin_slab_linkall(state, slab);
+        cell = ((uint8_t*)slab) + tin_slab_headersize();
+    }
+    else
+    {
+        sc = &state->gcslabs[(size - 1) / TIN_SLAB_GRANULARITY];
+        slab = sc->partial;
+        if(slab == NULL)
+        {
+            slab = tin_slab_make(state, sc);
+        }
+        cell = slab->freelist;
+        slab->freelist = *(void**)cell;
+        slab->livecount++;
+        if(slab->freelist == NULL)
+        {
+            tin_slab_unlink(&sc->partial, slab);
+            tin_slab_link(&sc->full, slab);
+        }
+        sc->livecount++;
+        sc->allocations++;
+    }
+    bit = tin_slab_bitof(cell);
+    slab->allocbits[bit / 64] |= ((uint64_t)1 << (bit % 64));
+    return cell;
+}
+
+void tin_slab_free(TinState* state, void* ptr)
+{
+    size_t bit;
+    TinSlab* slab;
+    TinSlabClass* sc;
+    slab = tin_slab_of(ptr);
+    sc = slab->sizeclass;
+    if(sc == NULL)
+    {
+        tin_slab_unlinkall(state, slab);
+        tin_slab_unmap(slab, slab->mapsize);
+        return;
+    }
+    bit = tin_slab_bitof(ptr);
+    slab->allocbits[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+    slab->markbits[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+    if(slab->freelist == NULL)
+    {
+        tin_slab_unlink(&sc->full, slab);
+        tin_slab_link(&sc->partial, slab);
+    }
+    *(void**)ptr = slab->freelist;
+    slab->freelist = ptr;
+    slab->livecount--;
+    sc->livecount--;
+}
+
+/*
+* takes the slabs that became empty during a sweep away from their size class.
+* up to TIN_SLAB_MAXSPARE of them are kept around for whatever class needs a new slab next;
+* the rest are given back to the system.
+*/
+void tin_slab_release(TinState* state)
+{
+    size_t i;
+    TinSlab* slab;
+    TinSlab* next;
+    TinSlabClass* sc;
+    for(i = 0; i < TIN_SLAB_CLASSCOUNT; i++)
+    {
+        sc = &state->gcslabs[i];
+        for(slab = sc->partial; slab != NULL; slab = next)
+        {
+            next = slab->next;
+            if(slab->livecount > 0)
+            {
+                continue;
+            }
+            tin_slab_unlink(&sc->partial, slab);
+            tin_slab_unlinkall(state, slab);
+            sc->slabcount--;
+            if(state->gcsparecount < TIN_SLAB_MAXSPARE)
+            {
+                slab->next = state->gcspareslabs;
+                state->gcspareslabs = slab;
+                state->gcsparecount++;
+            }
+            else
+            {
+                tin_slab_unmap(slab, TIN_SLAB_SIZE);
+            }
+        }
+    }
+}
+
+/*
+* calls $fn for every object in $slab whose bit is set in $bits.
+* the bits are read a word at a time before $fn runs, so $fn may free the object.
+*/
+static void tin_slab_foreach(TinState* state, TinSlab* slab, uint64_t* bits, void(*fn)(TinState*, TinObject*))
+{
+    size_t i;
+    size_t bit;
+    uint64_t word;
+    for(i = 0; i < TIN_SLAB_BITMAPWORDS; i++)
+    {
+        word = bits[i];
+        while(word != 0)
+        {
+            bit = (i * 64) + (size_t)__builtin_ctzll(word);
+            word &= word - 1;
+            fn(state, (TinObject*)(((uint8_t*)slab) + (bit * TIN_SLAB_GRANULARITY)));
+        }
+    }
+}
+
+/* destroys every object that is still allocated; only for tin_vm_destroy */
+void tin_slab_destroyobjects(TinState* state)
+{
+    uint64_t bits[TIN_SLAB_BITMAPWORDS];
+    TinSlab* slab;
+    TinSlab* next;
+    for(slab = state->gcallslabs; slab != NULL; slab = next)
+    {
+        next = slab->allnext;
+        memcpy(bits, slab->allocbits, sizeof(bits));
+        tin_slab_foreach(state, slab, bits, tin_object_destroy);
+    }
+}
+
+/* frees every slab, whether it has cells in use or not; only for tin_state_destroy */
+void tin_slab_destroy(TinState* state)
+{
+    TinSlab* slab;
+    TinSlab* next;
+    for(slab = state->gcallslabs; slab != NULL; slab = next)
+    {
+        next = slab->allnext;
+        tin_slab_unmap(slab, slab->mapsize);
+    }
+    for(slab = state->gcspareslabs; slab != NULL; slab = next)
+    {
+        next = slab->next;
+        tin_slab_unmap(slab, TIN_SLAB_SIZE);
+    }
+    tin_slab_init(state);
+}
+
+/* accounts for an allocation of $newsize bytes (that used to be $oldsize), and collects garbage if it's time */
+static void tin_gcmem_account(TinState* state, size_t oldsize, size_t newsize)
 {
-    void* ptr;
-    ptr = NULL;
     state->gcbytescount += (int64_t)newsize - (int64_t)oldsize;
     if(newsize > oldsize)
     {
@@ -60,6 +421,70 @@ void* tin_gcmem_memrealloc(TinState* state, void* pointer, size_t oldsize, size_
             tin_gcmem_collectgarbage(state->vm);
         }
     }
+}
+
+static void tin_gcmem_pushobject(TinObject*** list, size_t* count, size_t* capacity, TinObject* object)
+{
+    if(*capacity < *count + 1)
+    {
+        *capacity = TIN_GCMEM_GROWCAPACITY(*capacity);
+        *list = (TinObject**)realloc(*list, sizeof(TinObject*) * (*capacity));
+    }
+    (*list)[(*count)++] = object;
+}
+
+static bool tin_gcmem_iswatched(TinObjType type)
+{
+    switch(type)
+    {
+        case TINTYPE_FIBER:
+        case TINTYPE_MODULE:
+        case TINTYPE_CLASS:
+        case TINTYPE_FUNCTION:
+        case TINTYPE_REFERENCE:
+        case TINTYPE_USERDATA:
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+TinObject* tin_object_allocobject(TinState* state, size_t size, TinObjType type, bool islight)
+{
+    TinObject* obj;
+    TinVM* vm;
+    (void)islight;
+    vm = state->vm;
+    tin_gcmem_account(state, 0, size);
+    obj = (TinObject*)tin_slab_allocate(state, size);
+    obj->mustfree = true;
+    obj->type = type;
+    obj->remembered = false;
+    if(tin_gcmem_iswatched(type))
+    {
+        /* never goes through the remembered set, since it's scanned anyway */
+        obj->remembered = true;
+        tin_gcmem_pushobject(&vm->gcwatched, &vm->gcwatchedcount, &vm->gcwatchedcap, obj);
+    }
+    #ifdef TIN_LOG_ALLOCATION
+        fprintf(stderr, "%p allocate %ld for %s\n", (void*)obj, size, tin_tostring_typename(type));
+    #endif
+    return obj;
+}
+
+/* the counterpart to tin_object_allocobject: $size must be what the object was allocated with */
+void tin_gcmem_freeobject(TinState* state, size_t size, void* ptr)
+{
+    tin_gcmem_account(state, size, 0);
+    tin_slab_free(state, ptr);
+}
+
+void* tin_gcmem_memrealloc(TinState* state, void* pointer, size_t oldsize, size_t newsize)
+{
+    void* ptr;
+    ptr = NULL;
+    tin_gcmem_account(state, oldsize, newsize);
     if(newsize == 0)
     {
         free(pointer);
@@ -94,11 +519,93 @@ void tin_gcmem_freearray(TinState* state, size_t tsz, void* ptr, size_t ocount)
     tin_gcmem_memrealloc(state, ptr, tsz * ocount, 0);
 }
 
+void tin_gcmem_barrierobject(TinState* state, TinObject* owner, TinObject* child)
+{
+    TinVM* vm;
+    /* only old objects (marked) that aren't remembered yet, pointing to young objects (not marked), matter */
+    if(owner == NULL || child == NULL || owner->remembered || !tin_slab_ismarked(owner) || tin_slab_ismarked(child))
+    {
+        return;
+    }
+    vm = state->vm;
+    owner->remembered = true;
+    tin_gcmem_pushobject(&vm->gcremembered, &vm->gcrememberedcount, &vm->gcrememberedcap, owner);
+}
+
+void tin_gcmem_writebarrier(TinState* state, TinObject* owner, TinValue value)
+{
+    if(tin_value_isobject(value))
+    {
+        tin_gcmem_barrierobject(state, owner, tin_value_asobject(value));
+    }
+}
+
+#if defined(TIN_GC_PARALLELMARK)
+/*
+* parallel marking, used when state->gcmarkthreads is bigger than 1.
+*
+* the collecting thread and gcmarkthreads - 1 pool threads each drain a gray stack of their own.
+* mark bits are set with an atomic or, so every object is claimed (and blackened) by exactly one worker.
+* a worker whose stack grows past TIN_GC_SHAREMIN moves half of it to its shared stack, where idle
+* workers can steal it from; marking is done once every worker is idle and no shared stack has any work.
+*
+* blackening only reads the heap, except for userdata, whose cleanupfn may do anything:
+* those are deferred, and handled by the collecting thread once the workers are done.
+*/
+#define TIN_GC_SHAREMIN 64
+
+typedef struct TinGCWorker TinGCWorker;
+
+struct TinGCWorker
+{
+    TinGCPool* pool;
+    pthread_t thread;
+    /* only ever touched by the worker itself */
+    TinObject** stack;
+    size_t count;
+    size_t capacity;
+    /* may be stolen from by other workers, under $lock */
+    pthread_mutex_t lock;
+    TinObject** shared;
+    size_t sharedcount;
+    size_t sharedcapacity;
+    /* userdata that still need their cleanupfn called */
+    TinObject** deferred;
+    size_t deferredcount;
+    size_t deferredcapacity;
+};
+
+struct TinGCPool
+{
+    TinVM* vm;
+    /* workers[0] is the collecting thread, the others have a pthread each */
+    TinGCWorker* workers;
+    size_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    /* bumped for every collection, which is what the pool threads wait for */
+    uint64_t round;
+    size_t finished;
+    bool quit;
+    /* workers that ran out of work; accessed atomically */
+    size_t idle;
+};
+
+/* the worker of the current thread, while marking in parallel */
+static __thread TinGCWorker* tin_gcmem_worker = NULL;
+
+static void tin_gcworker_push(TinGCWorker* worker, TinObject* object)
+{
+    tin_gcmem_pushobject(&worker->stack, &worker->count, &worker->capacity, object);
+}
+#endif
+
 void tin_gcmem_marktable(TinVM* vm, TinTable* table)
 {
     int i;
     TinTabEntry* entry;
-    for(i = 0; i <= tin_table_getcapacity(table); i++)
+    for(i = 0; i < (int)tin_table_getcapacity(table); i++)
     {
         entry = tin_table_getindex(table, i);
         tin_gcmem_markobject(vm, (TinObject*)entry->key);
@@ -108,18 +615,46 @@ void tin_gcmem_marktable(TinVM* vm, TinTable* table)
 
 void tin_gcmem_markobject(TinVM* vm, TinObject* object)
 {
-    if(object == NULL || object->marked)
+    size_t bit;
+    uint64_t mask;
+    uint64_t* word;
+    if(object == NULL)
     {
         return;
     }
-
-    object->marked = true;
-
+    bit = tin_slab_bitof(object);
+    word = &tin_slab_of(object)->markbits[bit / 64];
+    mask = (uint64_t)1 << (bit % 64);
+#if defined(TIN_GC_PARALLELMARK)
+    /* relaxed, because mark threads may be setting other bits of the same word */
+    if(__atomic_load_n(word, __ATOMIC_RELAXED) & mask)
+    {
+        return;
+    }
+#else
+    if(*word & mask)
+    {
+        return;
+    }
+#endif
 #ifdef TIN_LOG_MARKING
     printf("%p mark ", (void*)object);
     tin_towriter_value(tin_value_fromobject(object));
     printf("\n");
 #endif
+#if defined(TIN_GC_PARALLELMARK)
+    if(tin_gcmem_worker != NULL)
+    {
+        /* another worker may have claimed it since the check above */
+        if(__atomic_fetch_or(word, mask, __ATOMIC_RELAXED) & mask)
+        {
+            return;
+        }
+        tin_gcworker_push(tin_gcmem_worker, object);
+        return;
+    }
+#endif
+    *word |= mask;
     if(vm->gcgraycapacity < vm->gcgraycount + 1)
     {
         vm->gcgraycapacity = TIN_GCMEM_GROWCAPACITY(vm->gcgraycapacity);
@@ -139,6 +674,7 @@ void tin_gcmem_markvalue(TinVM* vm, TinValue value)
 void tin_gcmem_vmmarkroots(TinVM* vm)
 {
     size_t i;
+    TinImage* image;
     TinState* state;
     state = vm->state;
     for(i = 0; i < state->gcrootcount; i++)
@@ -157,11 +693,30 @@ void tin_gcmem_vmmarkroots(TinVM* vm)
     tin_gcmem_markobject(vm, (TinObject*)state->primarrayclass);
     tin_gcmem_markobject(vm, (TinObject*)state->primmapclass);
     tin_gcmem_markobject(vm, (TinObject*)state->primrangeclass);
+    tin_gcmem_markobject(vm, (TinObject*)state->primfloat64arrayclass);
+    tin_gcmem_markobject(vm, (TinObject*)state->primint64arrayclass);
+    tin_gcmem_markobject(vm, (TinObject*)state->primstringbuilderclass);
     tin_gcmem_markobject(vm, (TinObject*)state->capiname);
+    for(i = 0; i < TINSYM_TOTAL; i++)
+    {
+        tin_gcmem_markobject(vm, (TinObject*)state->symbols[i]);
+    }
     tin_gcmem_markobject(vm, (TinObject*)state->capifunction);
     tin_gcmem_markobject(vm, (TinObject*)state->capifiber);
+    for(image = state->images; image != NULL; image = image->next)
+    {
+        for(i = 0; i < image->stringcount; i++)
+        {
+            tin_gcmem_markobject(vm, (TinObject*)image->strings[i]);
+        }
+    }
     tin_gcmem_marktable(vm, &vm->modules->values);
     tin_gcmem_marktable(vm, &vm->globals->values);
+    tin_gcmem_marktable(vm, &vm->globalslots);
+    for(i = 0; i < vm->globalcount; i++)
+    {
+        tin_gcmem_markvalue(vm, *vm->globalcells[i]);
+    }
 }
 
 void tin_gcmem_markvallist(TinVM* vm, TinValList* array)
@@ -194,6 +749,8 @@ void tin_gcmem_vmblackobject(TinVM* vm, TinObject* object)
         case TINTYPE_NATIVEMETHOD:
         case TINTYPE_PRIMITIVEMETHOD:
         case TINTYPE_RANGE:
+        case TINTYPE_TYPEDARRAY:
+        case TINTYPE_STRINGBUILDER:
         case TINTYPE_STRING:
         case TINTYPE_NUMBER:
             {
@@ -205,6 +762,13 @@ void tin_gcmem_vmblackobject(TinVM* vm, TinObject* object)
                 data = (TinUserdata*)object;
                 if(data->cleanupfn != NULL)
                 {
+#if defined(TIN_GC_PARALLELMARK)
+                    if(tin_gcmem_worker != NULL)
+                    {
+                        tin_gcmem_pushobject(&tin_gcmem_worker->deferred, &tin_gcmem_worker->deferredcount, &tin_gcmem_worker->deferredcapacity, object);
+                        break;
+                    }
+#endif
                     data->cleanupfn(vm->state, data, true);
                 }
             }
@@ -291,13 +855,14 @@ void tin_gcmem_vmblackobject(TinVM* vm, TinObject* object)
                 tin_gcmem_markobject(vm, (TinObject*)klass->parentclass);
                 tin_gcmem_marktable(vm, &klass->methods);
                 tin_gcmem_marktable(vm, &klass->staticfields);
+                tin_shape_mark(vm, klass->rootshape);
             }
             break;
         case TINTYPE_INSTANCE:
             {
                 TinInstance* instance = (TinInstance*)object;
                 tin_gcmem_markobject(vm, (TinObject*)instance->klass);
-                tin_gcmem_marktable(vm, &instance->fields);
+                tin_instance_markfields(vm, instance);
             }
             break;
         case TINTYPE_BOUNDMETHOD:
@@ -346,9 +911,287 @@ void tin_gcmem_vmblackobject(TinVM* vm, TinObject* object)
     }
 }
 
+#if defined(TIN_GC_PARALLELMARK)
+/* moves the older half of the stack of $worker to its shared stack, if that one ran dry */
+static void tin_gcworker_share(TinGCWorker* worker)
+{
+    size_t half;
+    if(worker->count < TIN_GC_SHAREMIN || __atomic_load_n(&worker->sharedcount, __ATOMIC_RELAXED) != 0)
+    {
+        return;
+    }
+    half = worker->count / 2;
+    pthread_mutex_lock(&worker->lock);
+    if(worker->sharedcapacity < half)
+    {
+        worker->sharedcapacity = half;
+        worker->shared = (TinObject**)realloc(worker->shared, sizeof(TinObject*) * half);
+    }
+    memcpy(worker->shared, worker->stack, sizeof(TinObject*) * half);
+    memmove(worker->stack, worker->stack + half, sizeof(TinObject*) * (worker->count - half));
+    worker->count -= half;
+    __atomic_store_n(&worker->sharedcount, half, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/* moves everything on the shared stack of $from onto the stack of $worker */
+static bool tin_gcworker_take(TinGCWorker* worker, TinGCWorker* from)
+{
+    size_t i;
+    size_t count;
+    if(__atomic_load_n(&from->sharedcount, __ATOMIC_RELAXED) == 0)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&from->lock);
+    count = from->sharedcount;
+    for(i = 0; i < count; i++)
+    {
+        tin_gcworker_push(worker, from->shared[i]);
+    }
+    __atomic_store_n(&from->sharedcount, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&from->lock);
+    return count > 0;
+}
+
+static bool tin_gcworker_steal(TinGCWorker* worker)
+{
+    size_t i;
+    TinGCPool* pool;
+    pool = worker->pool;
+    /* own shared work first, then whoever has some */
+    if(tin_gcworker_take(worker, worker))
+    {
+        return true;
+    }
+    for(i = 0; i < pool->count; i++)
+    {
+        if(&pool->workers[i] != worker && tin_gcworker_take(worker, &pool->workers[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool tin_gcpool_hasshared(TinGCPool* pool)
+{
+    size_t i;
+    for(i = 0; i < pool->count; i++)
+    {
+        if(__atomic_load_n(&pool->workers[i].sharedcount, __ATOMIC_RELAXED) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void tin_gcworker_drain(TinGCWorker* worker)
+{
+    TinVM* vm;
+    TinGCPool* pool;
+    pool = worker->pool;
+    vm = pool->vm;
+    tin_gcmem_worker = worker;
+    while(true)
+    {
+        while(worker->count > 0)
+        {
+            tin_gcmem_vmblackobject(vm, worker->stack[--worker->count]);
+            tin_gcworker_share(worker);
+        }
+        if(tin_gcworker_steal(worker))
+        {
+            continue;
+        }
+        /*
+        * an idle worker has nothing on either of its stacks, and nobody else can put anything there.
+        * so once all of them are idle, everything reachable is marked.
+        */
+        __atomic_add_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+        while(true)
+        {
+            if(__atomic_load_n(&pool->idle, __ATOMIC_SEQ_CST) == pool->count)
+            {
+                tin_gcmem_worker = NULL;
+                return;
+            }
+            if(tin_gcpool_hasshared(pool))
+            {
+                __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+static void* tin_gcpool_threadmain(void* arg)
+{
+    uint64_t round;
+    TinGCPool* pool;
+    TinGCWorker* worker;
+    worker = (TinGCWorker*)arg;
+    pool = worker->pool;
+    round = 0;
+    while(true)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while(pool->round == round && !pool->quit)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        round = pool->round;
+        if(pool->quit)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        tin_gcworker_drain(worker);
+        pthread_mutex_lock(&pool->lock);
+        pool->finished++;
+        if(pool->finished == pool->count - 1)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+static void tin_gcpool_destroyworker(TinGCWorker* worker)
+{
+    pthread_mutex_destroy(&worker->lock);
+    free(worker->stack);
+    free(worker->shared);
+    free(worker->deferred);
+}
+
+static TinGCPool* tin_gcpool_make(TinVM* vm, size_t count)
+{
+    size_t i;
+    TinGCPool* pool;
+    TinGCWorker* worker;
+    pool = (TinGCPool*)calloc(1, sizeof(TinGCPool));
+    pool->vm = vm;
+    pool->workers = (TinGCWorker*)calloc(count, sizeof(TinGCWorker));
+    pool->count = count;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for(i = 0; i < count; i++)
+    {
+        worker = &pool->workers[i];
+        worker->pool = pool;
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+    for(i = 1; i < count; i++)
+    {
+        worker = &pool->workers[i];
+        if(pthread_create(&worker->thread, NULL, tin_gcpool_threadmain, worker) != 0)
+        {
+            /* make do with the threads there are */
+            tin_gcpool_destroyworker(worker);
+            pool->count = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void tin_gcpool_destroy(TinVM* vm)
+{
+    size_t i;
+    TinGCPool* pool;
+    pool = vm->gcpool;
+    if(pool == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for(i = 1; i < pool->count; i++)
+    {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    for(i = 0; i < pool->count; i++)
+    {
+        tin_gcpool_destroyworker(&pool->workers[i]);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool);
+    vm->gcpool = NULL;
+}
+
+/* marks everything reachable from the gray stack of $vm, using the pool; leaves the deferred userdata on the gray stack */
+static void tin_gcmem_paralleltrace(TinVM* vm)
+{
+    size_t i;
+    size_t j;
+    TinGCPool* pool;
+    TinGCWorker* worker;
+    if(vm->gcpool != NULL && vm->gcpool->count != vm->state->gcmarkthreads)
+    {
+        tin_gcpool_destroy(vm);
+    }
+    if(vm->gcpool == NULL)
+    {
+        vm->gcpool = tin_gcpool_make(vm, vm->state->gcmarkthreads);
+    }
+    pool = vm->gcpool;
+    worker = &pool->workers[0];
+    for(i = 0; i < vm->gcgraycount; i++)
+    {
+        tin_gcworker_push(worker, vm->gcgraystack[i]);
+    }
+    vm->gcgraycount = 0;
+    tin_gcworker_share(worker);
+    pool->idle = 0;
+    pthread_mutex_lock(&pool->lock);
+    pool->finished = 0;
+    pool->round++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    tin_gcworker_drain(worker);
+    pthread_mutex_lock(&pool->lock);
+    while(pool->finished < pool->count - 1)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    for(i = 0; i < pool->count; i++)
+    {
+        worker = &pool->workers[i];
+        for(j = 0; j < worker->deferredcount; j++)
+        {
+            tin_gcmem_pushobject(&vm->gcgraystack, &vm->gcgraycount, &vm->gcgraycapacity, worker->deferred[j]);
+        }
+        worker->deferredcount = 0;
+    }
+}
+#else
+void tin_gcpool_destroy(TinVM* vm)
+{
+    (void)vm;
+}
+#endif
+
 void tin_gcmem_vmtracerefs(TinVM* vm)
 {
     TinObject* object;
+#if defined(TIN_GC_PARALLELMARK)
+    if(vm->state->gcmarkthreads > 1 && vm->gcgraycount > 0)
+    {
+        tin_gcmem_paralleltrace(vm);
+    }
+#endif
     while(vm->gcgraycount > 0)
     {
         object = vm->gcgraystack[--vm->gcgraycount];
@@ -356,68 +1199,154 @@ void tin_gcmem_vmtracerefs(TinVM* vm)
     }
 }
 
+/* drops watched objects that did not survive from vm->gcwatched; called between marking and sweeping */
+static void tin_gcmem_vmpurgewatched(TinVM* vm)
+{
+    size_t i;
+    size_t kept;
+    kept = 0;
+    for(i = 0; i < vm->gcwatchedcount; i++)
+    {
+        if(tin_slab_ismarked(vm->gcwatched[i]))
+        {
+            vm->gcwatched[kept++] = vm->gcwatched[i];
+        }
+    }
+    vm->gcwatchedcount = kept;
+}
+
+/* frees every allocated object whose mark bit is clear; whatever is left is old from now on */
 void tin_gcmem_vmsweep(TinVM* vm)
 {
-    TinObject* unreached;
-    TinObject* previous;
-    TinObject* object;
-    previous = NULL;
-    object = vm->gcobjects;
-    while(object != NULL)
+    size_t i;
+    uint64_t dead[TIN_SLAB_BITMAPWORDS];
+    TinSlab* slab;
+    TinSlab* next;
+    for(slab = vm->state->gcallslabs; slab != NULL; slab = next)
     {
-        if(object->marked)
+        next = slab->allnext;
+        for(i = 0; i < TIN_SLAB_BITMAPWORDS; i++)
         {
-            object->marked = false;
-            previous = object;
-            object = object->next;
+            dead[i] = slab->allocbits[i] & ~slab->markbits[i];
         }
-        else
+        tin_slab_foreach(vm->state, slab, dead, tin_object_destroy);
+    }
+}
+
+static void tin_gcmem_vmminor(TinVM* vm)
+{
+    size_t i;
+    TinObject* object;
+    tin_gcmem_vmmarkroots(vm);
+    for(i = 0; i < vm->gcwatchedcount; i++)
+    {
+        /* young ones get traced if they're reachable at all */
+        if(tin_slab_ismarked(vm->gcwatched[i]))
         {
-            unreached = object;
-            object = object->next;
-            if(previous != NULL)
-            {
-                previous->next = object;
-            }
-            else
-            {
-                vm->gcobjects = object;
-            }
-            tin_object_destroy(vm->state, unreached);
+            tin_gcmem_vmblackobject(vm, vm->gcwatched[i]);
         }
     }
+    for(i = 0; i < vm->gcrememberedcount; i++)
+    {
+        object = vm->gcremembered[i];
+        object->remembered = false;
+        tin_gcmem_vmblackobject(vm, object);
+    }
+    vm->gcrememberedcount = 0;
+    tin_gcmem_vmtracerefs(vm);
+    tin_strreg_remwhite(vm->state);
+    tin_gcmem_vmpurgewatched(vm);
+    tin_gcmem_vmsweep(vm);
 }
 
-uint64_t tin_gcmem_collectgarbage(TinVM* vm)
+static void tin_gcmem_vmmajor(TinVM* vm)
+{
+    size_t i;
+    TinSlab* slab;
+    for(i = 0; i < vm->gcrememberedcount; i++)
+    {
+        vm->gcremembered[i]->remembered = false;
+    }
+    vm->gcrememberedcount = 0;
+    for(slab = vm->state->gcallslabs; slab != NULL; slab = slab->allnext)
+    {
+        memset(slab->markbits, 0, sizeof(slab->markbits));
+    }
+    tin_gcmem_vmmarkroots(vm);
+    tin_gcmem_vmtracerefs(vm);
+    tin_strreg_remwhite(vm->state);
+    tin_gcmem_vmpurgewatched(vm);
+    tin_gcmem_vmsweep(vm);
+}
+
+/* wall clock time in seconds; clock() would add up the time of all mark threads */
+static double tin_gcmem_now()
 {
-    clock_t t;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static uint64_t tin_gcmem_collect(TinVM* vm, bool major)
+{
+    double t;
+    double pause;
     uint64_t before;
     uint64_t collected;
-    (void)t;
-    if(!vm->state->gcallow)
+    TinState* state;
+    state = vm->state;
+    if(!state->gcallow)
     {
         return 0;
     }
-    vm->state->gcallow = false;
-    before = vm->state->gcbytescount;
+    state->gcallow = false;
+    /* so the map doesn't keep values alive that its cells no longer hold */
+    tin_vm_syncglobals(vm);
+    before = state->gcbytescount;
 #ifdef TIN_LOG_GC
-    printf("-- gc begin\n");
-    t = clock();
+    printf("-- gc begin (%s)\n", major ? "major" : "minor");
 #endif
-    tin_gcmem_vmmarkroots(vm);
-    tin_gcmem_vmtracerefs(vm);
-    tin_strreg_remwhite(vm->state);
-    tin_gcmem_vmsweep(vm);
-    vm->state->gcnext = vm->state->gcbytescount * TIN_GC_HEAP_GROW_FACTOR;
-    vm->state->gcallow = true;
-    collected = before - vm->state->gcbytescount;
+    t = tin_gcmem_now();
+    if(major)
+    {
+        tin_gcmem_vmmajor(vm);
+        state->gcmajorcount++;
+        state->gcmajornext = state->gcbytescount * TIN_GC_HEAP_GROW_FACTOR;
+    }
+    else
+    {
+        tin_gcmem_vmminor(vm);
+        state->gcminorcount++;
+    }
+    tin_slab_release(state);
+    state->gcoldbytes = state->gcbytescount;
+    state->gcnext = state->gcbytescount + TIN_GC_NURSERY_SIZE;
+    pause = tin_gcmem_now() - t;
+    state->gclastpause = pause;
+    state->gctotalpause += pause;
+    if(pause > state->gcmaxpause)
+    {
+        state->gcmaxpause = pause;
+    }
+    state->gcallow = true;
+    collected = before - state->gcbytescount;
 #ifdef TIN_LOG_GC
-    printf("-- gc end. Collected %imb in %gms\n", ((int)((collected / 1024.0 + 0.5) / 10)) * 10,
-           (double)(clock() - t) / CLOCKS_PER_SEC * 1000);
+    printf("-- gc end. Collected %imb in %gms\n", ((int)((collected / 1024.0 + 0.5) / 10)) * 10, pause * 1000);
 #endif
     return collected;
 }
 
+/* called when the nursery is full; does a major collection once the old generation grew enough */
+uint64_t tin_gcmem_collectgarbage(TinVM* vm)
+{
+    return tin_gcmem_collect(vm, vm->state->gcoldbytes > vm->state->gcmajornext);
+}
+
+uint64_t tin_gcmem_collectfull(TinVM* vm)
+{
+    return tin_gcmem_collect(vm, true);
+}
+
 static TinValue objfn_gc_memory_used(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
 {
     (void)instance;
@@ -434,6 +1363,133 @@ static TinValue objfn_gc_next_round(TinVM* vm, TinValue instance, size_t arg_cou
     return tin_value_makefixednumber(vm->state, vm->state->gcnext);
 }
 
+static TinValue objfn_gc_last_pause(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefloatnumber(vm->state, vm->state->gclastpause);
+}
+
+static TinValue objfn_gc_max_pause(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefloatnumber(vm->state, vm->state->gcmaxpause);
+}
+
+static TinValue objfn_gc_total_pause(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefloatnumber(vm->state, vm->state->gctotalpause);
+}
+
+static TinValue objfn_gc_minor_collections(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefixednumber(vm->state, vm->state->gcminorcount);
+}
+
+static TinValue objfn_gc_major_collections(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefixednumber(vm->state, vm->state->gcmajorcount);
+}
+
+static TinValue objfn_gc_mark_threads(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    return tin_value_makefixednumber(vm->state, vm->state->gcmarkthreads);
+}
+
+/* takes effect with the next collection */
+static TinValue objfn_gc_set_mark_threads(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    double count;
+    (void)instance;
+    count = tin_args_checknumber(vm, args, arg_count, 0);
+    if(count < 1)
+    {
+        count = 1;
+    }
+    else if(count > TIN_GC_MAXMARKTHREADS)
+    {
+        count = TIN_GC_MAXMARKTHREADS;
+    }
+    vm->state->gcmarkthreads = (size_t)count;
+    return tin_value_makefixednumber(vm->state, vm->state->gcmarkthreads);
+}
+
+static TinValue objfn_gc_reset_stats(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    vm->state->gcminorcount = 0;
+    vm->state->gcmajorcount = 0;
+    vm->state->gclastpause = 0;
+    vm->state->gcmaxpause = 0;
+    vm->state->gctotalpause = 0;
+    return tin_value_makenull(vm->state);
+}
+
+/* one map per size class that is or was in use: cellSize, live, bytes, allocations, slabs */
+static TinValue objfn_gc_size_classes(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    size_t i;
+    TinMap* map;
+    TinArray* array;
+    TinState* state;
+    TinSlabClass* sc;
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    state = vm->state;
+    array = tin_object_makearray(state);
+    tin_state_pushroot(state, (TinObject*)array);
+    for(i = 0; i < TIN_SLAB_CLASSCOUNT; i++)
+    {
+        sc = &state->gcslabs[i];
+        if(sc->allocations == 0)
+        {
+            continue;
+        }
+        map = tin_object_makemap(state);
+        tin_vallist_push(state, &array->list, tin_value_fromobject(map));
+        tin_map_setstr(state, map, "cellSize", tin_value_makefixednumber(state, sc->cellsize));
+        tin_map_setstr(state, map, "live", tin_value_makefixednumber(state, sc->livecount));
+        tin_map_setstr(state, map, "bytes", tin_value_makefixednumber(state, sc->livecount * sc->cellsize));
+        tin_map_setstr(state, map, "allocations", tin_value_makefixednumber(state, sc->allocations));
+        tin_map_setstr(state, map, "slabs", tin_value_makefixednumber(state, sc->slabcount));
+    }
+    tin_state_poproots(state, 1);
+    return tin_value_fromobject(array);
+}
+
+static TinValue objfn_gc_slab_bytes(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
+{
+    size_t i;
+    size_t total;
+    (void)instance;
+    (void)arg_count;
+    (void)args;
+    total = 0;
+    for(i = 0; i < TIN_SLAB_CLASSCOUNT; i++)
+    {
+        total += vm->state->gcslabs[i].slabcount * TIN_SLAB_SIZE;
+    }
+    return tin_value_makefixednumber(vm->state, total);
+}
+
 static TinValue objfn_gc_trigger(TinVM* vm, TinValue instance, size_t arg_count, TinValue* args)
 {
     (void)instance;
@@ -441,7 +1497,7 @@ static TinValue objfn_gc_trigger(TinVM* vm, TinValue instance, size_t arg_count,
     (void)args;
     int64_t collected;
     vm->state->gcallow = true;
-    collected = tin_gcmem_collectgarbage(vm);
+    collected = tin_gcmem_collectfull(vm);
     vm->state->gcallow = false;
     return tin_value_makefixednumber(vm->state, collected);
 }
@@ -453,7 +1509,16 @@ void tin_open_gc_library(TinState* state)
     {
         tin_class_bindgetset(state, klass, "memoryUsed", objfn_gc_memory_used, NULL, true);
         tin_class_bindgetset(state, klass, "nextRound", objfn_gc_next_round, NULL, true);
+        tin_class_bindgetset(state, klass, "lastPause", objfn_gc_last_pause, NULL, true);
+        tin_class_bindgetset(state, klass, "maxPause", objfn_gc_max_pause, NULL, true);
+        tin_class_bindgetset(state, klass, "totalPause", objfn_gc_total_pause, NULL, true);
+        tin_class_bindgetset(state, klass, "minorCollections", objfn_gc_minor_collections, NULL, true);
+        tin_class_bindgetset(state, klass, "majorCollections", objfn_gc_major_collections, NULL, true);
+        tin_class_bindgetset(state, klass, "sizeClasses", objfn_gc_size_classes, NULL, true);
+        tin_class_bindgetset(state, klass, "slabBytes", objfn_gc_slab_bytes, NULL, true);
+        tin_class_bindgetset(state, klass, "markThreads", objfn_gc_mark_threads, objfn_gc_set_mark_threads, true);
         tin_class_bindstaticmethod(state, klass, "trigger", objfn_gc_trigger);
+        tin_class_bindstaticmethod(state, klass, "resetStats", objfn_gc_reset_stats);
     }
     tin_state_setglobal(state, klass->name, tin_value_fromobject(klass));
     if(klass->parentclass == NULL)
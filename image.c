@@ -0,0 +1,897 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "priv.h"
+#include "sds.h"
+
+#if defined(TIN_OS_UNIXLIKE)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define TIN_IMAGE_USEMMAP
+#elif defined(TIN_OS_WINDOWS)
+    #include <direct.h>
+    #include <process.h>
+#endif
+
+/*
+* bytecode images, as written by tin_state_compileandsave.
+*
+* an image is laid out so that it can be mapped from a file and used without being parsed:
+*
+*   TinImageHeader
+*   TinImageString[stringcount]    offset/length/hash of every string; the bytes follow, NUL terminated
+*   TinImageModule[modulecount]    the first module is the one that gets run
+*   uint32_t[functioncount]        offset of every TinImageFunction, relative to the blob
+*   blob                           function records, their code, line tables and constants
+*
+* all integers are in native byte order, and every section starts at a multiple of 8.
+* $checksum covers everything after the header.
+*
+* loading an image checks it, makes all of its strings in one pass (they are gc roots from then on),
+* and makes the modules, whose functions are only headers at that point: the body of a function (its
+* constants, and so the functions nested in it) is read on its first call, see tin_image_loadfunction.
+* code is used in place; mapping the file privately lets quickening rewrite it without touching the file.
+*
+* strings are stored with their hash, so bump TIN_BYTECODE_VERSION whenever tin_util_hashstring changes.
+*
+* the compilation cache (see tin_image_loadcached) stores plain images, one per script, whose header
+* also records the source and the optimizations they were compiled from.
+*/
+
+#define TIN_IMAGE_NONE UINT32_MAX
+#define TIN_IMAGE_ALIGN 8
+
+typedef struct TinImageHeader TinImageHeader;
+typedef struct TinImageString TinImageString;
+typedef struct TinImageModule TinImageModule;
+typedef struct TinImageFunction TinImageFunction;
+typedef struct TinImageConst TinImageConst;
+typedef struct TinImageWriter TinImageWriter;
+
+enum
+{
+    TIN_IMAGE_CONSTFLOAT,
+    TIN_IMAGE_CONSTINT,
+    TIN_IMAGE_CONSTSTRING,
+    TIN_IMAGE_CONSTFUNCTION,
+};
+
+struct TinImageHeader
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint32_t checksum;
+    uint32_t size;
+    uint32_t stringcount;
+    uint32_t stringoffset;
+    uint32_t modulecount;
+    uint32_t moduleoffset;
+    uint32_t functioncount;
+    uint32_t functionoffset;
+    uint32_t bloboffset;
+    uint32_t bloblength;
+    /* what a cache entry was compiled from; all 0 for images written by tin_image_write */
+    uint32_t sourcehash;
+    uint32_t sourcelength;
+    uint32_t optflags;
+};
+
+struct TinImageString
+{
+    uint32_t offset;
+    uint32_t length;
+    uint32_t hash;
+    uint32_t reserved;
+};
+
+struct TinImageModule
+{
+    /* string indices */
+    uint32_t name;
+    /* function index of the main function */
+    uint32_t function;
+    uint32_t privcount;
+    /* how many (name, index) pairs of uint32_t there are at $privoffset. 0 if the names were optimized away */
+    uint32_t privnamecount;
+    uint32_t privoffset;
+    uint32_t reserved;
+};
+
+/* offsets in here are relative to the blob */
+struct TinImageFunction
+{
+    uint32_t name;
+    uint32_t maxslots;
+    uint16_t upvalcount;
+    uint8_t argcount;
+    uint8_t vararg;
+    uint32_t icachecount;
+    uint32_t codelength;
+    uint32_t codeoffset;
+    /* how many bytes the line table (see tin_chunk_push) has; 0 if there is none */
+    uint32_t linelength;
+    uint32_t lineoffset;
+    uint32_t constcount;
+    uint32_t constoffset;
+};
+
+struct TinImageConst
+{
+    uint32_t kind;
+    /* string or function index */
+    uint32_t index;
+    union
+    {
+        double floatval;
+        int64_t fixedval;
+    } number;
+};
+
+struct TinImageWriter
+{
+    TinState* state;
+    /* the strings in index order, and their indices (as numbers) by string */
+    TinString** strings;
+    size_t stringcount;
+    size_t stringcap;
+    TinTable stringindex;
+    /* function records and everything they refer to */
+    char* blob;
+    /* blob offsets of the function records, in index order */
+    uint32_t* functions;
+    size_t functioncount;
+    size_t functioncap;
+};
+
+static size_t tin_image_alignup(size_t value)
+{
+    return (value + (TIN_IMAGE_ALIGN - 1)) & ~(size_t)(TIN_IMAGE_ALIGN - 1);
+}
+
+static bool tin_image_inbounds(size_t offset, size_t length, size_t limit)
+{
+    return offset <= limit && length <= limit - offset;
+}
+
+/*
+* writing
+*/
+
+/* pads $buf to the next multiple of TIN_IMAGE_ALIGN, then appends $length bytes of $data (or zeroes). returns where they went */
+static char* tin_image_bufappend(char* buf, const void* data, size_t length, uint32_t* offset)
+{
+    buf = sds_growzero(buf, tin_image_alignup(sds_getlength(buf)));
+    *offset = (uint32_t)sds_getlength(buf);
+    if(data != NULL)
+    {
+        return sds_appendlen(buf, data, length);
+    }
+    return sds_growzero(buf, *offset + length);
+}
+
+static uint32_t tin_imagewriter_addstring(TinImageWriter* wr, TinString* string)
+{
+    TinValue index;
+    if(string == NULL)
+    {
+        return TIN_IMAGE_NONE;
+    }
+    if(tin_table_get(&wr->stringindex, string, &index))
+    {
+        return (uint32_t)tin_value_asfixednumber(index);
+    }
+    if(wr->stringcount == wr->stringcap)
+    {
+        wr->stringcap = (wr->stringcap < 16) ? 16 : (wr->stringcap * 2);
+        wr->strings = (TinString**)realloc(wr->strings, sizeof(TinString*) * wr->stringcap);
+    }
+    wr->strings[wr->stringcount] = string;
+    tin_table_set(wr->state, &wr->stringindex, string, tin_value_makefixednumber(wr->state, wr->stringcount));
+    wr->stringcount++;
+    return (uint32_t)(wr->stringcount - 1);
+}
+
+static uint32_t tin_imagewriter_addfunction(TinImageWriter* wr, TinFunction* function)
+{
+    size_t i;
+    uint32_t index;
+    uint32_t offset;
+    TinValue constant;
+    TinChunk* chunk;
+    TinImageConst* consts;
+    TinImageFunction record;
+    tin_function_ensureloaded(wr->state, function);
+    chunk = &function->chunk;
+    if(wr->functioncount == wr->functioncap)
+    {
+        wr->functioncap = (wr->functioncap < 16) ? 16 : (wr->functioncap * 2);
+        wr->functions = (uint32_t*)realloc(wr->functions, sizeof(uint32_t) * wr->functioncap);
+    }
+    index = (uint32_t)wr->functioncount++;
+    memset(&record, 0, sizeof(TinImageFunction));
+    record.name = tin_imagewriter_addstring(wr, function->name);
+    record.argcount = function->argcount;
+    record.upvalcount = function->upvalcount;
+    record.vararg = (uint8_t)function->vararg;
+    record.maxslots = (uint32_t)function->maxslots;
+    record.icachecount = (uint32_t)chunk->icachecount;
+    record.constcount = (uint32_t)tin_vallist_count(&chunk->constants);
+    /* nested functions go first, so that their indices are known */
+    consts = (TinImageConst*)calloc(record.constcount + 1, sizeof(TinImageConst));
+    for(i = 0; i < record.constcount; i++)
+    {
+        constant = tin_vallist_get(&chunk->constants, i);
+        if(tin_value_isstring(constant))
+        {
+            consts[i].kind = TIN_IMAGE_CONSTSTRING;
+            consts[i].index = tin_imagewriter_addstring(wr, tin_value_asstring(constant));
+        }
+        else if(tin_value_isfunction(constant))
+        {
+            consts[i].kind = TIN_IMAGE_CONSTFUNCTION;
+            consts[i].index = tin_imagewriter_addfunction(wr, tin_value_asfunction(constant));
+        }
+        else if(tin_value_isfixednumber(constant))
+        {
+            consts[i].kind = TIN_IMAGE_CONSTINT;
+            consts[i].number.fixedval = tin_value_asfixednumber(constant);
+        }
+        else if(tin_value_isnumber(constant))
+        {
+            consts[i].kind = TIN_IMAGE_CONSTFLOAT;
+            consts[i].number.floatval = tin_value_asnumber(constant);
+        }
+        else
+        {
+            UNREACHABLE
+        }
+    }
+    /* the code may have been quickened by running it; what gets saved is always the generic form */
+    record.codelength = (uint32_t)chunk->count;
+    wr->blob = tin_image_bufappend(wr->blob, NULL, chunk->count, &record.codeoffset);
+    tin_chunk_copygeneric(chunk, (uint8_t*)wr->blob + record.codeoffset);
+    if(chunk->haslineinfo && chunk->linelength > 0)
+    {
+        record.linelength = (uint32_t)chunk->linelength;
+        wr->blob = tin_image_bufappend(wr->blob, chunk->lineinfo, chunk->linelength, &record.lineoffset);
+    }
+    wr->blob = tin_image_bufappend(wr->blob, consts, sizeof(TinImageConst) * record.constcount, &record.constoffset);
+    free(consts);
+    wr->blob = tin_image_bufappend(wr->blob, &record, sizeof(TinImageFunction), &offset);
+    wr->functions[index] = offset;
+    return index;
+}
+
+/* a bit for every optimization that is enabled, since they all change the code that gets emitted */
+static uint32_t tin_image_optflags()
+{
+    int i;
+    uint32_t flags;
+    flags = 0;
+    for(i = 0; i < TINOPTSTATE_TOTAL; i++)
+    {
+        if(tin_astopt_isoptenabled((TinAstOptType)i))
+        {
+            flags |= (uint32_t)1 << i;
+        }
+    }
+    return flags;
+}
+
+/* $source is what $modules were compiled from if this is a cache entry, NULL otherwise */
+static bool tin_image_writeimage(TinState* state, TinModule** modules, size_t modulecount, const char* source, size_t sourcelength, FILE* fh)
+{
+    bool ok;
+    bool allowedgc;
+    bool stripnames;
+    size_t i;
+    size_t j;
+    uint32_t offset;
+    uint32_t pair[2];
+    char* out;
+    char* privs;
+    TinTable* privates;
+    TinTabEntry* entry;
+    TinImageHeader header;
+    TinImageWriter wr;
+    TinImageModule* records;
+    TinImageString strrec;
+    allowedgc = state->gcallow;
+    state->gcallow = false;
+    wr.state = state;
+    wr.strings = NULL;
+    wr.stringcount = 0;
+    wr.stringcap = 0;
+    wr.functions = NULL;
+    wr.functioncount = 0;
+    wr.functioncap = 0;
+    wr.blob = sds_makeempty();
+    tin_table_init(state, &wr.stringindex);
+    stripnames = tin_astopt_isoptenabled(TINOPTSTATE_PRIVATENAMES);
+    records = (TinImageModule*)calloc(modulecount + 1, sizeof(TinImageModule));
+    privs = sds_makeempty();
+    for(i = 0; i < modulecount; i++)
+    {
+        records[i].name = tin_imagewriter_addstring(&wr, modules[i]->name);
+        records[i].function = tin_imagewriter_addfunction(&wr, modules[i]->mainfunction);
+        records[i].privcount = (uint32_t)modules[i]->privcount;
+        records[i].privoffset = (uint32_t)sds_getlength(privs);
+        if(!stripnames)
+        {
+            privates = &modules[i]->privnames->values;
+            for(j = 0; j < tin_table_getcapacity(privates); j++)
+            {
+                entry = tin_table_getindex(privates, j);
+                if(entry->key != NULL)
+                {
+                    pair[0] = tin_imagewriter_addstring(&wr, entry->key);
+                    pair[1] = (uint32_t)tin_value_asnumber(entry->value);
+                    privs = sds_appendlen(privs, pair, sizeof(pair));
+                    records[i].privnamecount++;
+                }
+            }
+        }
+    }
+    /* now that all the strings are known, lay out the image */
+    memset(&header, 0, sizeof(TinImageHeader));
+    header.magic = TIN_BYTECODE_MAGIC_NUMBER;
+    header.version = TIN_BYTECODE_VERSION;
+    header.stringcount = (uint32_t)wr.stringcount;
+    header.modulecount = (uint32_t)modulecount;
+    header.functioncount = (uint32_t)wr.functioncount;
+    if(source != NULL)
+    {
+        header.sourcehash = tin_util_hashstring(source, sourcelength);
+        header.sourcelength = (uint32_t)sourcelength;
+        header.optflags = tin_image_optflags();
+    }
+    out = sds_makelength(&header, sizeof(TinImageHeader));
+    out = tin_image_bufappend(out, NULL, sizeof(TinImageString) * wr.stringcount, &header.stringoffset);
+    for(i = 0; i < wr.stringcount; i++)
+    {
+        memset(&strrec, 0, sizeof(TinImageString));
+        strrec.length = (uint32_t)tin_string_getlength(wr.strings[i]);
+        strrec.hash = tin_util_hashstring(wr.strings[i]->data, strrec.length);
+        out = tin_image_bufappend(out, wr.strings[i]->data, strrec.length + 1, &strrec.offset);
+        memcpy(out + header.stringoffset + (i * sizeof(TinImageString)), &strrec, sizeof(TinImageString));
+    }
+    out = tin_image_bufappend(out, privs, sds_getlength(privs), &offset);
+    for(i = 0; i < modulecount; i++)
+    {
+        records[i].privoffset += offset;
+    }
+    out = tin_image_bufappend(out, records, sizeof(TinImageModule) * modulecount, &header.moduleoffset);
+    out = tin_image_bufappend(out, wr.functions, sizeof(uint32_t) * wr.functioncount, &header.functionoffset);
+    out = tin_image_bufappend(out, wr.blob, sds_getlength(wr.blob), &header.bloboffset);
+    header.bloblength = (uint32_t)sds_getlength(wr.blob);
+    out = sds_growzero(out, tin_image_alignup(sds_getlength(out)));
+    header.size = (uint32_t)sds_getlength(out);
+    header.checksum = tin_util_hashstring(out + sizeof(TinImageHeader), header.size - sizeof(TinImageHeader));
+    memcpy(out, &header, sizeof(TinImageHeader));
+    ok = fwrite(out, sizeof(char), header.size, fh) == header.size;
+    sds_destroy(out);
+    sds_destroy(privs);
+    sds_destroy(wr.blob);
+    free(records);
+    free(wr.strings);
+    free(wr.functions);
+    tin_table_destroy(state, &wr.stringindex);
+    state->gcallow = allowedgc;
+    return ok;
+}
+
+/* writes $modules as one image to $fh. the first module is the one that runs when the image is loaded */
+bool tin_image_write(TinState* state, TinModule** modules, size_t modulecount, FILE* fh)
+{
+    return tin_image_writeimage(state, modules, modulecount, NULL, 0, fh);
+}
+
+/*
+* loading
+*/
+
+static const TinImageHeader* tin_image_header(TinImage* image)
+{
+    return (const TinImageHeader*)image->data;
+}
+
+static const TinImageFunction* tin_image_getfunction(TinImage* image, uint32_t index)
+{
+    const TinImageHeader* header;
+    const uint32_t* offsets;
+    header = tin_image_header(image);
+    offsets = (const uint32_t*)(image->data + header->functionoffset);
+    return (const TinImageFunction*)(image->data + header->bloboffset + offsets[index]);
+}
+
+/* whether $data starts like an image; says nothing about whether the rest of it is fine */
+bool tin_image_isimage(const char* data, size_t length)
+{
+    return length >= 2 && ((((uint8_t)data[1]) << 8) | ((uint8_t)data[0])) == TIN_BYTECODE_MAGIC_NUMBER;
+}
+
+bool tin_image_fileisimage(const char* path)
+{
+    bool result;
+    FILE* fh;
+    char magic[2];
+    fh = fopen(path, "rb");
+    if(fh == NULL)
+    {
+        return false;
+    }
+    result = fread(magic, sizeof(char), 2, fh) == 2 && tin_image_isimage(magic, 2);
+    fclose(fh);
+    return result;
+}
+
+/* checks everything that the loader relies on later, so that reading a function can't fail. errors are only raised if $report is set */
+static bool tin_image_verify(TinState* state, const uint8_t* data, size_t length, bool report)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t limit;
+    const uint32_t* offsets;
+    const TinImageHeader* header;
+    const TinImageString* strings;
+    const TinImageModule* modules;
+    const TinImageFunction* function;
+    const TinImageConst* consts;
+    if(length < sizeof(TinImageHeader))
+    {
+        if(report)
+        {
+            tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, image is truncated");
+        }
+        return false;
+    }
+    header = (const TinImageHeader*)data;
+    if(header->magic != TIN_BYTECODE_MAGIC_NUMBER)
+    {
+        if(report)
+        {
+            tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, unknown magic number");
+        }
+        return false;
+    }
+    if(header->version != TIN_BYTECODE_VERSION)
+    {
+        if(report)
+        {
+            tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, unknown bytecode version '%i'", (int)header->version);
+        }
+        return false;
+    }
+    if(header->size < sizeof(TinImageHeader) || header->size > length)
+    {
+        if(report)
+        {
+            tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, image is truncated");
+        }
+        return false;
+    }
+    if(tin_util_hashstring((const char*)data + sizeof(TinImageHeader), header->size - sizeof(TinImageHeader)) != header->checksum)
+    {
+        if(report)
+        {
+            tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, checksum mismatch");
+        }
+        return false;
+    }
+    limit = header->size;
+    if(header->modulecount == 0
+    || !tin_image_inbounds(header->stringoffset, (size_t)header->stringcount * sizeof(TinImageString), limit)
+    || !tin_image_inbounds(header->moduleoffset, (size_t)header->modulecount * sizeof(TinImageModule), limit)
+    || !tin_image_inbounds(header->functionoffset, (size_t)header->functioncount * sizeof(uint32_t), limit)
+    || !tin_image_inbounds(header->bloboffset, header->bloblength, limit)
+    || ((header->stringoffset | header->moduleoffset | header->functionoffset | header->bloboffset) % TIN_IMAGE_ALIGN) != 0)
+    {
+        goto malformed;
+    }
+    strings = (const TinImageString*)(data + header->stringoffset);
+    for(i = 0; i < header->stringcount; i++)
+    {
+        if(!tin_image_inbounds(strings[i].offset, (size_t)strings[i].length + 1, limit))
+        {
+            goto malformed;
+        }
+    }
+    modules = (const TinImageModule*)(data + header->moduleoffset);
+    for(i = 0; i < header->modulecount; i++)
+    {
+        if(modules[i].name >= header->stringcount || modules[i].function >= header->functioncount
+        || !tin_image_inbounds(modules[i].privoffset, (size_t)modules[i].privnamecount * sizeof(uint32_t) * 2, limit))
+        {
+            goto malformed;
+        }
+    }
+    offsets = (const uint32_t*)(data + header->functionoffset);
+    limit = header->bloblength;
+    for(i = 0; i < header->functioncount; i++)
+    {
+        if((offsets[i] % TIN_IMAGE_ALIGN) != 0 || !tin_image_inbounds(offsets[i], sizeof(TinImageFunction), limit))
+        {
+            goto malformed;
+        }
+        function = (const TinImageFunction*)(data + header->bloboffset + offsets[i]);
+        if((function->name != TIN_IMAGE_NONE && function->name >= header->stringcount)
+        || !tin_image_inbounds(function->codeoffset, function->codelength, limit)
+        || !tin_image_inbounds(function->lineoffset, function->linelength, limit)
+        || !tin_image_inbounds(function->constoffset, (size_t)function->constcount * sizeof(TinImageConst), limit)
+        || (function->constoffset % TIN_IMAGE_ALIGN) != 0)
+        {
+            goto malformed;
+        }
+        consts = (const TinImageConst*)(data + header->bloboffset + function->constoffset);
+        for(j = 0; j < function->constcount; j++)
+        {
+            if((consts[j].kind == TIN_IMAGE_CONSTSTRING && consts[j].index >= header->stringcount)
+            || (consts[j].kind == TIN_IMAGE_CONSTFUNCTION && consts[j].index >= header->functioncount)
+            || consts[j].kind > TIN_IMAGE_CONSTFUNCTION)
+            {
+                goto malformed;
+            }
+        }
+    }
+    return true;
+malformed:
+    if(report)
+    {
+        tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, image is malformed");
+    }
+    return false;
+}
+
+/* makes all the strings of $image at once; since their hashes are stored, those that are already interned cost a lookup */
+static void tin_image_makestrings(TinState* state, TinImage* image)
+{
+    size_t i;
+    const char* chars;
+    TinString* string;
+    const TinImageHeader* header;
+    const TinImageString* strings;
+    header = tin_image_header(image);
+    strings = (const TinImageString*)(image->data + header->stringoffset);
+    image->stringcount = header->stringcount;
+    image->strings = (TinString**)calloc(image->stringcount + 1, sizeof(TinString*));
+    for(i = 0; i < image->stringcount; i++)
+    {
+        chars = (const char*)image->data + strings[i].offset;
+        if(strings[i].length > TIN_STRING_MAXINTERN)
+        {
+            string = tin_string_copyuninterned(state, chars, strings[i].length);
+        }
+        else
+        {
+            string = tin_strreg_find(state, chars, strings[i].length, strings[i].hash);
+            if(string == NULL)
+            {
+                string = tin_string_makelen(state, sds_makelength(chars, strings[i].length), strings[i].length, strings[i].hash, true, true);
+            }
+        }
+        image->strings[i] = string;
+    }
+}
+
+static TinString* tin_image_getstring(TinImage* image, uint32_t index)
+{
+    if(index == TIN_IMAGE_NONE)
+    {
+        return NULL;
+    }
+    return image->strings[index];
+}
+
+/* only the header of the function is read here; the rest follows in tin_image_loadfunction */
+static TinFunction* tin_image_makefunction(TinState* state, TinImage* image, TinModule* module, uint32_t index)
+{
+    TinFunction* function;
+    const TinImageFunction* record;
+    record = tin_image_getfunction(image, index);
+    function = tin_object_makefunction(state, module);
+    function->name = tin_image_getstring(image, record->name);
+    function->argcount = record->argcount;
+    function->upvalcount = record->upvalcount;
+    function->vararg = (bool)record->vararg;
+    function->maxslots = record->maxslots;
+    function->image = image;
+    function->imageindex = index;
+    return function;
+}
+
+void tin_image_loadfunction(TinState* state, TinFunction* function)
+{
+    size_t i;
+    uint8_t* blob;
+    TinValue value;
+    TinImage* image;
+    TinChunk* chunk;
+    const TinImageConst* consts;
+    const TinImageFunction* record;
+    image = function->image;
+    function->image = NULL;
+    record = tin_image_getfunction(image, function->imageindex);
+    blob = image->data + tin_image_header(image)->bloboffset;
+    chunk = &function->chunk;
+    tin_state_pushroot(state, (TinObject*)function);
+    chunk->code = blob + record->codeoffset;
+    chunk->count = record->codelength;
+    chunk->capacity = record->codelength;
+    chunk->codeinimage = true;
+    chunk->icachecount = record->icachecount;
+    /* a line table that doesn't decode only costs the line numbers */
+    if(record->linelength == 0 || !tin_chunk_setlineinfo(state, chunk, blob + record->lineoffset, record->linelength))
+    {
+        chunk->haslineinfo = false;
+    }
+    if(record->constcount > 0)
+    {
+        tin_vallist_ensuresize(state, &chunk->constants, record->constcount);
+    }
+    consts = (const TinImageConst*)(blob + record->constoffset);
+    for(i = 0; i < record->constcount; i++)
+    {
+        switch(consts[i].kind)
+        {
+            case TIN_IMAGE_CONSTFLOAT:
+                value = tin_value_makefloatnumber(state, consts[i].number.floatval);
+                break;
+            case TIN_IMAGE_CONSTINT:
+                value = tin_value_makefixednumber(state, consts[i].number.fixedval);
+                break;
+            case TIN_IMAGE_CONSTSTRING:
+                value = tin_value_fromobject(image->strings[consts[i].index]);
+                break;
+            default:
+                value = tin_value_fromobject(tin_image_makefunction(state, image, function->module, consts[i].index));
+                break;
+        }
+        tin_vallist_set(state, &chunk->constants, i, value);
+        /* the function may well be old by now */
+        tin_gcmem_writebarrier(state, (TinObject*)function, value);
+    }
+    tin_state_poproot(state);
+}
+
+static void tin_image_release(uint8_t* data, size_t length, bool mapped)
+{
+    #if defined(TIN_IMAGE_USEMMAP)
+        if(mapped)
+        {
+            munmap(data, length);
+            return;
+        }
+    #else
+        (void)length;
+        (void)mapped;
+    #endif
+    free(data);
+}
+
+/* whether $data was cached from exactly $source, with the optimizations that are enabled now */
+static bool tin_image_matchessource(const uint8_t* data, const char* source, size_t sourcelength)
+{
+    const TinImageHeader* header;
+    header = (const TinImageHeader*)data;
+    return header->sourcelength == sourcelength
+        && header->optflags == tin_image_optflags()
+        && header->sourcehash == tin_util_hashstring(source, sourcelength);
+}
+
+/*
+* takes ownership of $data. returns the first module of the image, or NULL if it couldn't be read.
+* if $source is given, $data is a cache entry: it is checked against $source, and rejected quietly.
+*/
+static TinModule* tin_image_open(TinState* state, uint8_t* data, size_t length, bool mapped, const char* source, size_t sourcelength)
+{
+    uint32_t i;
+    uint32_t j;
+    bool allowedgc;
+    const uint32_t* pairs;
+    TinImage* image;
+    TinModule* first;
+    TinModule* module;
+    const TinImageHeader* header;
+    const TinImageModule* records;
+    if(!tin_image_verify(state, data, length, source == NULL) || (source != NULL && !tin_image_matchessource(data, source, sourcelength)))
+    {
+        tin_image_release(data, length, mapped);
+        return NULL;
+    }
+    allowedgc = state->gcallow;
+    state->gcallow = false;
+    image = (TinImage*)malloc(sizeof(TinImage));
+    image->data = data;
+    image->length = length;
+    image->mapped = mapped;
+    image->next = state->images;
+    state->images = image;
+    tin_image_makestrings(state, image);
+    header = tin_image_header(image);
+    records = (const TinImageModule*)(data + header->moduleoffset);
+    first = NULL;
+    for(i = 0; i < header->modulecount; i++)
+    {
+        module = tin_object_makemodule(state, image->strings[records[i].name]);
+        module->privates = (TinValue*)tin_gcmem_allocate(state, sizeof(TinValue), records[i].privcount);
+        module->privcount = records[i].privcount;
+        for(j = 0; j < records[i].privcount; j++)
+        {
+            module->privates[j] = tin_value_makenull(state);
+        }
+        pairs = (const uint32_t*)(data + records[i].privoffset);
+        for(j = 0; j < records[i].privnamecount; j++)
+        {
+            tin_table_set(state, &module->privnames->values, image->strings[pairs[j * 2]], tin_value_makefixednumber(state, pairs[j * 2 + 1]));
+        }
+        module->mainfunction = tin_image_makefunction(state, image, module, records[i].function);
+        tin_table_set(state, &state->vm->modules->values, module->name, tin_value_fromobject(module));
+        if(first == NULL)
+        {
+            first = module;
+        }
+    }
+    state->gcallow = allowedgc;
+    return first;
+}
+
+/* loads an image from memory. $data is copied, since the functions keep using it */
+TinModule* tin_image_load(TinState* state, const char* data, size_t length)
+{
+    uint8_t* copy;
+    copy = (uint8_t*)malloc(length + 1);
+    memcpy(copy, data, length);
+    return tin_image_open(state, copy, length, false, NULL, 0);
+}
+
+/* maps $path where possible, so only the pages that are used get read; reads it otherwise */
+static uint8_t* tin_image_readfile(const char* path, size_t* length, bool* mapped)
+{
+    #if defined(TIN_IMAGE_USEMMAP)
+        int fd;
+        void* mapping;
+        struct stat st;
+        fd = open(path, O_RDONLY);
+        if(fd != -1)
+        {
+            mapping = MAP_FAILED;
+            if(fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                /* private and writable: quickening rewrites the code, and those pages get copied instead of written back */
+                mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+            if(mapping != MAP_FAILED)
+            {
+                *length = (size_t)st.st_size;
+                *mapped = true;
+                return (uint8_t*)mapping;
+            }
+        }
+    #endif
+    *mapped = false;
+    return (uint8_t*)tin_util_readfile(path, length);
+}
+
+TinModule* tin_image_loadfile(TinState* state, const char* path)
+{
+    bool mapped;
+    size_t length;
+    uint8_t* data;
+    data = tin_image_readfile(path, &length, &mapped);
+    if(data == NULL)
+    {
+        tin_state_raiseerror(state, RUNTIME_ERROR, "failed to open file '%s' for reading", path);
+        return NULL;
+    }
+    return tin_image_open(state, data, length, mapped, NULL, 0);
+}
+
+/* frees every image of $state; only once no function can refer to them anymore */
+void tin_image_destroyall(TinState* state)
+{
+    TinImage* image;
+    TinImage* next;
+    for(image = state->images; image != NULL; image = next)
+    {
+        next = image->next;
+        tin_image_release(image->data, image->length, image->mapped);
+        free(image->strings);
+        free(image);
+    }
+    state->images = NULL;
+}
+
+/*
+* the compilation cache.
+*
+* scripts run by tin_state_execfile are cached in $config.cachedir, one entry per script, named after
+* the script, a hash of its path and the interpreter version (like python's __pycache__). an entry is
+* only used if the source, the bytecode version and the enabled optimizations all still match;
+* otherwise the script is compiled as usual and the entry replaced.
+* entries are written to a temporary file first and renamed into place, so a reader never sees half of one.
+*/
+
+/* returns the (malloc'd) path of the cache entry for $path in $dir */
+char* tin_image_cachepath(const char* dir, const char* path)
+{
+    size_t length;
+    const char* base;
+    const char* p;
+    char* result;
+    base = path;
+    for(p = path; *p != 0; p++)
+    {
+        if(*p == '/' || *p == '\\')
+        {
+            base = p + 1;
+        }
+    }
+    length = strlen(dir) + strlen(base) + 64;
+    result = (char*)malloc(length);
+    snprintf(result, length, "%s/%s.%08x.tin-%s-o%x.lbc", dir, base, (unsigned int)tin_util_hashstring(path, strlen(path)),
+        TIN_VERSION_STRING, (unsigned int)tin_image_optflags());
+    return result;
+}
+
+/* the cached modules of $source, or NULL (quietly) if $entry is missing, stale or damaged */
+TinModule* tin_image_loadcached(TinState* state, const char* entry, const char* source, size_t sourcelength)
+{
+    bool mapped;
+    size_t length;
+    uint8_t* data;
+    data = tin_image_readfile(entry, &length, &mapped);
+    if(data == NULL)
+    {
+        return NULL;
+    }
+    return tin_image_open(state, data, length, mapped, source, sourcelength);
+}
+
+/* stores $module, compiled from $source, as $entry. a cache that can't be written is not an error */
+bool tin_image_savecached(TinState* state, const char* dir, const char* entry, TinModule* module, const char* source, size_t sourcelength)
+{
+    bool written;
+    size_t length;
+    char* temppath;
+    FILE* fh;
+    #if defined(TIN_OS_WINDOWS)
+        _mkdir(dir);
+    #elif defined(TIN_OS_UNIXLIKE)
+        mkdir(dir, 0777);
+    #endif
+    length = strlen(entry) + 32;
+    temppath = (char*)malloc(length);
+    #if defined(TIN_OS_WINDOWS)
+        snprintf(temppath, length, "%s.%d.tmp", entry, (int)_getpid());
+    #elif defined(TIN_OS_UNIXLIKE)
+        snprintf(temppath, length, "%s.%d.tmp", entry, (int)getpid());
+    #else
+        snprintf(temppath, length, "%s.tmp", entry);
+    #endif
+    written = false;
+    fh = fopen(temppath, "wb");
+    if(fh != NULL)
+    {
+        written = tin_image_writeimage(state, &module, 1, source, sourcelength, fh);
+        written = (fclose(fh) == 0) && written;
+        #if defined(TIN_OS_WINDOWS)
+            /* rename doesn't replace files here */
+            if(written)
+            {
+                remove(entry);
+            }
+        #endif
+        written = written && rename(temppath, entry) == 0;
+        if(!written)
+        {
+            remove(temppath);
+        }
+    }
+    free(temppath);
+    return written;
+}
@@ -74,7 +74,12 @@ static bool populate_flags(int argc, int begin, char** argv, const char* expectv
         {
             fx->flags[flidx].flag = arg[1];
             fx->flags[flidx].value = NULL;
-            if(strchr(expectvalue, arg[1]) != NULL)
+            /* --name and --name=value: flag '-', and everything after the dashes as value */
+            if(arg[1] == '-')
+            {
+                fx->flags[flidx].value = arg + 2;
+            }
+            else if(strchr(expectvalue, arg[1]) != NULL)
             {
                 nextch = arg[2];
                 /* -e "somecode(...)" */
@@ -120,7 +125,9 @@ static void show_help()
     printf(" -p --pass [args] Passes the rest of the arguments to the script.\n");
     printf(" -i --interactive Starts an interactive shell.\n");
     printf(" -d --dump  Dumps all the bytecode chunks from the given file.\n");
-    printf(" -t --time  Measures and prints the compilation timings.\n");
+    printf(" -t --time  Measures and prints the compilation timings, and compilation cache hits and misses.\n");
+    printf("    --cache-dir=[dir]  Caches compiled scripts in the given directory. Defaults to $TIN_CACHE_DIR, if set.\n");
+    printf("    --no-cache  Neither reads nor writes the compilation cache.\n");
     printf(" -h --help  I wonder, what this option does.\n");
     printf(" If no code to run is provided, lit will try to run either main.lbc or main.lit and, if fails, default to an interactive shell will start.\n");
 }
@@ -184,6 +191,9 @@ struct Options_t
 {
     char* debugmode;
     char* codeline;
+    char* outputfile;
+    char* cachedir;
+    bool nocache;
 };
 
 
@@ -192,6 +202,9 @@ static bool parse_options(Options_t* opts, Flag_t* flags, int fcnt)
     int i;
     opts->codeline = NULL;
     opts->debugmode = NULL;
+    opts->outputfile = NULL;
+    opts->cachedir = getenv("TIN_CACHE_DIR");
+    opts->nocache = false;
     for(i=0; i<fcnt; i++)
     {
         switch(flags[i].flag)
@@ -217,6 +230,47 @@ static bool parse_options(Options_t* opts, Flag_t* flags, int fcnt)
                     
                 }
                 break;
+            case 'o':
+                {
+                    if(flags[i].value == NULL)
+                    {
+                        fprintf(stderr, "flag '-o' expects a file name\n");
+                        return false;
+                    }
+                    opts->outputfile = flags[i].value;
+                }
+                break;
+            case 't':
+                {
+                    tin_enable_compilation_time_measurement();
+                }
+                break;
+            case '-':
+                {
+                    if(strcmp(flags[i].value, "help") == 0)
+                    {
+                        show_help();
+                        return false;
+                    }
+                    else if(strcmp(flags[i].value, "time") == 0)
+                    {
+                        tin_enable_compilation_time_measurement();
+                    }
+                    else if(strcmp(flags[i].value, "no-cache") == 0)
+                    {
+                        opts->nocache = true;
+                    }
+                    else if(strncmp(flags[i].value, "cache-dir=", 10) == 0 && flags[i].value[10] != 0)
+                    {
+                        opts->cachedir = flags[i].value + 10;
+                    }
+                    else
+                    {
+                        fprintf(stderr, "unrecognized option '--%s'\n", flags[i].value);
+                        return false;
+                    }
+                }
+                break;
             case 'd':
                 {
                     if(flags[i].value == NULL)
@@ -288,7 +342,7 @@ int main(int argc, char* argv[])
     cmdfailed = false;
     result = TINSTATE_OK;
     ptsize(TinValue);
-    populate_flags(argc, 1, argv, "ed", &fx);
+    populate_flags(argc, 1, argv, "edo", &fx);
     state = tin_make_state();
     tin_open_libraries(state);
 
@@ -298,6 +352,10 @@ int main(int argc, char* argv[])
     }
     else
     {
+        if(!opts.nocache && opts.cachedir != NULL && opts.cachedir[0] != 0)
+        {
+            state->config.cachedir = opts.cachedir;
+        }
         if(opts.debugmode != NULL)
         {
             dm = opts.debugmode;
@@ -316,7 +374,19 @@ int main(int argc, char* argv[])
             }
         }
     }
-    if(!cmdfailed)
+    if(!cmdfailed && opts.outputfile != NULL)
+    {
+        if(fx.poscnt == 0)
+        {
+            fprintf(stderr, "flag '-o' needs at least one file to compile\n");
+            result = TINSTATE_COMPILEERROR;
+        }
+        else if(!tin_state_compileandsave(state, fx.positional, fx.poscnt, opts.outputfile))
+        {
+            result = TINSTATE_COMPILEERROR;
+        }
+    }
+    else if(!cmdfailed)
     {
         if((fx.poscnt > 0) || (opts.codeline != NULL))
         {
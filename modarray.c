@@ -18,6 +18,7 @@ void tin_vallist_initsizeintern(TinState* state, TinValList* vl, size_t tsz)
     vl->capacity = 0;
     vl->count = 0;
     vl->elemsize = tsz;
+    vl->owner = NULL;
 }
 
 void tin_vallist_initsize(TinState* state, TinValList* vl, size_t tsz)
@@ -41,9 +42,12 @@ void tin_vallist_init(TinState* state, TinValList* vl)
 void tin_vallist_destroy(TinState* state, TinValList* vl)
 {
     size_t tsz;
+    TinObject* owner;
     tsz = vl->elemsize;
+    owner = vl->owner;
     tin_gcmem_freearray(state, tsz, vl->values, vl->capacity);
     tin_vallist_initsizeintern(state, vl, tsz);
+    vl->owner = owner;
 }
 
 size_t tin_vallist_size(TinValList* vl)
@@ -121,12 +125,14 @@ void tin_vallist_push(TinState* state, TinValList* vl, TinValue value)
     }
     vl->values[vl->count] = value;
     vl->count++;
+    tin_gcmem_writebarrier(state, vl->owner, value);
 }
 
 TinValue tin_vallist_set(TinState* state, TinValList* vl, size_t idx, TinValue val)
 {
     tin_vallist_ensuresizeintern(state, vl, idx+1);
     vl->values[idx] = val;
+    tin_gcmem_writebarrier(state, vl->owner, val);
     return val;
 }
 
@@ -142,13 +148,14 @@ TinArray* tin_object_makearray(TinState* state)
     TinArray* array;
     array = (TinArray*)tin_object_allocobject(state, sizeof(TinArray), TINTYPE_ARRAY, false);
     tin_vallist_init(state, &array->list);
+    array->list.owner = (TinObject*)array;
     return array;
 }
 
 void tin_array_destroy(TinState* state, TinArray* arr)
 {
     tin_vallist_destroy(state, &arr->list);
-    tin_gcmem_free(state, sizeof(TinArray), arr);
+    tin_gcmem_freeobject(state, sizeof(TinArray), arr);
 }
 
 size_t tin_array_count(TinArray* arr)
@@ -572,29 +579,23 @@ static TinValue objfn_array_join(TinVM* vm, TinValue instance, size_t argc, TinV
         }
     }
     length = sds_getlength(chars);
-    res = tin_string_take(vm->state, chars, length, true);
+    res = tin_string_takeuninterned(vm->state, chars, length, true);
     return tin_value_fromobject(res);
 }
 
 static TinValue objfn_array_sort(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
-    TinValList* vl;
-    (void)vl;
-    (void)vm;
-    (void)instance;
-    (void)argc;
-    (void)argv;
-    vl = &tin_value_asarray(instance)->list;
-    /*
+    TinValue comparator;
+    comparator = tin_value_makenull(vm->state);
     if(argc == 1 && tin_value_iscallablefunction(argv[0]))
     {
-        util_custom_quick_sort(vm, vl->values, vl->count, argv[0]);
+        comparator = argv[0];
     }
-    else
+    if(!util_sort_array(vm->state, tin_value_asarray(instance), comparator))
     {
-        util_basic_quick_sort(vm->state, vl->values, vl->count);
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.sort: comparison failed");
+        return tin_value_makenull(vm->state);
     }
-    */
     return instance;
 }
 
@@ -642,36 +643,39 @@ static TinValue objfn_array_pop(TinVM* vm, TinValue instance, size_t argc, TinVa
     return tin_array_pop(vm->state, self);
 }
 
-static TinValue objfn_array_map(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+/*
+* the higher-order methods call their callback through a TinPreparedCall, with the current element as its only argument
+* (reduce passes the accumulator first). the array may be changed by the callback, so they check its length every time.
+*/
+static bool tin_array_preparecallback(TinVM* vm, const char* name, size_t argc, TinValue* argv, TinPreparedCall* pc, uint8_t cbargc)
 {
-    size_t i;
-    size_t len;
-    TinValue val;
-    TinValue callable;
-    TinValue args[2];
-    TinInterpretResult tr;
-    (void)argc;
-    (void)argv;
-    TinArray* self;
     if(argc == 0)
     {
-        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.map requires a function");
-        return tin_value_makenull(vm->state);
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.%s requires a function", name);
+        return false;
+    }
+    if(!tin_value_iscallablefunction(argv[0]))
+    {
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.%s cannot call first argument", name);
+        return false;
     }
-    callable = argv[0];
-    if(!tin_value_iscallablefunction(callable))
+    return tin_state_preparecall(vm->state, pc, argv[0], cbargc);
+}
+
+static TinValue objfn_array_map(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinArray* self;
+    TinPreparedCall pc;
+    TinInterpretResult tr;
+    if(!tin_array_preparecallback(vm, "map", argc, argv, &pc, 1))
     {
-        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.map cannot call first argument");
         return tin_value_makenull(vm->state);
     }
     self = tin_value_asarray(instance);
-    len = tin_array_count(self);
-    for(i=0; i<len; i++)
+    for(i = 0; i < tin_array_count(self); i++)
     {
-        val = tin_array_get(vm->state, self, i);
-        //TinInterpretResult tin_state_callvalue(TinState *state, TinValue callee, TinValue *argv, uint8_t argc, bool ignfiber);
-        args[0] = val;
-        tr = tin_state_callvalue(vm->state, callable, args, 1, false);
+        tr = tin_state_invokeprepared(&pc, &self->list.values[i]);
         if(tr.type != TINSTATE_OK)
         {
             tin_state_raiseerror(vm->state, RUNTIME_ERROR, "call failed");
@@ -685,48 +689,165 @@ static TinValue objfn_array_map(TinVM* vm, TinValue instance, size_t argc, TinVa
 static TinValue objfn_array_filter(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
     size_t i;
-    size_t len;
     TinValue val;
-    TinValue callable;
-    TinValue args[2];
-    TinInterpretResult tr;
-    (void)argc;
-    (void)argv;
     TinArray* self;
     TinArray* newarr;
-    if(argc == 0)
-    {
-        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.filter requires a function");
-        return tin_value_makenull(vm->state);
-    }
-    callable = argv[0];
-    if(!tin_value_iscallablefunction(callable))
+    TinPreparedCall pc;
+    TinInterpretResult tr;
+    if(!tin_array_preparecallback(vm, "filter", argc, argv, &pc, 1))
     {
-        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "Array.filter cannot call first argument");
         return tin_value_makenull(vm->state);
     }
     self = tin_value_asarray(instance);
-    len = tin_array_count(self);
     newarr = tin_object_makearray(vm->state);
-    for(i=0; i<len; i++)
+    tin_state_pushroot(vm->state, (TinObject*)newarr);
+    for(i = 0; i < tin_array_count(self); i++)
     {
-        val = tin_array_get(vm->state, self, i);
-        //TinInterpretResult tin_state_callvalue(TinState *state, TinValue callee, TinValue *argv, uint8_t argc, bool ignfiber);
-        args[0] = val;
-        tr = tin_state_callvalue(vm->state, callable, args, 1, false);
+        val = self->list.values[i];
+        tr = tin_state_invokeprepared(&pc, &val);
         if(tr.type != TINSTATE_OK)
         {
+            tin_state_poproot(vm->state);
             tin_state_raiseerror(vm->state, RUNTIME_ERROR, "call failed");
             return tin_value_makenull(vm->state);
         }
-        if(tin_value_asbool(tr.result))
+        if(!tin_value_isfalsey(tr.result))
         {
             tin_array_push(vm->state, newarr, val);
         }
     }
+    tin_state_poproot(vm->state);
     return tin_value_fromobject(newarr);
 }
 
+/* reduce(fn[, initial]): fn(accumulator, element); without initial, the first element is the accumulator */
+static TinValue objfn_array_reduce(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinValue args[2];
+    TinArray* self;
+    TinPreparedCall pc;
+    TinInterpretResult tr;
+    if(!tin_array_preparecallback(vm, "reduce", argc, argv, &pc, 2))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    self = tin_value_asarray(instance);
+    i = 0;
+    if(argc > 1)
+    {
+        args[0] = argv[1];
+    }
+    else if(tin_array_count(self) > 0)
+    {
+        args[0] = self->list.values[0];
+        i = 1;
+    }
+    else
+    {
+        return tin_value_makenull(vm->state);
+    }
+    for(; i < tin_array_count(self); i++)
+    {
+        args[1] = self->list.values[i];
+        tr = tin_state_invokeprepared(&pc, args);
+        if(tr.type != TINSTATE_OK)
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "call failed");
+            return tin_value_makenull(vm->state);
+        }
+        args[0] = tr.result;
+    }
+    return args[0];
+}
+
+static TinValue objfn_array_foreach(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinArray* self;
+    TinPreparedCall pc;
+    TinInterpretResult tr;
+    if(!tin_array_preparecallback(vm, "forEach", argc, argv, &pc, 1))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    self = tin_value_asarray(instance);
+    for(i = 0; i < tin_array_count(self); i++)
+    {
+        tr = tin_state_invokeprepared(&pc, &self->list.values[i]);
+        if(tr.type != TINSTATE_OK)
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "call failed");
+            return tin_value_makenull(vm->state);
+        }
+    }
+    return tin_value_makenull(vm->state);
+}
+
+/*
+* find, any and all: calls fn on each element until it returns $stopon (truthy or falsey),
+* and returns the index of that element, or -1 if there is none (or -2 if a call failed).
+*/
+static int64_t tin_array_findwhere(TinVM* vm, const char* name, TinValue instance, size_t argc, TinValue* argv, bool stopon)
+{
+    size_t i;
+    TinArray* self;
+    TinPreparedCall pc;
+    TinInterpretResult tr;
+    if(!tin_array_preparecallback(vm, name, argc, argv, &pc, 1))
+    {
+        return -2;
+    }
+    self = tin_value_asarray(instance);
+    for(i = 0; i < tin_array_count(self); i++)
+    {
+        tr = tin_state_invokeprepared(&pc, &self->list.values[i]);
+        if(tr.type != TINSTATE_OK)
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "call failed");
+            return -2;
+        }
+        if(tin_value_isfalsey(tr.result) != stopon)
+        {
+            return (int64_t)i;
+        }
+    }
+    return -1;
+}
+
+static TinValue objfn_array_find(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    int64_t index;
+    index = tin_array_findwhere(vm, "find", instance, argc, argv, true);
+    if(index < 0 || (size_t)index >= tin_array_count(tin_value_asarray(instance)))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_vallist_get(&tin_value_asarray(instance)->list, index);
+}
+
+static TinValue objfn_array_any(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    int64_t index;
+    index = tin_array_findwhere(vm, "any", instance, argc, argv, true);
+    if(index == -2)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_value_makebool(vm->state, index >= 0);
+}
+
+static TinValue objfn_array_all(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    int64_t index;
+    index = tin_array_findwhere(vm, "all", instance, argc, argv, false);
+    if(index == -2)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_value_makebool(vm->state, index == -1);
+}
+
 static TinValue objfn_array_length(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
     (void)vm;
@@ -762,6 +883,11 @@ void tin_open_array_library(TinState* state)
         tin_class_bindmethod(state, klass, "pop", objfn_array_pop);
         tin_class_bindmethod(state, klass, "map", objfn_array_map);
         tin_class_bindmethod(state, klass, "filter", objfn_array_filter);
+        tin_class_bindmethod(state, klass, "reduce", objfn_array_reduce);
+        tin_class_bindmethod(state, klass, "forEach", objfn_array_foreach);
+        tin_class_bindmethod(state, klass, "find", objfn_array_find);
+        tin_class_bindmethod(state, klass, "any", objfn_array_any);
+        tin_class_bindmethod(state, klass, "all", objfn_array_all);
         tin_class_bindgetset(state, klass, "length", objfn_array_length, NULL, false);
         state->primarrayclass = klass;
     }
@@ -10,6 +10,10 @@ TinClass* tin_object_makeclasswithparent(TinState* state, TinString* name, TinCl
     klass->parentclass = parentclass;
     tin_table_init(state, &klass->methods);
     tin_table_init(state, &klass->staticfields);
+    klass->rootshape = NULL;
+    klass->shapecount = 0;
+    klass->instancefields = 0;
+    tin_class_touchmethods(state, klass);
     if(parentclass != NULL)
     {
         tin_class_inheritfrom(state, klass, parentclass);
@@ -37,6 +41,16 @@ TinClass* tin_object_makeclassname(TinState* state, const char* name)
     return tin_object_makeclassnamewithparent(state, name, NULL);
 }
 
+/*
+* must be called whenever klass->methods is modified, so that inline caches
+* holding lookups from the old table are no longer used.
+*/
+void tin_class_touchmethods(TinState* state, TinClass* klass)
+{
+    state->classversion++;
+    klass->methodsversion = state->classversion;
+}
+
 TinField* tin_object_makefield(TinState* state, TinObject* getter, TinObject* setter)
 {
     TinField* field;
@@ -48,11 +62,23 @@ TinField* tin_object_makefield(TinState* state, TinObject* getter, TinObject* se
 
 TinInstance* tin_object_makeinstance(TinState* state, TinClass* klass)
 {
+    size_t inlinecap;
+    TinShape* shape;
     TinInstance* inst;
-    inst = (TinInstance*)tin_object_allocobject(state, sizeof(TinInstance), TINTYPE_INSTANCE, false);
+    shape = tin_shape_getroot(state, klass);
+    inlinecap = klass->instancefields;
+    if(inlinecap > TIN_INSTANCE_MAXINLINE)
+    {
+        inlinecap = TIN_INSTANCE_MAXINLINE;
+    }
+    inst = (TinInstance*)tin_object_allocobject(state, sizeof(TinInstance) + (sizeof(TinValue) * inlinecap), TINTYPE_INSTANCE, false);
     inst->klass = klass;
+    inst->shape = shape;
+    inst->slots = inst->inlineslots;
+    inst->slotcap = inlinecap;
+    inst->inlinecap = inlinecap;
     tin_table_init(state, &inst->fields);
-    //inst->fields.count = 0;
+    inst->fields.owner = (TinObject*)inst;
     return inst;
 }
 
@@ -70,6 +96,7 @@ TinNativeMethod* tin_class_bindmethod(TinState* state, TinClass* cl, const char*
     nm = tin_string_copy(state, name, strlen(name));
     mth = tin_object_makenativemethod(state, fn, nm);
     tin_table_set(state, &cl->methods, nm, tin_value_fromobject(mth));
+    tin_class_touchmethods(state, cl);
     return mth;
 }
 
@@ -80,6 +107,7 @@ TinPrimitiveMethod* tin_class_bindprimitive(TinState* state, TinClass* cl, const
     nm = tin_string_copy(state, name, strlen(name));
     mth = tin_object_makeprimitivemethod(state, fn, nm);
     tin_table_set(state, &cl->methods, nm, tin_value_fromobject(mth));
+    tin_class_touchmethods(state, cl);
     return mth;
 }
 
@@ -136,6 +164,7 @@ TinField* tin_class_bindgetset(TinState* state, TinClass* cl, const char* name,
     }
     field = tin_object_makefield(state, (TinObject*)mthget, (TinObject*)mthset);
     tin_table_set(state, tbl, nm, tin_value_fromobject(field)); 
+    tin_class_touchmethods(state, cl);
     return field;
 }
 
@@ -161,6 +190,7 @@ void tin_class_inheritfrom(TinState* state, TinClass* current, TinClass* other)
     }
     tin_table_add_all(state, &other->methods, &current->methods); \
     tin_table_add_all(state, &other->staticfields, &current->staticfields);
+    tin_class_touchmethods(state, current);
 }
 
 static TinValue objfn_class_tostring(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
@@ -18,88 +18,384 @@ void tin_open_libraries(TinState* state)
     tin_open_math_library(state);
     tin_open_file_library(state);
     tin_open_gc_library(state);
+    tin_open_vm_library(state);
 }
 
-#if 0
-#define COMPARE(state, callee, a, b) \
-    ( \
-    { \
-        TinValue argv[2]; \
-        argv[0] = a; \
-        argv[1] = b; \
-        TinInterpretResult r = tin_state_callvalue(state, callee, argv, 2, false); \
-        if(r.type != TINSTATE_OK) \
-        { \
-            return; \
-        } \
-        !tin_value_isfalsey(r.result); \
-    })
+/*
+* Array.sort: a stable merge sort. runs of TIN_SORT_RUN items are insertion sorted first, and then
+* merged bottom-up, back and forth between the items and a scratch buffer. a merge is skipped when its
+* halves are already in order, so sorted (or mostly sorted) arrays cost about one pass.
+*
+* arrays that are all fixed numbers, all float numbers, or all strings are compared right here, mostly by a
+* 64 bit key that orders like the values themselves (see util_sort_key), so they don't have to be looked at.
+* anything else is compared with "<" (numbers directly), or with the comparator, which is called through a
+* TinPreparedCall. those run scripts, which may run the gc, or change the array: a copy of the values is
+* kept in an array object of its own while sorting, and the result is written back with tin_vallist_set.
+*/
+#define TIN_SORT_RUN 32
+
+/* the sort is instantiated once per kind of comparison in util_sort_bykind, see util_sort_less */
+#if defined(__GNUC__)
+    #define TIN_SORT_INLINE static inline __attribute__((always_inline))
 #else
-static TinInterpretResult COMPARE_inl(TinState* state, TinValue callee, TinValue a, TinValue b)
-{
-    TinValue argv[2];
-    argv[0] = a;
-    argv[1] = b;
-    return tin_state_callvalue(state, callee, argv, 2, false);
-}
-
-#define COMPARE(state, callee, a, b) \
-    COMPARE_inl(state, callee, a, b)
+    #define TIN_SORT_INLINE static inline
 #endif
 
+enum
+{
+    TINSORT_FIXED,
+    TINSORT_FLOAT,
+    TINSORT_NUMBER,
+    TINSORT_STRING,
+    TINSORT_LESSTHAN,
+    TINSORT_CALLBACK
+};
+
+typedef struct TinSortState TinSortState;
+typedef struct TinSortItem TinSortItem;
+
+struct TinSortState
+{
+    TinState* state;
+    /* the comparator, for TINSORT_CALLBACK */
+    TinPreparedCall call;
+    /* set once a comparison failed; every comparison after that is false, which finishes the sort quickly */
+    bool failed;
+};
 
+struct TinSortItem
+{
+    /* only used by the kinds util_sort_key knows */
+    uint64_t key;
+    TinValue value;
+};
 
-void util_custom_quick_sort(TinVM* vm, TinValue* l, int length, TinValue callee)
+static int util_sort_kindof(TinValue* values, size_t count)
 {
-    TinInterpretResult rt;
-    TinState* state;
-    if(length < 2)
+    size_t i;
+    bool fixed;
+    bool floats;
+    bool numbers;
+    bool strings;
+    fixed = true;
+    floats = true;
+    numbers = true;
+    strings = true;
+    for(i = 0; i < count; i++)
     {
-        return;
+        fixed = fixed && tin_value_isfixednumber(values[i]);
+        floats = floats && tin_value_isfloatnumber(values[i]);
+        numbers = numbers && tin_value_isnumber(values[i]);
+        strings = strings && tin_value_isstring(values[i]);
+        if(!numbers && !strings)
+        {
+            return TINSORT_LESSTHAN;
+        }
     }
-    state = vm->state;
-    int pivotindex = length / 2;
-    int i;
-    int j;
-    TinValue pivot = l[pivotindex];
-    for(i = 0, j = length - 1;; i++, j--)
+    if(fixed)
     {
-        //while(i < pivotindex && COMPARE(state, callee, l[i], pivot))
-        while(i < pivotindex)
-        {
-            if((rt = COMPARE(state, callee, l[i], pivot)).type != TINSTATE_OK)
-            {
-                return;
-            }
-            if(tin_value_isfalsey(rt.result))
+        return TINSORT_FIXED;
+    }
+    if(floats)
+    {
+        return TINSORT_FLOAT;
+    }
+    if(numbers)
+    {
+        return TINSORT_NUMBER;
+    }
+    return TINSORT_STRING;
+}
+
+/*
+* fixed numbers: the number with its sign bit flipped.
+* float numbers: the bits of the double, all of them flipped for negative ones, just the sign bit otherwise.
+* this puts -0 before 0, and NaNs (which "<" can't order) at the ends.
+* strings: the first 8 bytes, big endian, padded with zeroes. equal keys still need a look at the strings.
+*/
+static uint64_t util_sort_key(int kind, TinValue value)
+{
+    size_t i;
+    size_t length;
+    uint64_t key;
+    double d;
+    TinString* string;
+    switch(kind)
+    {
+        case TINSORT_FIXED:
+            return (uint64_t)tin_value_asrawfixednumber(value) ^ ((uint64_t)1 << 63);
+        case TINSORT_FLOAT:
             {
-                break;
+                d = tin_value_asrawfloatnumber(value);
+                memcpy(&key, &d, sizeof(key));
+                if(key & ((uint64_t)1 << 63))
+                {
+                    return ~key;
+                }
+                return key | ((uint64_t)1 << 63);
             }
-            i++;
-        }
-        //while(j > pivotindex && COMPARE(state, callee, pivot, l[j]))
-        while(j > pivotindex)
-        {
-            if((rt = COMPARE(state, callee, pivot, l[j])).type != TINSTATE_OK)
+            break;
+        case TINSORT_STRING:
             {
-                return;
+                string = tin_value_asstring(value);
+                length = tin_string_getlength(string);
+                key = 0;
+                for(i = 0; i < 8; i++)
+                {
+                    key <<= 8;
+                    if(i < length)
+                    {
+                        key |= (uint8_t)string->data[i];
+                    }
+                }
+                return key;
             }
-            if(tin_value_isfalsey(rt.result))
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/* by bytes, like strcmp */
+static bool util_sort_stringless(TinString* a, TinString* b)
+{
+    int r;
+    size_t alen;
+    size_t blen;
+    if(a == b)
+    {
+        return false;
+    }
+    alen = tin_string_getlength(a);
+    blen = tin_string_getlength(b);
+    r = memcmp(a->data, b->data, (alen < blen) ? alen : blen);
+    if(r != 0)
+    {
+        return r < 0;
+    }
+    return alen < blen;
+}
+
+/* $kind is always a constant, so each instance of the sort only keeps its own case */
+TIN_SORT_INLINE bool util_sort_less(TinSortState* ss, int kind, TinSortItem* a, TinSortItem* b)
+{
+    TinValue argv[2];
+    TinInterpretResult r;
+    switch(kind)
+    {
+        case TINSORT_FIXED:
+        case TINSORT_FLOAT:
+            return a->key < b->key;
+        case TINSORT_STRING:
+            if(a->key != b->key)
             {
-                break;
+                return a->key < b->key;
             }
+            return util_sort_stringless(tin_value_asstring(a->value), tin_value_asstring(b->value));
+        case TINSORT_NUMBER:
+            return tin_value_asnumber(a->value) < tin_value_asnumber(b->value);
+        default:
+            break;
+    }
+    if(ss->failed)
+    {
+        return false;
+    }
+    if(kind == TINSORT_LESSTHAN)
+    {
+        if(tin_value_isnumber(a->value) && tin_value_isnumber(b->value))
+        {
+            return tin_value_asnumber(a->value) < tin_value_asnumber(b->value);
+        }
+        argv[0] = b->value;
+        r = tin_state_findandcallmethod(ss->state, a->value, ss->state->symbols[TINSYM_LESSTHAN], argv, 1, false);
+    }
+    else
+    {
+        argv[0] = a->value;
+        argv[1] = b->value;
+        r = tin_state_invokeprepared(&ss->call, argv);
+    }
+    if(r.type != TINSTATE_OK)
+    {
+        ss->failed = true;
+        return false;
+    }
+    return !tin_value_isfalsey(r.result);
+}
+
+TIN_SORT_INLINE void util_sort_insertion(TinSortState* ss, int kind, TinSortItem* items, size_t count)
+{
+    size_t i;
+    size_t j;
+    TinSortItem tmp;
+    for(i = 1; i < count; i++)
+    {
+        tmp = items[i];
+        j = i;
+        while(j > 0 && util_sort_less(ss, kind, &tmp, &items[j - 1]))
+        {
+            items[j] = items[j - 1];
             j--;
         }
-        if(i >= j)
+        items[j] = tmp;
+    }
+}
+
+/* merges src[lo .. mid) and src[mid .. hi) into dst[lo .. hi) */
+TIN_SORT_INLINE void util_sort_merge(TinSortState* ss, int kind, TinSortItem* src, TinSortItem* dst, size_t lo, size_t mid, size_t hi)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+    if(mid >= hi || !util_sort_less(ss, kind, &src[mid], &src[mid - 1]))
+    {
+        memcpy(dst + lo, src + lo, sizeof(TinSortItem) * (hi - lo));
+        return;
+    }
+    i = lo;
+    j = mid;
+    k = lo;
+    while(i < mid && j < hi)
+    {
+        /* ties take the left one, which keeps the sort stable */
+        if(util_sort_less(ss, kind, &src[j], &src[i]))
+        {
+            dst[k++] = src[j++];
+        }
+        else
         {
+            dst[k++] = src[i++];
+        }
+    }
+    memcpy(dst + k, src + i, sizeof(TinSortItem) * (mid - i));
+    k += mid - i;
+    memcpy(dst + k, src + j, sizeof(TinSortItem) * (hi - j));
+}
+
+/* sorts $items, using $scratch, which holds as many items */
+TIN_SORT_INLINE void util_sort_items(TinSortState* ss, int kind, TinSortItem* items, TinSortItem* scratch, size_t count)
+{
+    size_t lo;
+    size_t mid;
+    size_t hi;
+    size_t width;
+    TinSortItem* src;
+    TinSortItem* dst;
+    TinSortItem* tmp;
+    for(lo = 0; lo < count; lo += TIN_SORT_RUN)
+    {
+        util_sort_insertion(ss, kind, items + lo, (count - lo < TIN_SORT_RUN) ? (count - lo) : TIN_SORT_RUN);
+    }
+    src = items;
+    dst = scratch;
+    for(width = TIN_SORT_RUN; width < count && !ss->failed; width *= 2)
+    {
+        for(lo = 0; lo < count; lo += 2 * width)
+        {
+            mid = (lo + width < count) ? (lo + width) : count;
+            hi = (lo + 2 * width < count) ? (lo + 2 * width) : count;
+            util_sort_merge(ss, kind, src, dst, lo, mid, hi);
+        }
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if(src != items)
+    {
+        memcpy(items, src, sizeof(TinSortItem) * count);
+    }
+}
+
+static void util_sort_bykind(TinSortState* ss, int kind, TinSortItem* items, TinSortItem* scratch, size_t count)
+{
+    switch(kind)
+    {
+        case TINSORT_FIXED:
+            util_sort_items(ss, TINSORT_FIXED, items, scratch, count);
+            break;
+        case TINSORT_FLOAT:
+            util_sort_items(ss, TINSORT_FLOAT, items, scratch, count);
             break;
+        case TINSORT_NUMBER:
+            util_sort_items(ss, TINSORT_NUMBER, items, scratch, count);
+            break;
+        case TINSORT_STRING:
+            util_sort_items(ss, TINSORT_STRING, items, scratch, count);
+            break;
+        case TINSORT_LESSTHAN:
+            util_sort_items(ss, TINSORT_LESSTHAN, items, scratch, count);
+            break;
+        default:
+            util_sort_items(ss, TINSORT_CALLBACK, items, scratch, count);
+            break;
+    }
+}
+
+/*
+* sorts $array in place, with $comparator(a, b) returning true if a goes before b, or by "<" if $comparator is null.
+* returns false if a comparison failed; the array then holds the same values, in some order.
+*/
+bool util_sort_array(TinState* state, TinArray* array, TinValue comparator)
+{
+    size_t i;
+    size_t count;
+    int kind;
+    TinArray* keep;
+    TinSortItem* items;
+    TinSortState ss;
+    count = tin_vallist_count(&array->list);
+    if(count < 2)
+    {
+        return true;
+    }
+    ss.state = state;
+    ss.failed = false;
+    keep = NULL;
+    if(tin_value_isnull(comparator))
+    {
+        kind = util_sort_kindof(array->list.values, count);
+    }
+    else
+    {
+        kind = TINSORT_CALLBACK;
+        if(!tin_state_preparecall(state, &ss.call, comparator, 2))
+        {
+            return false;
+        }
+    }
+    items = (TinSortItem*)tin_gcmem_allocate(state, sizeof(TinSortItem), count * 2);
+    if(kind == TINSORT_LESSTHAN || kind == TINSORT_CALLBACK)
+    {
+        keep = tin_object_makearray(state);
+        tin_state_pushroot(state, (TinObject*)keep);
+        tin_vallist_ensuresize(state, &keep->list, count);
+        memcpy(keep->list.values, array->list.values, sizeof(TinValue) * count);
+    }
+    for(i = 0; i < count; i++)
+    {
+        items[i].value = array->list.values[i];
+        items[i].key = util_sort_key(kind, items[i].value);
+    }
+    util_sort_bykind(&ss, kind, items, items + count, count);
+    if(keep == NULL)
+    {
+        for(i = 0; i < count; i++)
+        {
+            array->list.values[i] = items[i].value;
         }
-        TinValue tmp = l[i];
-        l[i] = l[j];
-        l[j] = tmp;
     }
-    util_custom_quick_sort(vm, l, i, callee);
-    util_custom_quick_sort(vm, l + i, length - i, callee);
+    else
+    {
+        for(i = 0; i < count; i++)
+        {
+            tin_vallist_set(state, &array->list, i, items[i].value);
+        }
+        tin_state_poproot(state);
+    }
+    tin_gcmem_freearray(state, sizeof(TinSortItem), items, count * 2);
+    return !ss.failed;
 }
 
 bool util_is_fiber_done(TinFiber* fiber)
@@ -155,54 +451,6 @@ void util_run_fiber(TinVM* vm, TinFiber* fiber, TinValue* argv, size_t argc, boo
     }
 }
 
-static inline bool compare(TinState* state, TinValue a, TinValue b)
-{
-    TinValue argv[1];
-    if(tin_value_isnumber(a) && tin_value_isnumber(b))
-    {
-        return tin_value_asnumber(a) < tin_value_asnumber(b);
-    }
-    argv[0] = b;
-    return !tin_value_isfalsey(tin_state_findandcallmethod(state, a, tin_string_copyconst(state, "<"), argv, 1, false).result);
-}
-
-void util_basic_quick_sort(TinState* state, TinValue* clist, int length)
-{
-    int i;
-    int j;
-    int pivotindex;
-    TinValue tmp;
-    TinValue pivot;
-    if(length < 2)
-    {
-        return;
-    }
-    pivotindex = length / 2;
-    pivot = clist[pivotindex];
-    for(i = 0, j = length - 1;; i++, j--)
-    {
-        while(i < pivotindex && compare(state, clist[i], pivot))
-        {
-            i++;
-        }
-
-        while(j > pivotindex && compare(state, pivot, clist[j]))
-        {
-            j--;
-        }
-
-        if(i >= j)
-        {
-            break;
-        }
-        tmp = clist[i];
-        clist[i] = clist[j];
-        clist[j] = tmp;
-    }
-    util_basic_quick_sort(state, clist, i);
-    util_basic_quick_sort(state, clist + i, length - i);
-}
-
 bool util_interpret(TinVM* vm, TinModule* module)
 {
     TinFunction* function;
@@ -359,6 +607,7 @@ void tin_open_string_library(TinState* state);
 void tin_open_array_library(TinState* state);
 void tin_open_map_library(TinState* state);
 void tin_open_range_library(TinState* state);
+void tin_open_typedarray_library(TinState* state);
 void tin_open_fiber_library(TinState* state);
 void tin_open_module_library(TinState* state);
 void tin_state_openfunctionlibrary(TinState* state);
@@ -380,6 +629,7 @@ void tin_open_core_library(TinState* state)
         tin_open_array_library(state);
         tin_open_map_library(state);
         tin_open_range_library(state);
+        tin_open_typedarray_library(state);
         tin_open_fiber_library(state);
         tin_open_module_library(state);
         tin_state_openfunctionlibrary(state);
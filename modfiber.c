@@ -8,6 +8,10 @@ TinFiber* tin_object_makefiber(TinState* state, TinModule* module, TinFunction*
     TinCallFrame* frame;
     TinCallFrame* frames;
     TinFiber* fiber;
+    if(function != NULL)
+    {
+        tin_function_ensureloaded(state, function);
+    }
     // Allocate in advance, just in case GC is triggered
     stackcap = function == NULL ? 1 : (size_t)tin_util_closestpowof2(function->maxslots + 1);
     stack = (TinValue*)tin_gcmem_allocate(state, sizeof(TinValue), stackcap);
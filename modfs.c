@@ -59,21 +59,18 @@ static double g_tmpdouble;
 
 extern char* getcwd(char*, size_t);
 
-static void tin_ioutil_writechunk(FILE* fh, TinChunk* chunk);
-static void tin_ioutil_readchunk(TinState* state, TinEmulatedFile* femu, TinModule* module, TinChunk* chunk);
-
 static void* tin_util_instancedataset(TinVM* vm, TinValue instance, size_t typsz, CleanupFunc cleanup)
 {
     TinUserdata* userdata = tin_object_makeuserdata(vm->state, typsz, false);
     userdata->cleanupfn = cleanup;
-    tin_table_set(vm->state, &tin_value_asinstance(instance)->fields, tin_string_copyconst(vm->state, "_data"), tin_value_fromobject(userdata));
+    tin_instance_setfield(vm->state, tin_value_asinstance(instance), tin_string_copyconst(vm->state, "_data"), tin_value_fromobject(userdata));
     return userdata->data;
 }
 
 static void* tin_util_instancedataget(TinVM* vm, TinValue instance)
 {
     TinValue _d;
-    if(!tin_table_get(&tin_value_asinstance(instance)->fields, tin_string_copyconst(vm->state, "_data"), &_d))
+    if(!tin_instance_getfield(tin_value_asinstance(instance), tin_string_copyconst(vm->state, "_data"), &_d))
     {
         tin_vm_raiseexitingerror(vm, "failed to extract userdata");
     }
@@ -266,245 +263,6 @@ TinString* tin_emufile_readstring(TinState* state, TinEmulatedFile* femu)
     return tin_string_take(state, line, length, false);
 }
 
-static void tin_ioutil_writefunction(FILE* fh, TinFunction* function)
-{
-    tin_ioutil_writechunk(fh, &function->chunk);
-    tin_ioutil_writestring(fh, function->name);
-    tin_ioutil_writeuint8(fh, function->argcount);
-    tin_ioutil_writeuint16(fh, function->upvalcount);
-    tin_ioutil_writeuint8(fh, (uint8_t)function->vararg);
-    tin_ioutil_writeuint16(fh, (uint16_t)function->maxslots);
-}
-
-static TinFunction* tin_ioutil_readfunction(TinState* state, TinEmulatedFile* femu, TinModule* module)
-{
-    TinFunction* function;
-    function = tin_object_makefunction(state, module);
-    tin_ioutil_readchunk(state, femu, module, &function->chunk);
-    function->name = tin_emufile_readstring(state, femu);
-    function->argcount = tin_emufile_readuint8(femu);
-    function->upvalcount = tin_emufile_readuint16(femu);
-    function->vararg = (bool)tin_emufile_readuint8(femu);
-    function->maxslots = tin_emufile_readuint16(femu);
-    return function;
-}
-
-static void tin_ioutil_writechunk(FILE* fh, TinChunk* chunk)
-{
-    size_t i;
-    size_t c;
-    TinObjType type;
-    TinValue constant;
-    tin_ioutil_writeuint32(fh, chunk->count);
-    for(i = 0; i < chunk->count; i++)
-    {
-        tin_ioutil_writeuint8(fh, chunk->code[i]);
-    }
-    if(chunk->haslineinfo)
-    {
-        c = chunk->linecount * 2 + 2;
-        tin_ioutil_writeuint32(fh, c);
-        for(i = 0; i < c; i++)
-        {
-            tin_ioutil_writeuint16(fh, chunk->lines[i]);
-        }
-    }
-    else
-    {
-        tin_ioutil_writeuint32(fh, 0);
-    }
-    tin_ioutil_writeuint32(fh, tin_vallist_count(&chunk->constants));
-    for(i = 0; i < tin_vallist_count(&chunk->constants); i++)
-    {
-        constant = tin_vallist_get(&chunk->constants, i);
-        if(tin_value_isobject(constant))
-        {
-            type = tin_value_asobject(constant)->type;
-            tin_ioutil_writeuint8(fh, (uint8_t)(type + 1));
-            switch(type)
-            {
-                case TINTYPE_STRING:
-                    {
-                        tin_ioutil_writestring(fh, tin_value_asstring(constant));
-                    }
-                    break;
-                case TINTYPE_FUNCTION:
-                    {
-                        tin_ioutil_writefunction(fh, tin_value_asfunction(constant));
-                    }
-                    break;
-                default:
-                    {
-                        UNREACHABLE
-                    }
-                    break;
-            }
-        }
-        else
-        {
-            tin_ioutil_writeuint8(fh, 0);
-            tin_ioutil_writedouble(fh, tin_value_asnumber(constant));
-        }
-    }
-}
-
-static void tin_ioutil_readchunk(TinState* state, TinEmulatedFile* femu, TinModule* module, TinChunk* chunk)
-{
-    size_t i;
-    size_t count;
-    uint8_t type;
-    tin_chunk_init(state, chunk);
-    count = tin_emufile_readuint32(femu);
-    chunk->code = (uint8_t*)tin_gcmem_memrealloc(state, NULL, 0, sizeof(uint8_t) * count);
-    chunk->count = count;
-    chunk->capacity = count;
-    for(i = 0; i < count; i++)
-    {
-        chunk->code[i] = tin_emufile_readuint8(femu);
-    }
-    count = tin_emufile_readuint32(femu);
-    if(count > 0)
-    {
-        chunk->lines = (uint16_t*)tin_gcmem_memrealloc(state, NULL, 0, sizeof(uint16_t) * count);
-        chunk->linecount = count;
-        chunk->linecap = count;
-        for(i = 0; i < count; i++)
-        {
-            chunk->lines[i] = tin_emufile_readuint16(femu);
-        }
-    }
-    else
-    {
-        chunk->haslineinfo = false;
-    }
-    count = tin_emufile_readuint32(femu);
-    /*
-    chunk->constants.values = (TinValue*)tin_gcmem_memrealloc(state, NULL, 0, sizeof(TinValue) * count);
-    chunk->constants.count = count;
-    chunk->constants.capacity = count;
-    */
-    tin_vallist_init(state, &chunk->constants);
-    tin_vallist_ensuresize(state, &chunk->constants, count);
-    for(i = 0; i < count; i++)
-    {
-        type = tin_emufile_readuint8(femu);
-        if(type == 0)
-        {
-            //chunk->constants.values[i] = tin_value_makenumber(vm->state, tin_emufile_readdouble(femu));
-            tin_vallist_set(state, &chunk->constants, i, tin_value_makefloatnumber(state, tin_emufile_readdouble(femu)));
-        }
-        else
-        {
-            switch((TinObjType)(type - 1))
-            {
-                case TINTYPE_STRING:
-                    {
-                        //chunk->constants.values[i] = tin_value_fromobject(tin_emufile_readstring(state, femu));
-                        tin_vallist_set(state, &chunk->constants, i, tin_value_fromobject(tin_emufile_readstring(state, femu)));
-
-                    }
-                    break;
-                case TINTYPE_FUNCTION:
-                    {
-                        //chunk->constants.values[i] = tin_value_fromobject(tin_ioutil_readfunction(state, femu, module));
-                        tin_vallist_set(state, &chunk->constants, i, tin_value_fromobject(tin_ioutil_readfunction(state, femu, module)));
-                    }
-                    break;
-                default:
-                    {
-                        UNREACHABLE
-                    }
-                    break;
-            }
-        }
-    }
-}
-
-void tin_ioutil_writemodule(TinModule* module, FILE* fh)
-{
-    size_t i;
-    bool disabled;
-    TinTabEntry* ent;
-    TinTable* privates;
-    disabled = tin_astopt_isoptenabled(TINOPTSTATE_PRIVATENAMES);
-    tin_ioutil_writestring(fh, module->name);
-    tin_ioutil_writeuint16(fh, module->privcount);
-    tin_ioutil_writeuint8(fh, (uint8_t)disabled);
-    if(!disabled)
-    {
-        privates = &module->privnames->values;
-        for(i = 0; i < module->privcount; i++)
-        {
-            ent = tin_table_getindex(privates, i);
-            if(ent->key != NULL)
-            {
-                tin_ioutil_writestring(fh, ent->key);
-                tin_ioutil_writeuint16(fh, (uint16_t)tin_value_asnumber(ent->value));
-            }
-        }
-    }
-    tin_ioutil_writefunction(fh, module->mainfunction);
-}
-
-TinModule* tin_ioutil_readmodule(TinState* state, const char* input, size_t len)
-{
-    bool enabled;
-    uint16_t i;
-    uint16_t j;
-    uint16_t modulecount;
-    uint16_t privatescount;
-    uint8_t bytecodeversion;
-    TinString* name;
-    TinTable* privates;
-    TinModule* module;
-    TinEmulatedFile femu;
-    tin_emufile_init(&femu, input, len);
-    if(tin_emufile_readuint16(&femu) != TIN_BYTECODE_MAGIC_NUMBER)
-    {
-        tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, unknown magic number");
-        return NULL;
-    }
-    bytecodeversion = tin_emufile_readuint8(&femu);
-    if(bytecodeversion > TIN_BYTECODE_VERSION)
-    {
-        tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, unknown bytecode version '%i'", (int)bytecodeversion);
-        return NULL;
-    }
-    modulecount = tin_emufile_readuint16(&femu);
-    TinModule* first = NULL;
-    for(j = 0; j < modulecount; j++)
-    {
-        module = tin_object_makemodule(state, tin_emufile_readstring(state, &femu));
-        privates = &module->privnames->values;
-        privatescount = tin_emufile_readuint16(&femu);
-        enabled = !((bool)tin_emufile_readuint8(&femu));
-        module->privates = (TinValue*)tin_gcmem_allocate(state, sizeof(TinValue), privatescount);
-        module->privcount = privatescount;
-        for(i = 0; i < privatescount; i++)
-        {
-            module->privates[i] = tin_value_makenull(state);
-            if(enabled)
-            {
-                name = tin_emufile_readstring(state, &femu);
-                tin_table_set(state, privates, name, tin_value_makefixednumber(state, tin_emufile_readuint16(&femu)));
-            }
-        }
-        module->mainfunction = tin_ioutil_readfunction(state, &femu, module);
-        tin_table_set(state, &state->vm->modules->values, module->name, tin_value_fromobject(module));
-        if(j == 0)
-        {
-            first = module;
-        }
-    }
-    if(tin_emufile_readuint16(&femu) != TIN_BYTECODE_END_NUMBER)
-    {
-        tin_state_raiseerror(state, COMPILE_ERROR, "Failed to read compiled code, unknown end number");
-        return NULL;
-    }
-    return first;
-}
-
-
 /*
  * File
  */
@@ -835,8 +593,7 @@ static TinValue objmethod_file_readall(TinVM* vm, TinValue instance, size_t argc
         */
         sds_internincrlength(result->data, actuallen);
     }
-    result->hash = tin_util_hashstring(result->data, actuallen);
-    tin_strreg_put(vm->state, result);
+    /* left uninterned: file contents are rarely used as a table key */
     return tin_value_fromobject(result);
 }
 
@@ -888,9 +645,7 @@ static TinValue objmethod_file_readamount(TinVM* vm, TinValue instance, size_t a
     }
     /* important: until sds_internincrlength is called, the string is zero-length. */
     sds_internincrlength(result->data, actuallen);
-    /* insert string into the gc matrix. */
-    result->hash = tin_util_hashstring(result->data, actuallen);
-    tin_strreg_put(vm->state, result);
+    /* like readAll, the result is not interned */
     return tin_value_fromobject(result);
 }
 
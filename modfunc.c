@@ -12,6 +12,8 @@ TinFunction* tin_object_makefunction(TinState* state, TinModule* module)
     function->maxslots = 0;
     function->module = module;
     function->vararg = false;
+    function->image = NULL;
+    function->imageindex = 0;
     return function;
 }
 
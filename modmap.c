@@ -1,27 +1,108 @@
 
 #include "priv.h"
 
-#define TABLE_MAX_LOAD 0.85
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define TIN_TABLE_USESSE2
+#endif
+
+/*
+* tables are open addressed, swisstable style: next to the entries lives an array of control bytes,
+* one per slot. a used slot holds the low 7 bits of its key's hash (h2), so most mismatches are
+* rejected without touching the entry. the remaining bits (h1) pick the slot the probe starts at.
+* probing looks at TIN_TABLE_GROUPWIDTH control bytes at a time, and walks groups triangularly,
+* which visits every group of a power of two sized table.
+*/
+#define TIN_TABLE_CTRLEMPTY 0x80
+#define TIN_TABLE_CTRLDELETED 0xFE
+
+#define TIN_TABLE_H1(hash) ((hash) >> 7)
+#define TIN_TABLE_H2(hash) ((uint8_t)((hash) & 0x7F))
 
 #define TIN_MODMAP_GROWCAPACITY(cap) \
-    (((cap) < 8) ? (8) : ((cap) * 2))
+    (((cap) < TIN_TABLE_MINCAPACITY) ? (TIN_TABLE_MINCAPACITY) : ((cap) * 2))
 
+/* bit i of the result is set if control byte i of the group starting at $ctrl equals $h2 */
+static inline uint32_t tin_table_groupmatch(const uint8_t* ctrl, uint8_t h2)
+{
+#if defined(TIN_TABLE_USESSE2)
+    __m128i group;
+    group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+#else
+    int i;
+    uint32_t mask;
+    mask = 0;
+    for(i = 0; i < TIN_TABLE_GROUPWIDTH; i++)
+    {
+        if(ctrl[i] == h2)
+        {
+            mask |= (1u << i);
+        }
+    }
+    return mask;
+#endif
+}
+
+/* bit i of the result is set if slot i of the group has never been used */
+static inline uint32_t tin_table_groupmatchempty(const uint8_t* ctrl)
+{
+    return tin_table_groupmatch(ctrl, TIN_TABLE_CTRLEMPTY);
+}
+
+/* bit i of the result is set if slot i of the group is empty or deleted: those are the ones with the high bit set */
+static inline uint32_t tin_table_groupmatchfree(const uint8_t* ctrl)
+{
+#if defined(TIN_TABLE_USESSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    int i;
+    uint32_t mask;
+    mask = 0;
+    for(i = 0; i < TIN_TABLE_GROUPWIDTH; i++)
+    {
+        if(ctrl[i] & 0x80)
+        {
+            mask |= (1u << i);
+        }
+    }
+    return mask;
+#endif
+}
+
+/* writes the control byte of $index, and its mirror past the end of the array */
+static inline void tin_table_setctrl(TinTable* table, int index, uint8_t ctrl)
+{
+    int i;
+    table->control[index] = ctrl;
+    for(i = index + table->capacity; i < table->capacity + TIN_TABLE_GROUPWIDTH; i += table->capacity)
+    {
+        table->control[i] = ctrl;
+    }
+}
 
 void tin_table_init(TinState* state, TinTable* table)
 {
     table->state = state;
-    table->capacity = -1;
+    table->owner = NULL;
+    table->capacity = 0;
     table->count = 0;
+    table->growthleft = 0;
+    table->control = NULL;
     table->entries = NULL;
 }
 
 void tin_table_destroy(TinState* state, TinTable* table)
 {
+    TinObject* owner;
     if(table->capacity > 0)
     {
-        tin_gcmem_freearray(state, sizeof(TinTabEntry), table->entries, table->capacity + 1);
+        tin_gcmem_freearray(state, sizeof(TinTabEntry), table->entries, table->capacity);
+        tin_gcmem_freearray(state, sizeof(uint8_t), table->control, table->capacity + TIN_TABLE_GROUPWIDTH);
     }
+    owner = table->owner;
     tin_table_init(state, table);
+    table->owner = owner;
 }
 
 TinTabEntry* tin_table_getindex(TinTable* tab, size_t idx)
@@ -29,6 +110,7 @@ TinTabEntry* tin_table_getindex(TinTable* tab, size_t idx)
     return &tab->entries[idx];
 }
 
+/* the number of slots. entries can be walked with tin_table_getindex from 0 up to this, skipping those with a NULL key */
 size_t tin_table_getcapacity(TinTable* tab)
 {
     return tab->capacity;
@@ -40,161 +122,290 @@ size_t tin_table_getcount(TinTable* tab)
     return tab->count;
 }
 
-
-static TinTabEntry* tin_table_findentry(TinTabEntry* entries, int capacity, TinString* key)
-{
+/*
+* keys in a table are interned, so finding an interned $key only needs to compare pointers.
+* a $key that is not interned (see tin_string_intern) is compared by its text.
+* returns the slot of $key, or -1.
+*/
+static int tin_table_findslot(TinTable* table, TinString* key)
+{
+    int bit;
+    uint8_t h2;
+    uint32_t hash;
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t stride;
+    uint32_t match;
     uint32_t index;
-    TinTabEntry* entry;
-    TinTabEntry* tombstone;
-    index = key->hash % capacity;
-    tombstone = NULL;
+    TinString* other;
+    hash = tin_string_gethash(key);
+    h2 = TIN_TABLE_H2(hash);
+    mask = (uint32_t)table->capacity - 1;
+    pos = TIN_TABLE_H1(hash) & mask;
+    /* most hits are in the home slot: start fetching it while the control bytes are looked at */
+    __builtin_prefetch(&table->entries[pos]);
+    stride = 0;
     while(true)
     {
-        entry = &entries[index];
-        if(entry->key == NULL)
+        match = tin_table_groupmatch(&table->control[pos], h2);
+        while(match != 0)
         {
-            if(tin_value_isnull(entry->value))
+            bit = __builtin_ctz(match);
+            match &= (match - 1);
+            index = (pos + bit) & mask;
+            other = table->entries[index].key;
+            if(other == key)
             {
-                return tombstone != NULL ? tombstone : entry;
+                return (int)index;
             }
-            else if(tombstone == NULL)
+            if(!key->interned && tin_string_gethash(other) == hash && tin_string_equal(NULL, other, key))
             {
-                tombstone = entry;
+                return (int)index;
             }
         }
-        if(entry->key == key)
+        if(tin_table_groupmatchempty(&table->control[pos]) != 0)
         {
-            return entry;
+            return -1;
         }
-        index = (index + 1) % capacity;
+        stride += TIN_TABLE_GROUPWIDTH;
+        pos = (pos + stride) & mask;
     }
-    return NULL;
+    return -1;
+}
+
+/* returns the first empty or deleted slot on the probe sequence of $hash. there always is one */
+static int tin_table_findfree(TinTable* table, uint32_t hash)
+{
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t stride;
+    uint32_t match;
+    mask = (uint32_t)table->capacity - 1;
+    pos = TIN_TABLE_H1(hash) & mask;
+    stride = 0;
+    while(true)
+    {
+        match = tin_table_groupmatchfree(&table->control[pos]);
+        if(match != 0)
+        {
+            return (int)((pos + __builtin_ctz(match)) & mask);
+        }
+        stride += TIN_TABLE_GROUPWIDTH;
+        pos = (pos + stride) & mask;
+    }
+    return -1;
 }
 
+/* moves every entry into fresh arrays of $capacity slots, which also drops all deleted slots */
 static void tin_table_adjustcapacity(TinState* state, TinTable* table, int capacity)
 {
     int i;
-    TinTabEntry* destination;
+    int index;
+    int oldcapacity;
+    uint32_t hash;
+    uint8_t* control;
+    uint8_t* oldcontrol;
     TinTabEntry* entries;
+    TinTabEntry* oldentries;
     TinTabEntry* entry;
-    entries = (TinTabEntry*)tin_gcmem_allocate(state, sizeof(TinTabEntry), capacity + 1);
-    for(i = 0; i <= capacity; i++)
+    /* either allocation may collect, which walks (and prunes) the old arrays; those stay valid until the swap */
+    entries = (TinTabEntry*)tin_gcmem_allocate(state, sizeof(TinTabEntry), capacity);
+    control = (uint8_t*)tin_gcmem_allocate(state, sizeof(uint8_t), capacity + TIN_TABLE_GROUPWIDTH);
+    for(i = 0; i < capacity; i++)
     {
         entries[i].key = NULL;
         entries[i].value = tin_value_makenull(state);
     }
+    memset(control, TIN_TABLE_CTRLEMPTY, capacity + TIN_TABLE_GROUPWIDTH);
+    oldcapacity = table->capacity;
+    oldentries = table->entries;
+    oldcontrol = table->control;
+    table->capacity = capacity;
+    table->entries = entries;
+    table->control = control;
     table->count = 0;
-    for(i = 0; i <= table->capacity; i++)
+    for(i = 0; i < oldcapacity; i++)
     {
-        entry = &table->entries[i];
+        entry = &oldentries[i];
         if(entry->key == NULL)
         {
             continue;
         }
-        destination = tin_table_findentry(entries, capacity, entry->key);
-        destination->key = entry->key;
-        destination->value = entry->value;
+        hash = tin_string_gethash(entry->key);
+        index = tin_table_findfree(table, hash);
+        tin_table_setctrl(table, index, TIN_TABLE_H2(hash));
+        entries[index] = *entry;
         table->count++;
     }
-    tin_gcmem_freearray(state, sizeof(TinTabEntry), table->entries, table->capacity + 1);
-    table->capacity = capacity;
-    table->entries = entries;
+    table->growthleft = ((capacity * TIN_TABLE_MAXLOADNUM) / TIN_TABLE_MAXLOADDEN) - table->count;
+    if(oldcapacity > 0)
+    {
+        tin_gcmem_freearray(state, sizeof(TinTabEntry), oldentries, oldcapacity);
+        tin_gcmem_freearray(state, sizeof(uint8_t), oldcontrol, oldcapacity + TIN_TABLE_GROUPWIDTH);
+    }
 }
 
-bool tin_table_set(TinState* state, TinTable* table, TinString* key, TinValue value)
+/* makes room for one more entry: grows the table, or, if it is mostly deleted slots, rehashes it in place */
+static void tin_table_reserve(TinState* state, TinTable* table)
 {
-    bool isnew;
     int capacity;
-    TinTabEntry* entry;
-    if((table->count + 1) > ((table->capacity + 1) * TABLE_MAX_LOAD))
+    capacity = table->capacity;
+    if(capacity == 0 || (table->count + 1) > ((capacity * TIN_TABLE_MAXLOADNUM) / (TIN_TABLE_MAXLOADDEN * 2)))
     {
-        capacity = TIN_MODMAP_GROWCAPACITY(table->capacity + 1) - 1;
-        tin_table_adjustcapacity(state, table, capacity);
+        capacity = TIN_MODMAP_GROWCAPACITY(capacity);
     }
-    entry = tin_table_findentry(table->entries, table->capacity, key);
-    isnew = entry->key == NULL;
-    if(isnew && tin_value_isnull(entry->value))
+    tin_table_adjustcapacity(state, table, capacity);
+}
+
+bool tin_table_set(TinState* state, TinTable* table, TinString* key, TinValue value)
+{
+    int index;
+    uint32_t hash;
+    if(!key->interned)
     {
-        table->count++;
+        tin_state_pushvalueroot(state, value);
+        key = tin_string_intern(state, key);
+        tin_state_poproot(state);
     }
-    entry->key = key;
-    entry->value = value;
-    return isnew;
+    if(table->count > 0)
+    {
+        index = tin_table_findslot(table, key);
+        if(index != -1)
+        {
+            table->entries[index].value = value;
+            tin_gcmem_writebarrier(state, table->owner, value);
+            return false;
+        }
+    }
+    hash = tin_string_gethash(key);
+    index = table->capacity == 0 ? -1 : tin_table_findfree(table, hash);
+    if(index == -1 || (table->control[index] == TIN_TABLE_CTRLEMPTY && table->growthleft == 0))
+    {
+        tin_state_pushroot(state, (TinObject*)key);
+        tin_state_pushvalueroot(state, value);
+        tin_table_reserve(state, table);
+        tin_state_poproots(state, 2);
+        index = tin_table_findfree(table, hash);
+    }
+    if(table->control[index] == TIN_TABLE_CTRLEMPTY)
+    {
+        table->growthleft--;
+    }
+    tin_table_setctrl(table, index, TIN_TABLE_H2(hash));
+    table->entries[index].key = key;
+    table->entries[index].value = value;
+    table->count++;
+    tin_gcmem_barrierobject(state, table->owner, (TinObject*)key);
+    tin_gcmem_writebarrier(state, table->owner, value);
+    return true;
 }
 
 bool tin_table_get(TinTable* table, TinString* key, TinValue* value)
 {
-    TinTabEntry* entry;
+    int index;
     if(table->count == 0)
     {
         return false;
     }
-    entry = tin_table_findentry(table->entries, table->capacity, key);
-    if(entry->key == NULL)
+    index = tin_table_findslot(table, key);
+    if(index == -1)
     {
         return false;
     }
-    *value = entry->value;
+    *value = table->entries[index].value;
     return true;
 }
 
 bool tin_table_get_slot(TinTable* table, TinString* key, TinValue** value)
 {
-    TinTabEntry* entry;
+    int index;
     if(table->count == 0)
     {
         return false;
     }
-    entry = tin_table_findentry(table->entries, table->capacity, key);
-    if(entry->key == NULL)
+    index = tin_table_findslot(table, key);
+    if(index == -1)
     {
         return false;
     }
-    *value = &entry->value;
+    *value = &table->entries[index].value;
     return true;
 }
 
 bool tin_table_delete(TinTable* table, TinString* key)
 {
-    TinTabEntry* entry;
+    int index;
     if(table->count == 0)
     {
         return false;
     }
-    entry = tin_table_findentry(table->entries, table->capacity, key);
-    if(entry->key == NULL)
+    index = tin_table_findslot(table, key);
+    if(index == -1)
     {
         return false;
     }
-    entry->key = NULL;
-    entry->value = tin_value_makebool(table->state, true);
+    /* the slot stays on the probe sequences running through it, so it can't go back to empty */
+    tin_table_setctrl(table, index, TIN_TABLE_CTRLDELETED);
+    table->entries[index].key = NULL;
+    table->entries[index].value = tin_value_makenull(table->state);
+    table->count--;
     return true;
 }
 
+/* removes every entry, but keeps the slots allocated */
+void tin_table_clear(TinTable* table)
+{
+    int i;
+    if(table->capacity == 0)
+    {
+        return;
+    }
+    for(i = 0; i < table->capacity; i++)
+    {
+        table->entries[i].key = NULL;
+        table->entries[i].value = tin_value_makenull(table->state);
+    }
+    memset(table->control, TIN_TABLE_CTRLEMPTY, table->capacity + TIN_TABLE_GROUPWIDTH);
+    table->count = 0;
+    table->growthleft = (table->capacity * TIN_TABLE_MAXLOADNUM) / TIN_TABLE_MAXLOADDEN;
+}
+
 TinString* tin_table_findstring(TinTable* table, const char* chars, size_t length, uint32_t hash)
 {
-    uint32_t index;
-    TinTabEntry* entry;
+    int bit;
+    uint8_t h2;
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t stride;
+    uint32_t match;
+    TinString* key;
     if(table->count == 0)
     {
         return NULL;
     }
-    index = hash % table->capacity;
+    h2 = TIN_TABLE_H2(hash);
+    mask = (uint32_t)table->capacity - 1;
+    pos = TIN_TABLE_H1(hash) & mask;
+    stride = 0;
     while(true)
     {
-        entry = &table->entries[index];
-        if(entry->key == NULL)
+        match = tin_table_groupmatch(&table->control[pos], h2);
+        while(match != 0)
         {
-            if(tin_value_isnull(entry->value))
+            bit = __builtin_ctz(match);
+            match &= (match - 1);
+            key = table->entries[(pos + bit) & mask].key;
+            if(tin_string_getlength(key) == length && key->hash == hash && memcmp(key->data, chars, length) == 0)
             {
-                return NULL;
+                return key;
             }
         }
-        if(tin_string_getlength(entry->key) == length && entry->key->hash == hash && memcmp(entry->key->data, chars, length) == 0)
+        if(tin_table_groupmatchempty(&table->control[pos]) != 0)
         {
-            return entry->key;
+            return NULL;
         }
-        index = (index + 1) % table->capacity;
+        stride += TIN_TABLE_GROUPWIDTH;
+        pos = (pos + stride) & mask;
     }
     return NULL;
 }
@@ -203,7 +414,7 @@ void tin_table_add_all(TinState* state, TinTable* from, TinTable* to)
 {
     int i;
     TinTabEntry* entry;
-    for(i = 0; i <= from->capacity; i++)
+    for(i = 0; i < from->capacity; i++)
     {
         entry = &from->entries[i];
         if(entry->key != NULL)
@@ -217,16 +428,20 @@ void tin_table_removewhite(TinTable* table)
 {
     int i;
     TinTabEntry* entry;
-    for(i = 0; i <= table->capacity; i++)
+    for(i = 0; i < table->capacity; i++)
     {
         entry = &table->entries[i];
-        if(entry->key != NULL && !entry->key->object.marked)
+        if(entry->key != NULL && !tin_gcmem_ismarked(&entry->key->object))
         {
-            tin_table_delete(table, entry->key);
+            tin_table_setctrl(table, i, TIN_TABLE_CTRLDELETED);
+            entry->key = NULL;
+            entry->value = tin_value_makenull(table->state);
+            table->count--;
         }
     }
 }
 
+/* returns the slot of the next entry after slot $number (-1 to start), or -1 once there are no more */
 int util_table_iterator(TinTable* table, int number)
 {
     if(table->count == 0)
@@ -251,7 +466,7 @@ int util_table_iterator(TinTable* table, int number)
 
 TinValue util_table_iterator_key(TinTable* table, int index)
 {
-    if(table->capacity <= index)
+    if(index < 0 || table->capacity <= index)
     {
         return tin_value_makenull(table->state);
     }
@@ -263,6 +478,7 @@ TinMap* tin_object_makemap(TinState* state)
     TinMap* map;
     map = (TinMap*)tin_object_allocobject(state, sizeof(TinMap), TINTYPE_MAP, false);
     tin_table_init(state, &map->values);
+    map->values.owner = (TinObject*)map;
     map->onindexfn = NULL;
     return map;
 }
@@ -298,7 +514,11 @@ void tin_map_add_all(TinState* state, TinMap* from, TinMap* to)
 {
     int i;
     TinTabEntry* entry;
-    for(i = 0; i <= from->values.capacity; i++)
+    if(from == state->vm->globals)
+    {
+        tin_vm_syncglobals(state->vm);
+    }
+    for(i = 0; i < from->values.capacity; i++)
     {
         entry = &from->values.entries[i];
         if(entry->key != NULL)
@@ -369,13 +589,13 @@ static TinValue objfn_map_clear(TinVM* vm, TinValue instance, size_t argc, TinVa
     (void)vm;
     (void)argv;
     (void)argc;
-    tin_value_asmap(instance)->values.count = 0;
+    tin_table_clear(&tin_value_asmap(instance)->values);
     return tin_value_makenull(vm->state);
 }
 
 static TinValue objfn_map_iterator(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
-    if(tin_args_ensure(vm->state, argc, 1))
+    if(!tin_args_ensure(vm->state, argc, 1))
     {
         return tin_value_makenull(vm->state);
     }
@@ -405,6 +625,10 @@ static TinValue objfn_map_clone(TinVM* vm, TinValue instance, size_t argc, TinVa
     TinState* state;
     TinMap* map;
     state = vm->state;
+    if(tin_value_asmap(instance) == vm->globals)
+    {
+        tin_vm_syncglobals(vm);
+    }
     map = tin_object_makemap(state);
     tin_table_add_all(state, &tin_value_asmap(instance)->values, &map->values);
     return tin_value_fromobject(map);
@@ -158,7 +158,7 @@ static size_t* extract_random_data(TinState* state, TinValue instance)
     {
         return &staticrandomdata;
     }
-    if(!tin_table_get(&tin_value_asinstance(instance)->fields, tin_string_copyconst(state, "_data"), &data))
+    if(!tin_instance_getfield(tin_value_asinstance(instance), tin_string_copyconst(state, "_data"), &data))
     {
         return 0;
     }
@@ -171,7 +171,7 @@ static TinValue random_constructor(TinVM* vm, TinValue instance, size_t argc, Ti
     size_t number;
     TinUserdata* userdata;
     userdata = tin_object_makeuserdata(vm->state, sizeof(size_t), false);
-    tin_table_set(vm->state, &tin_value_asinstance(instance)->fields, tin_string_copyconst(vm->state, "_data"), tin_value_fromobject(userdata));
+    tin_instance_setfield(vm->state, tin_value_asinstance(instance), tin_string_copyconst(vm->state, "_data"), tin_value_fromobject(userdata));
     data = (size_t*)userdata->data;
     if(argc == 1)
     {
@@ -78,7 +78,7 @@ void tin_object_destroy(TinState* state, TinObject* object)
             {
                 if(object->mustfree)
                 {
-                    tin_gcmem_free(state, sizeof(TinNumber), object);
+                    tin_gcmem_freeobject(state, sizeof(TinNumber), object);
                 }
             }
             break;
@@ -88,7 +88,7 @@ void tin_object_destroy(TinState* state, TinObject* object)
                 //tin_gcmem_freearray(state, sizeof(char), string->data, string->length + 1);
                 sds_destroy(string->data);
                 string->data = NULL;
-                tin_gcmem_free(state, sizeof(TinString), object);
+                tin_gcmem_freeobject(state, sizeof(TinString), object);
             }
             break;
 
@@ -96,27 +96,27 @@ void tin_object_destroy(TinState* state, TinObject* object)
             {
                 function = (TinFunction*)object;
                 tin_chunk_destroy(state, &function->chunk);
-                tin_gcmem_free(state, sizeof(TinFunction), object);
+                tin_gcmem_freeobject(state, sizeof(TinFunction), object);
             }
             break;
         case TINTYPE_NATIVEFUNCTION:
             {
-                tin_gcmem_free(state, sizeof(TinNativeFunction), object);
+                tin_gcmem_freeobject(state, sizeof(TinNativeFunction), object);
             }
             break;
         case TINTYPE_NATIVEPRIMITIVE:
             {
-                tin_gcmem_free(state, sizeof(TinNativePrimFunction), object);
+                tin_gcmem_freeobject(state, sizeof(TinNativePrimFunction), object);
             }
             break;
         case TINTYPE_NATIVEMETHOD:
             {
-                tin_gcmem_free(state, sizeof(TinNativeMethod), object);
+                tin_gcmem_freeobject(state, sizeof(TinNativeMethod), object);
             }
             break;
         case TINTYPE_PRIMITIVEMETHOD:
             {
-                tin_gcmem_free(state, sizeof(TinPrimitiveMethod), object);
+                tin_gcmem_freeobject(state, sizeof(TinPrimitiveMethod), object);
             }
             break;
         case TINTYPE_FIBER:
@@ -124,26 +124,26 @@ void tin_object_destroy(TinState* state, TinObject* object)
                 fiber = (TinFiber*)object;
                 tin_gcmem_freearray(state, sizeof(TinCallFrame), fiber->framevalues, fiber->framecap);
                 tin_gcmem_freearray(state, sizeof(TinValue), fiber->stackvalues, fiber->stackcap);
-                tin_gcmem_free(state, sizeof(TinFiber), object);
+                tin_gcmem_freeobject(state, sizeof(TinFiber), object);
             }
             break;
         case TINTYPE_MODULE:
             {
                 module = (TinModule*)object;
                 tin_gcmem_freearray(state, sizeof(TinValue), module->privates, module->privcount);
-                tin_gcmem_free(state, sizeof(TinModule), object);
+                tin_gcmem_freeobject(state, sizeof(TinModule), object);
             }
             break;
         case TINTYPE_CLOSURE:
             {
                 closure = (TinClosure*)object;
                 tin_gcmem_freearray(state, sizeof(TinUpvalue*), closure->upvalues, closure->upvalcount);
-                tin_gcmem_free(state, sizeof(TinClosure), object);
+                tin_gcmem_freeobject(state, sizeof(TinClosure), object);
             }
             break;
         case TINTYPE_UPVALUE:
             {
-                tin_gcmem_free(state, sizeof(TinUpvalue), object);
+                tin_gcmem_freeobject(state, sizeof(TinUpvalue), object);
             }
             break;
         case TINTYPE_CLASS:
@@ -151,19 +151,21 @@ void tin_object_destroy(TinState* state, TinObject* object)
                 TinClass* klass = (TinClass*)object;
                 tin_table_destroy(state, &klass->methods);
                 tin_table_destroy(state, &klass->staticfields);
-                tin_gcmem_free(state, sizeof(TinClass), object);
+                tin_shape_destroy(state, klass->rootshape);
+                tin_gcmem_freeobject(state, sizeof(TinClass), object);
             }
             break;
 
         case TINTYPE_INSTANCE:
             {
-                tin_table_destroy(state, &((TinInstance*)object)->fields);
-                tin_gcmem_free(state, sizeof(TinInstance), object);
+                TinInstance* inst = (TinInstance*)object;
+                tin_instance_destroyfields(state, inst);
+                tin_gcmem_freeobject(state, sizeof(TinInstance) + (sizeof(TinValue) * inst->inlinecap), object);
             }
             break;
         case TINTYPE_BOUNDMETHOD:
             {
-                tin_gcmem_free(state, sizeof(TinBoundMethod), object);
+                tin_gcmem_freeobject(state, sizeof(TinBoundMethod), object);
             }
             break;
         case TINTYPE_ARRAY:
@@ -174,7 +176,7 @@ void tin_object_destroy(TinState* state, TinObject* object)
         case TINTYPE_MAP:
             {
                 tin_table_destroy(state, &((TinMap*)object)->values);
-                tin_gcmem_free(state, sizeof(TinMap), object);
+                tin_gcmem_freeobject(state, sizeof(TinMap), object);
             }
             break;
         case TINTYPE_USERDATA:
@@ -191,23 +193,33 @@ void tin_object_destroy(TinState* state, TinObject* object)
                         tin_gcmem_memrealloc(state, data->data, data->size, 0);
                     }
                 }
-                tin_gcmem_free(state, sizeof(TinUserdata), data);
+                tin_gcmem_freeobject(state, sizeof(TinUserdata), data);
                 //free(data);
             }
             break;
         case TINTYPE_RANGE:
             {
-                tin_gcmem_free(state, sizeof(TinRange), object);
+                tin_gcmem_freeobject(state, sizeof(TinRange), object);
+            }
+            break;
+        case TINTYPE_TYPEDARRAY:
+            {
+                tin_typedarray_destroy(state, (TinTypedArray*)object);
+            }
+            break;
+        case TINTYPE_STRINGBUILDER:
+            {
+                tin_stringbuilder_destroy(state, (TinStringBuilder*)object);
             }
             break;
         case TINTYPE_FIELD:
             {
-                tin_gcmem_free(state, sizeof(TinField), object);
+                tin_gcmem_freeobject(state, sizeof(TinField), object);
             }
             break;
         case TINTYPE_REFERENCE:
             {
-                tin_gcmem_free(state, sizeof(TinReference), object);
+                tin_gcmem_freeobject(state, sizeof(TinReference), object);
             }
             break;
         default:
@@ -219,21 +231,6 @@ void tin_object_destroy(TinState* state, TinObject* object)
     }
 }
 
-void tin_object_destroylistof(TinState* state, TinObject* objects)
-{
-    TinObject* obj;
-    TinObject* next;
-    obj = objects;
-    while(obj != NULL)
-    {
-        next = obj->next;
-        tin_object_destroy(state, obj);
-        obj = next;
-    }
-    free(state->vm->gcgraystack);
-    state->vm->gcgraycapacity = 0;
-}
-
 static TinValue objfn_instance_class(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
     (void)argc;
@@ -276,7 +273,7 @@ static void fillmap(TinState* state, TinMap* destmap, TinTable* fromtbl, bool in
     TinTabEntry* ent;
     TinValue val;
     (void)includenullkeys;
-    for(i=0; i<(size_t)tin_table_getcount(fromtbl); i++)
+    for(i=0; i<(size_t)tin_table_getcapacity(fromtbl); i++)
     {
         ent = tin_table_getindex(fromtbl, i);
         key = ent->key;
@@ -292,6 +289,7 @@ static TinValue objfn_instance_tomap(TinVM* vm, TinValue instance, size_t argc,
 {
     (void)argc;
     (void)argv;
+    int i;
     TinMap* map;
     TinMap* minst;
     TinMap* mclass;
@@ -307,7 +305,10 @@ static TinValue objfn_instance_tomap(TinVM* vm, TinValue instance, size_t argc,
     map = tin_object_makemap(vm->state);
     {
         minst = tin_object_makemap(vm->state);
-        fillmap(vm->state, minst, &(inst->fields), true);
+        for(i = tin_instance_iterator(inst, -1); i != -1; i = tin_instance_iterator(inst, i))
+        {
+            tin_map_set(vm->state, minst, tin_instance_iteratorkey(inst, i), tin_instance_iteratorvalue(vm->state, inst, i));
+        }
     }
     {
         mclass = tin_object_makemap(vm->state);
@@ -345,14 +346,14 @@ static TinValue objfn_instance_subscript(TinVM* vm, TinValue instance, size_t ar
             tin_vm_raiseexitingerror(vm, "object index must be a string");
         }
 
-        tin_table_set(vm->state, &inst->fields, tin_value_asstring(argv[0]), argv[1]);
+        tin_instance_setfield(vm->state, inst, tin_value_asstring(argv[0]), argv[1]);
         return argv[1];
     }
     if(!tin_value_isstring(argv[0]))
     {
         tin_vm_raiseexitingerror(vm, "object index must be a string");
     }
-    if(tin_table_get(&inst->fields, tin_value_asstring(argv[0]), &value))
+    if(tin_instance_getfield(inst, tin_value_asstring(argv[0]), &value))
     {
         return value;
     }
@@ -381,7 +382,7 @@ static TinValue objfn_instance_iterator(TinVM* vm, TinValue instance, size_t arg
     }
     self = tin_value_asinstance(instance);
     index = tin_value_isnull(argv[0]) ? -1 : tin_value_asnumber(argv[0]);
-    value = util_table_iterator(&self->fields, index);
+    value = tin_instance_iterator(self, index);
     if(value == -1)
     {
         return tin_value_makenull(vm->state);
@@ -393,10 +394,16 @@ static TinValue objfn_instance_iterator(TinVM* vm, TinValue instance, size_t arg
 static TinValue objfn_instance_iteratorvalue(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
 {
     size_t index;
+    TinString* key;
     TinInstance* self;
     index = tin_args_checknumber(vm, argv, argc, 0);
     self = tin_value_asinstance(instance);
-    return util_table_iterator_key(&self->fields, index);
+    key = tin_instance_iteratorkey(self, index);
+    if(key == NULL)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_value_fromobject(key);
 }
 
 static TinValue objfn_instance_dump(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
@@ -52,16 +52,131 @@ char *tin_util_inttostring(char *dest, size_t n, int x)
     return dest;
 }
 
+/*
+* string hashing is wyhash (final version 4, public domain, by Wang Yi): it reads 8 bytes at a time,
+* and mixes them with a 64x64->128 bit multiply. only the low 32 bits are kept.
+*/
+static const uint64_t tin_util_wysecret[4] =
+{
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+static inline void tin_util_wymum(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r;
+    r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha;
+    uint64_t hb;
+    uint64_t la;
+    uint64_t lb;
+    uint64_t rh;
+    uint64_t rm0;
+    uint64_t rm1;
+    uint64_t rl;
+    uint64_t t;
+    uint64_t c;
+    uint64_t lo;
+    ha = *a >> 32;
+    hb = *b >> 32;
+    la = (uint32_t)*a;
+    lb = (uint32_t)*b;
+    rh = ha * hb;
+    rm0 = ha * lb;
+    rm1 = hb * la;
+    rl = la * lb;
+    t = rl + (rm0 << 32);
+    c = (t < rl);
+    lo = t + (rm1 << 32);
+    c += (lo < t);
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t tin_util_wymix(uint64_t a, uint64_t b)
+{
+    tin_util_wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t tin_util_wyread8(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t tin_util_wyread4(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
 uint32_t tin_util_hashstring(const char* key, size_t length)
 {
     size_t i;
-    uint32_t hash = 2166136261u;
-    for(i = 0; i < length; i++)
+    uint64_t a;
+    uint64_t b;
+    uint64_t seed;
+    uint64_t see1;
+    uint64_t see2;
+    const uint8_t* p;
+    p = (const uint8_t*)key;
+    seed = tin_util_wymix(tin_util_wysecret[0], tin_util_wysecret[1]);
+    if(length <= 16)
+    {
+        if(length >= 4)
+        {
+            a = (tin_util_wyread4(p) << 32) | tin_util_wyread4(p + ((length >> 3) << 2));
+            b = (tin_util_wyread4(p + length - 4) << 32) | tin_util_wyread4(p + length - 4 - ((length >> 3) << 2));
+        }
+        else if(length > 0)
+        {
+            a = (((uint64_t)p[0]) << 16) | (((uint64_t)p[length >> 1]) << 8) | p[length - 1];
+            b = 0;
+        }
+        else
+        {
+            a = 0;
+            b = 0;
+        }
+    }
+    else
     {
-        hash ^= key[i];
-        hash *= 16777619;
+        i = length;
+        if(i > 48)
+        {
+            see1 = seed;
+            see2 = seed;
+            do
+            {
+                seed = tin_util_wymix(tin_util_wyread8(p) ^ tin_util_wysecret[1], tin_util_wyread8(p + 8) ^ seed);
+                see1 = tin_util_wymix(tin_util_wyread8(p + 16) ^ tin_util_wysecret[2], tin_util_wyread8(p + 24) ^ see1);
+                see2 = tin_util_wymix(tin_util_wyread8(p + 32) ^ tin_util_wysecret[3], tin_util_wyread8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while(i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while(i > 16)
+        {
+            seed = tin_util_wymix(tin_util_wyread8(p) ^ tin_util_wysecret[1], tin_util_wyread8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = tin_util_wyread8(p + i - 16);
+        b = tin_util_wyread8(p + i - 8);
     }
-    return hash;
+    a ^= tin_util_wysecret[1];
+    b ^= seed;
+    tin_util_wymum(&a, &b);
+    return (uint32_t)tin_util_wymix(a ^ tin_util_wysecret[0] ^ length, b ^ tin_util_wysecret[1]);
 }
 
 int tin_util_decodenumbytes(uint8_t byte)
@@ -288,10 +403,13 @@ void tin_strreg_destroy(TinState* state)
     tin_table_destroy(state, &state->vm->gcstrings);
 }
 
+/* $string must not have the same text as a string that is already registered */
 void tin_strreg_put(TinState* state, TinString* string)
 {
     if(tin_string_getlength(string) > 0)
     {
+        tin_string_gethash(string);
+        string->interned = true;
         tin_state_pushroot(state, (TinObject*)string);
         tin_table_set(state, &state->vm->gcstrings, string, tin_value_makenull(state));
         tin_state_poproot(state);
@@ -390,6 +508,8 @@ TinString* tin_string_makeempty(TinState* state, size_t length, bool reuse)
     string = (TinString*)tin_object_allocobject(state, sizeof(TinString), TINTYPE_STRING, false);
     string->data = NULL;
     string->hash = 0;
+    string->hashed = false;
+    string->interned = false;
     if(!reuse)
     {
         //fprintf(stderr, "tin_string_makeempty: length=%d\n", length);
@@ -427,6 +547,7 @@ TinString* tin_string_makelen(TinState* state, char* chars, size_t length, uint3
         string->data = sds_appendlen(string->data, chars, length);
     }
     string->hash = hash;
+    string->hashed = true;
     if(!wassds)
     {
         tin_gcmem_free(state, sizeof(char), chars);
@@ -435,12 +556,64 @@ TinString* tin_string_makelen(TinState* state, char* chars, size_t length, uint3
     return string;
 }
 
+/* like tin_string_take, but neither hashes $chars nor looks them up in the string registry */
+TinString* tin_string_takeuninterned(TinState* state, char* chars, size_t length, bool wassds)
+{
+    TinString* string;
+    string = tin_string_makeempty(state, length, wassds);
+    if(wassds)
+    {
+        string->data = chars;
+    }
+    else
+    {
+        string->data = sds_appendlen(string->data, chars, length);
+        tin_gcmem_free(state, sizeof(char), chars);
+    }
+    return string;
+}
+
+TinString* tin_string_copyuninterned(TinState* state, const char* chars, size_t length)
+{
+    return tin_string_takeuninterned(state, sds_makelength(chars, length), length, true);
+}
+
+/*
+* the interned string with the text of $string: $string itself if it is interned already, or if no string with
+* its text is registered yet (then it is registered now). only the empty string is returned as it is.
+*/
+TinString* tin_string_intern(TinState* state, TinString* string)
+{
+    size_t length;
+    TinString* interned;
+    if(string->interned)
+    {
+        return string;
+    }
+    length = tin_string_getlength(string);
+    if(length == 0)
+    {
+        return string;
+    }
+    interned = tin_strreg_find(state, string->data, length, tin_string_gethash(string));
+    if(interned != NULL)
+    {
+        return interned;
+    }
+    tin_strreg_put(state, string);
+    return string;
+}
+
 /* todo: track if $chars is a sds instance - additional argument $fromsds? */
 TinString* tin_string_take(TinState* state, char* chars, size_t length, bool wassds)
 {
     bool reuse;
     uint32_t hash;
     reuse = false;
+    if(length > TIN_STRING_MAXINTERN)
+    {
+        return tin_string_takeuninterned(state, chars, length, wassds);
+    }
     hash = tin_util_hashstring(chars, length);
     TinString* interned;
     interned = tin_strreg_find(state, chars, length, hash);
@@ -463,6 +636,10 @@ TinString* tin_string_copy(TinState* state, const char* chars, size_t length)
     char* heapchars;
     TinString* interned;
     interned = NULL;
+    if(length > TIN_STRING_MAXINTERN)
+    {
+        return tin_string_copyuninterned(state, chars, length);
+    }
     hash = tin_util_hashstring(chars, length);
     interned = tin_strreg_find(state, chars, length, hash);
     if(interned != NULL)
@@ -533,28 +710,32 @@ void tin_string_appendchar(TinString* ls, char ch)
     ls->data = sds_appendlen(ls->data, (const char*)&ch, 1);
 }
 
-TinValue tin_string_numbertostring(TinState* state, double value)
+/* writes the text of a number the way tin_string_numbertostring does to $buffer (which must hold 24 bytes), and returns its length */
+size_t tin_util_numbertochars(char* buffer, double value)
 {
     if(isnan(value))
     {
-        return tin_value_makestring(state, "nan");
+        strcpy(buffer, "nan");
+        return 3;
     }
-
     if(isinf(value))
     {
         if(value > 0.0)
         {
-            return tin_value_makestring(state, "infinity");
-        }
-        else
-        {
-            return tin_value_makestring(state, "-infinity");
+            strcpy(buffer, "infinity");
+            return 8;
         }
+        strcpy(buffer, "-infinity");
+        return 9;
     }
+    return sprintf(buffer, "%.14g", value);
+}
 
+TinValue tin_string_numbertostring(TinState* state, double value)
+{
+    size_t length;
     char buffer[24];
-    int length = sprintf(buffer, "%.14g", value);
-
+    length = tin_util_numbertochars(buffer, value);
     return tin_value_fromobject(tin_string_copy(state, buffer, length));
 }
 
@@ -645,20 +826,37 @@ TinValue tin_string_format(TinState* state, const char* format, ...)
         }
     }
     va_end(arglist);
-    result->hash = tin_util_hashstring(result->data, tin_string_getlength(result));
-    tin_strreg_put(state, result);
     state->gcallow = wasallowed;
     return tin_value_fromobject(result);
 }
 
 bool tin_string_equal(TinState* state, TinString* a, TinString* b)
 {
+    size_t length;
     (void)state;
     if((a == NULL) || (b == NULL))
     {
         return false;
     }
-    return (sds_compare(a->data, b->data) == 0);
+    if(a == b)
+    {
+        return true;
+    }
+    /* two different interned strings never have the same text */
+    if(a->interned && b->interned)
+    {
+        return false;
+    }
+    length = tin_string_getlength(a);
+    if(length != tin_string_getlength(b))
+    {
+        return false;
+    }
+    if(a->hashed && b->hashed && (a->hash != b->hash))
+    {
+        return false;
+    }
+    return (memcmp(a->data, b->data, length) == 0);
 }
 
 TinValue util_invalid_constructor(TinVM* vm, TinValue instance, size_t argc, TinValue* argv);
@@ -678,6 +876,7 @@ static TinValue objfn_string_plus(TinVM* vm, TinValue instance, size_t argc, Tin
 {
     TinString* selfstr;
     TinString* result;
+    TinString* interned;
     TinValue value;
     size_t selflen;
     size_t otherlen;
@@ -698,6 +897,19 @@ static TinValue objfn_string_plus(TinVM* vm, TinValue instance, size_t argc, Tin
     result = tin_string_makeempty(vm->state, selflen + otherlen, false);
     tin_string_appendobj(result, selfstr);
     tin_string_appendobj(result, strval);
+    /*
+    * short results are interned right away like any other short string, since they are likely to end up
+    * as table keys. long ones are left to be hashed when (and if) they are used as one.
+    */
+    if(selflen + otherlen > TIN_STRING_MAXINTERN)
+    {
+        return tin_value_fromobject(result);
+    }
+    interned = tin_strreg_find(vm->state, result->data, selflen + otherlen, tin_string_gethash(result));
+    if(interned != NULL)
+    {
+        return tin_value_fromobject(interned);
+    }
     tin_strreg_put(vm->state, result);
     return tin_value_fromobject(result);
 }
@@ -764,15 +976,7 @@ static TinValue objfn_string_compare(TinVM* vm, TinValue instance, size_t argc,
     if(tin_value_isstring(argv[0]))
     {
         other = tin_value_asstring(argv[0]);
-        if(tin_string_getlength(self) == tin_string_getlength(other))
-        {
-            //fprintf(stderr, "string: same length(self=\"%s\" other=\"%s\")... strncmp=%d\n", self->data, other->data, strncmp(self->data, other->data, self->length));
-            if(memcmp(self->data, other->data, tin_string_getlength(self)) == 0)
-            {
-                return tin_value_makebool(vm->state, true);
-            }
-        }
-        return tin_value_makebool(vm->state, false);
+        return tin_value_makebool(vm->state, tin_string_equal(vm->state, self, other));
     }
     else if(tin_value_isnull(argv[0]))
     {
@@ -1278,6 +1482,154 @@ static TinValue objfn_string_split(TinVM* vm, TinValue instance, size_t argc, Ti
     return tin_value_fromobject(res);
 }
 
+/*
+ * StringBuilder
+ */
+TinStringBuilder* tin_object_makestringbuilder(TinState* state, size_t capacity)
+{
+    TinStringBuilder* sb;
+    sb = (TinStringBuilder*)tin_object_allocobject(state, sizeof(TinStringBuilder), TINTYPE_STRINGBUILDER, false);
+    sb->data = sds_makeempty();
+    if(capacity > 0)
+    {
+        sb->data = sds_allocroomfor(sb->data, capacity);
+    }
+    return sb;
+}
+
+void tin_stringbuilder_destroy(TinState* state, TinStringBuilder* sb)
+{
+    sds_destroy(sb->data);
+    tin_gcmem_freeobject(state, sizeof(TinStringBuilder), sb);
+}
+
+/*
+* sds only doubles its buffer up to SDS_MAX_PREALLOC, and grows it linearly after that.
+* asking for at least as much room as is already used keeps the growth geometric at any size.
+*/
+void tin_stringbuilder_reserve(TinStringBuilder* sb, size_t length)
+{
+    size_t used;
+    if(sds_getcapacity(sb->data) < length)
+    {
+        used = sds_getlength(sb->data);
+        sb->data = sds_allocroomfor(sb->data, (length > used) ? length : used);
+    }
+}
+
+void tin_stringbuilder_appendlen(TinStringBuilder* sb, const char* chars, size_t length)
+{
+    if(length == 0)
+    {
+        return;
+    }
+    tin_stringbuilder_reserve(sb, length);
+    sb->data = sds_appendlen(sb->data, chars, length);
+}
+
+/* appends the text of $value. strings, numbers and other builders are copied as they are, without making a TinString */
+void tin_stringbuilder_appendvalue(TinState* state, TinStringBuilder* sb, TinValue value)
+{
+    size_t length;
+    char buffer[24];
+    TinString* string;
+    if(tin_value_isstring(value))
+    {
+        string = tin_value_asstring(value);
+        tin_stringbuilder_appendlen(sb, string->data, tin_string_getlength(string));
+    }
+    else if(tin_value_isnumber(value))
+    {
+        length = tin_util_numbertochars(buffer, tin_value_asnumber(value));
+        tin_stringbuilder_appendlen(sb, buffer, length);
+    }
+    else if(tin_value_isstringbuilder(value))
+    {
+        /* $value may be $sb itself, whose buffer must not move while it is being copied */
+        length = sds_getlength(tin_value_asstringbuilder(value)->data);
+        tin_stringbuilder_reserve(sb, length);
+        tin_stringbuilder_appendlen(sb, tin_value_asstringbuilder(value)->data, length);
+    }
+    else
+    {
+        string = tin_value_tostring(state, value);
+        tin_stringbuilder_appendlen(sb, string->data, tin_string_getlength(string));
+    }
+}
+
+/* new StringBuilder(), new StringBuilder(initial text), or new StringBuilder(capacity) */
+static TinValue objfn_stringbuilder_constructor(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinStringBuilder* sb;
+    (void)instance;
+    if(argc > 0 && tin_value_isnumber(argv[0]))
+    {
+        return tin_value_fromobject(tin_object_makestringbuilder(vm->state, fmax(0, tin_value_asnumber(argv[0]))));
+    }
+    sb = tin_object_makestringbuilder(vm->state, 0);
+    if(argc > 0)
+    {
+        tin_state_pushroot(vm->state, (TinObject*)sb);
+        tin_stringbuilder_appendvalue(vm->state, sb, argv[0]);
+        tin_state_poproot(vm->state);
+    }
+    return tin_value_fromobject(sb);
+}
+
+static TinValue objfn_stringbuilder_append(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinStringBuilder* sb;
+    sb = tin_value_asstringbuilder(instance);
+    for(i = 0; i < argc; i++)
+    {
+        tin_stringbuilder_appendvalue(vm->state, sb, argv[i]);
+    }
+    return instance;
+}
+
+static TinValue objfn_stringbuilder_appendline(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    objfn_stringbuilder_append(vm, instance, argc, argv);
+    tin_stringbuilder_appendlen(tin_value_asstringbuilder(instance), "\n", 1);
+    return instance;
+}
+
+/* builder + value appends in place, so that `sb += value` does not copy what is already there */
+static TinValue objfn_stringbuilder_plus(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    if(!tin_args_ensure(vm->state, argc, 1))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    tin_stringbuilder_appendvalue(vm->state, tin_value_asstringbuilder(instance), argv[0]);
+    return instance;
+}
+
+static TinValue objfn_stringbuilder_tostring(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinStringBuilder* sb;
+    (void)argc;
+    (void)argv;
+    sb = tin_value_asstringbuilder(instance);
+    return tin_value_fromobject(tin_string_copyuninterned(vm->state, sb->data, sds_getlength(sb->data)));
+}
+
+static TinValue objfn_stringbuilder_clear(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)vm;
+    (void)argc;
+    (void)argv;
+    sds_clear(tin_value_asstringbuilder(instance)->data);
+    return instance;
+}
+
+static TinValue objfn_stringbuilder_length(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)argc;
+    (void)argv;
+    return tin_value_makefixednumber(vm->state, sds_getlength(tin_value_asstringbuilder(instance)->data));
+}
 
 void tin_open_string_library(TinState* state)
 {
@@ -1334,5 +1686,20 @@ void tin_open_string_library(TinState* state)
         }
         tin_state_setglobal(state, klass->name, tin_value_fromobject(klass));
     }
+    {
+        TinClass* klass;
+        klass = tin_object_makeclassname(state, "StringBuilder");
+        {
+            tin_class_bindconstructor(state, klass, objfn_stringbuilder_constructor);
+            tin_class_bindmethod(state, klass, "append", objfn_stringbuilder_append);
+            tin_class_bindmethod(state, klass, "appendLine", objfn_stringbuilder_appendline);
+            tin_class_bindmethod(state, klass, "+", objfn_stringbuilder_plus);
+            tin_class_bindmethod(state, klass, "toString", objfn_stringbuilder_tostring);
+            tin_class_bindmethod(state, klass, "clear", objfn_stringbuilder_clear);
+            tin_class_bindgetset(state, klass, "length", objfn_stringbuilder_length, NULL, false);
+            state->primstringbuilderclass = klass;
+        }
+        tin_state_setglobal(state, klass->name, tin_value_fromobject(klass));
+    }
 }
 
@@ -0,0 +1,833 @@
+#include "priv.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define TIN_TYPED_USESSE2
+#endif
+
+#define TIN_TYPED_GROWCAPACITY(cap) \
+    (((cap) < 8) ? (8) : ((cap) * 2))
+
+static const char* tin_typedarray_classname(TinTypedArray* ta)
+{
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return "Int64Array";
+    }
+    return "Float64Array";
+}
+
+void tin_typedarray_ensurecapacity(TinState* state, TinTypedArray* ta, size_t capacity)
+{
+    size_t newcap;
+    if(capacity <= ta->capacity)
+    {
+        return;
+    }
+    newcap = TIN_TYPED_GROWCAPACITY(ta->capacity);
+    if(newcap < capacity)
+    {
+        newcap = capacity;
+    }
+    /* both element types are 8 bytes wide */
+    ta->data.raw = tin_gcmem_memrealloc(state, ta->data.raw, ta->capacity * sizeof(double), newcap * sizeof(double));
+    ta->capacity = newcap;
+}
+
+/* grows (or shrinks) to count elements, new elements are zero */
+void tin_typedarray_resize(TinState* state, TinTypedArray* ta, size_t count)
+{
+    tin_typedarray_ensurecapacity(state, ta, count);
+    if(count > ta->count)
+    {
+        memset(ta->data.f64 + ta->count, 0, (count - ta->count) * sizeof(double));
+    }
+    ta->count = count;
+}
+
+TinTypedArray* tin_object_maketypedarray(TinState* state, TinTypedKind kind, size_t count)
+{
+    TinTypedArray* ta;
+    ta = (TinTypedArray*)tin_object_allocobject(state, sizeof(TinTypedArray), TINTYPE_TYPEDARRAY, false);
+    ta->kind = kind;
+    ta->count = 0;
+    ta->capacity = 0;
+    ta->data.raw = NULL;
+    if(count > 0)
+    {
+        tin_state_pushroot(state, (TinObject*)ta);
+        tin_typedarray_resize(state, ta, count);
+        tin_state_poproot(state);
+    }
+    return ta;
+}
+
+void tin_typedarray_destroy(TinState* state, TinTypedArray* ta)
+{
+    tin_gcmem_memrealloc(state, ta->data.raw, ta->capacity * sizeof(double), 0);
+    tin_gcmem_freeobject(state, sizeof(TinTypedArray), ta);
+}
+
+TinValue tin_typedarray_get(TinState* state, TinTypedArray* ta, size_t index)
+{
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return tin_value_makefixednumber(state, ta->data.i64[index]);
+    }
+    return tin_value_makefloatnumber(state, ta->data.f64[index]);
+}
+
+void tin_typedarray_set(TinTypedArray* ta, size_t index, TinValue value)
+{
+    if(ta->kind == TINTYPED_INT64)
+    {
+        ta->data.i64[index] = tin_value_asfixednumber(value);
+    }
+    else
+    {
+        ta->data.f64[index] = tin_value_asfloatnumber(value);
+    }
+}
+
+/*
+* bulk kernels. with SSE2 (always there on x86-64) the float kernels, and the integer kernels that SSE2 has
+* instructions for, work on two elements per instruction, with two accumulators for the reductions.
+* sums are therefore not added up strictly left to right. the remaining kernels, and the tails, are plain loops.
+* integer arithmetic wraps around, like the SSE2 instructions do.
+*/
+static double tin_typed_sumf64(const double* p, size_t n)
+{
+    size_t i;
+    double total;
+    i = 0;
+    total = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        double lanes[2];
+        __m128d acc0;
+        __m128d acc1;
+        acc0 = _mm_setzero_pd();
+        acc1 = _mm_setzero_pd();
+        for(; i + 4 <= n; i += 4)
+        {
+            acc0 = _mm_add_pd(acc0, _mm_loadu_pd(p + i));
+            acc1 = _mm_add_pd(acc1, _mm_loadu_pd(p + i + 2));
+        }
+        _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+        total = lanes[0] + lanes[1];
+    }
+#endif
+    for(; i < n; i++)
+    {
+        total += p[i];
+    }
+    return total;
+}
+
+static int64_t tin_typed_sumi64(const int64_t* p, size_t n)
+{
+    size_t i;
+    uint64_t total;
+    i = 0;
+    total = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        int64_t lanes[2];
+        __m128i acc0;
+        __m128i acc1;
+        acc0 = _mm_setzero_si128();
+        acc1 = _mm_setzero_si128();
+        for(; i + 4 <= n; i += 4)
+        {
+            acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((const __m128i*)(p + i)));
+            acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((const __m128i*)(p + i + 2)));
+        }
+        _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(acc0, acc1));
+        total = (uint64_t)lanes[0] + (uint64_t)lanes[1];
+    }
+#endif
+    for(; i < n; i++)
+    {
+        total += (uint64_t)p[i];
+    }
+    return (int64_t)total;
+}
+
+static double tin_typed_dotf64(const double* a, const double* b, size_t n)
+{
+    size_t i;
+    double total;
+    i = 0;
+    total = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        double lanes[2];
+        __m128d acc0;
+        __m128d acc1;
+        acc0 = _mm_setzero_pd();
+        acc1 = _mm_setzero_pd();
+        for(; i + 4 <= n; i += 4)
+        {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+        total = lanes[0] + lanes[1];
+    }
+#endif
+    for(; i < n; i++)
+    {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+/* SSE2 has no 64-bit multiply */
+static int64_t tin_typed_doti64(const int64_t* a, const int64_t* b, size_t n)
+{
+    size_t i;
+    uint64_t total;
+    total = 0;
+    for(i = 0; i < n; i++)
+    {
+        total += (uint64_t)a[i] * (uint64_t)b[i];
+    }
+    return (int64_t)total;
+}
+
+static void tin_typed_scalef64(double* p, size_t n, double k)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        __m128d vk;
+        vk = _mm_set1_pd(k);
+        for(; i + 2 <= n; i += 2)
+        {
+            _mm_storeu_pd(p + i, _mm_mul_pd(_mm_loadu_pd(p + i), vk));
+        }
+    }
+#endif
+    for(; i < n; i++)
+    {
+        p[i] *= k;
+    }
+}
+
+static void tin_typed_scalei64(int64_t* p, size_t n, int64_t k)
+{
+    size_t i;
+    for(i = 0; i < n; i++)
+    {
+        p[i] = (int64_t)((uint64_t)p[i] * (uint64_t)k);
+    }
+}
+
+static void tin_typed_addf64(double* dest, const double* src, size_t n)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    for(; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_pd(dest + i, _mm_add_pd(_mm_loadu_pd(dest + i), _mm_loadu_pd(src + i)));
+    }
+#endif
+    for(; i < n; i++)
+    {
+        dest[i] += src[i];
+    }
+}
+
+static void tin_typed_addi64(int64_t* dest, const int64_t* src, size_t n)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    for(; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi64(_mm_loadu_si128((const __m128i*)(dest + i)), _mm_loadu_si128((const __m128i*)(src + i))));
+    }
+#endif
+    for(; i < n; i++)
+    {
+        dest[i] = (int64_t)((uint64_t)dest[i] + (uint64_t)src[i]);
+    }
+}
+
+static void tin_typed_addscalarf64(double* p, size_t n, double k)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        __m128d vk;
+        vk = _mm_set1_pd(k);
+        for(; i + 2 <= n; i += 2)
+        {
+            _mm_storeu_pd(p + i, _mm_add_pd(_mm_loadu_pd(p + i), vk));
+        }
+    }
+#endif
+    for(; i < n; i++)
+    {
+        p[i] += k;
+    }
+}
+
+static void tin_typed_addscalari64(int64_t* p, size_t n, int64_t k)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        __m128i vk;
+        vk = _mm_set1_epi64x(k);
+        for(; i + 2 <= n; i += 2)
+        {
+            _mm_storeu_si128((__m128i*)(p + i), _mm_add_epi64(_mm_loadu_si128((const __m128i*)(p + i)), vk));
+        }
+    }
+#endif
+    for(; i < n; i++)
+    {
+        p[i] = (int64_t)((uint64_t)p[i] + (uint64_t)k);
+    }
+}
+
+/* n must not be 0. with NaNs in the array, the result is one of the elements, but which one is not specified. */
+static double tin_typed_minmaxf64(const double* p, size_t n, bool wantmax)
+{
+    size_t i;
+    double best;
+    i = 0;
+    best = p[0];
+#if defined(TIN_TYPED_USESSE2)
+    if(n >= 4)
+    {
+        double lanes[2];
+        __m128d acc0;
+        __m128d acc1;
+        acc0 = _mm_loadu_pd(p);
+        acc1 = _mm_loadu_pd(p + 2);
+        for(i = 4; i + 4 <= n; i += 4)
+        {
+            if(wantmax)
+            {
+                acc0 = _mm_max_pd(acc0, _mm_loadu_pd(p + i));
+                acc1 = _mm_max_pd(acc1, _mm_loadu_pd(p + i + 2));
+            }
+            else
+            {
+                acc0 = _mm_min_pd(acc0, _mm_loadu_pd(p + i));
+                acc1 = _mm_min_pd(acc1, _mm_loadu_pd(p + i + 2));
+            }
+        }
+        _mm_storeu_pd(lanes, wantmax ? _mm_max_pd(acc0, acc1) : _mm_min_pd(acc0, acc1));
+        best = (wantmax ? (lanes[1] > lanes[0]) : (lanes[1] < lanes[0])) ? lanes[1] : lanes[0];
+    }
+#endif
+    for(; i < n; i++)
+    {
+        if(wantmax ? (p[i] > best) : (p[i] < best))
+        {
+            best = p[i];
+        }
+    }
+    return best;
+}
+
+/* n must not be 0 */
+static int64_t tin_typed_minmaxi64(const int64_t* p, size_t n, bool wantmax)
+{
+    size_t i;
+    int64_t best;
+    best = p[0];
+    for(i = 1; i < n; i++)
+    {
+        if(wantmax ? (p[i] > best) : (p[i] < best))
+        {
+            best = p[i];
+        }
+    }
+    return best;
+}
+
+static void tin_typed_fillf64(double* p, size_t n, double v)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        __m128d vv;
+        vv = _mm_set1_pd(v);
+        for(; i + 2 <= n; i += 2)
+        {
+            _mm_storeu_pd(p + i, vv);
+        }
+    }
+#endif
+    for(; i < n; i++)
+    {
+        p[i] = v;
+    }
+}
+
+static void tin_typed_filli64(int64_t* p, size_t n, int64_t v)
+{
+    size_t i;
+    i = 0;
+#if defined(TIN_TYPED_USESSE2)
+    {
+        __m128i vv;
+        vv = _mm_set1_epi64x(v);
+        for(; i + 2 <= n; i += 2)
+        {
+            _mm_storeu_si128((__m128i*)(p + i), vv);
+        }
+    }
+#endif
+    for(; i < n; i++)
+    {
+        p[i] = v;
+    }
+}
+
+/* copies the numbers of an Array or a typed array into ta, converting them to its element type */
+static bool tin_typedarray_fillfrom(TinVM* vm, TinTypedArray* ta, TinValue from)
+{
+    size_t i;
+    TinValue value;
+    TinValList* vl;
+    TinTypedArray* other;
+    if(tin_value_istypedarray(from))
+    {
+        other = tin_value_astypedarray(from);
+        tin_typedarray_resize(vm->state, ta, other->count);
+        if(other->kind == ta->kind)
+        {
+            memcpy(ta->data.raw, other->data.raw, other->count * sizeof(double));
+        }
+        else
+        {
+            for(i = 0; i < other->count; i++)
+            {
+                tin_typedarray_set(ta, i, tin_typedarray_get(vm->state, other, i));
+            }
+        }
+        return true;
+    }
+    vl = &tin_value_asarray(from)->list;
+    tin_typedarray_resize(vm->state, ta, tin_vallist_count(vl));
+    for(i = 0; i < tin_vallist_count(vl); i++)
+    {
+        value = tin_vallist_get(vl, i);
+        if(!tin_value_isnumber(value))
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s: element %d is a %s, not a number",
+                tin_typedarray_classname(ta), (int)i, tin_tostring_typename(value));
+            return false;
+        }
+        tin_typedarray_set(ta, i, value);
+    }
+    return true;
+}
+
+/*
+* new Float64Array() / new Int64Array(): an empty array.
+* (length): that many zeros. (array): a copy of an Array of numbers, or of another typed array.
+*/
+static TinValue tin_typedarray_construct(TinVM* vm, TinTypedKind kind, size_t argc, TinValue* argv)
+{
+    double length;
+    TinTypedArray* ta;
+    ta = tin_object_maketypedarray(vm->state, kind, 0);
+    if(argc == 0)
+    {
+        return tin_value_fromobject(ta);
+    }
+    if(tin_value_isnumber(argv[0]))
+    {
+        length = tin_value_asnumber(argv[0]);
+        if(length < 0)
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s: length must not be negative", tin_typedarray_classname(ta));
+            return tin_value_makenull(vm->state);
+        }
+        tin_state_pushroot(vm->state, (TinObject*)ta);
+        tin_typedarray_resize(vm->state, ta, (size_t)length);
+        tin_state_poproot(vm->state);
+        return tin_value_fromobject(ta);
+    }
+    if(tin_value_isarray(argv[0]) || tin_value_istypedarray(argv[0]))
+    {
+        tin_state_pushroot(vm->state, (TinObject*)ta);
+        if(!tin_typedarray_fillfrom(vm, ta, argv[0]))
+        {
+            tin_state_poproot(vm->state);
+            return tin_value_makenull(vm->state);
+        }
+        tin_state_poproot(vm->state);
+        return tin_value_fromobject(ta);
+    }
+    tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s: expected a length or an array", tin_typedarray_classname(ta));
+    return tin_value_makenull(vm->state);
+}
+
+static TinValue objfn_float64array_constructor(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)instance;
+    return tin_typedarray_construct(vm, TINTYPED_FLOAT64, argc, argv);
+}
+
+static TinValue objfn_int64array_constructor(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)instance;
+    return tin_typedarray_construct(vm, TINTYPED_INT64, argc, argv);
+}
+
+/* same as Array: negative indices count from the end, reading past the end gives null, writing past it grows the array */
+static TinValue objfn_typedarray_subscript(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    int index;
+    TinTypedArray* ta;
+    ta = tin_value_astypedarray(instance);
+    if(!tin_value_isnumber(argv[0]))
+    {
+        tin_vm_raiseexitingerror(vm, "%s index must be a number", tin_typedarray_classname(ta));
+        return tin_value_makenull(vm->state);
+    }
+    index = tin_value_asnumber(argv[0]);
+    if(index < 0)
+    {
+        index = fmax(0, (int)ta->count + index);
+    }
+    if(argc == 2)
+    {
+        if(!tin_value_isnumber(argv[1]))
+        {
+            tin_vm_raiseexitingerror(vm, "%s can only hold numbers, not a %s", tin_typedarray_classname(ta), tin_tostring_typename(argv[1]));
+            return tin_value_makenull(vm->state);
+        }
+        if((size_t)index >= ta->count)
+        {
+            tin_typedarray_resize(vm->state, ta, index + 1);
+        }
+        tin_typedarray_set(ta, index, argv[1]);
+        return argv[1];
+    }
+    if((size_t)index >= ta->count)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_typedarray_get(vm->state, ta, index);
+}
+
+static TinValue objfn_typedarray_length(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)argc;
+    (void)argv;
+    return tin_value_makefixednumber(vm->state, tin_value_astypedarray(instance)->count);
+}
+
+static TinValue objfn_typedarray_push(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinTypedArray* ta;
+    ta = tin_value_astypedarray(instance);
+    for(i = 0; i < argc; i++)
+    {
+        if(!tin_value_isnumber(argv[i]))
+        {
+            tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s can only hold numbers, not a %s", tin_typedarray_classname(ta), tin_tostring_typename(argv[i]));
+            return tin_value_makenull(vm->state);
+        }
+        tin_typedarray_ensurecapacity(vm->state, ta, ta->count + 1);
+        ta->count++;
+        tin_typedarray_set(ta, ta->count - 1, argv[i]);
+    }
+    return instance;
+}
+
+static TinValue objfn_typedarray_pop(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    (void)argc;
+    (void)argv;
+    ta = tin_value_astypedarray(instance);
+    if(ta->count == 0)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    ta->count--;
+    return tin_typedarray_get(vm->state, ta, ta->count);
+}
+
+static TinValue objfn_typedarray_iterator(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    int number;
+    TinTypedArray* ta;
+    if(!tin_args_ensure(vm->state, argc, 1))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    ta = tin_value_astypedarray(instance);
+    number = 0;
+    if(tin_value_isnumber(argv[0]))
+    {
+        number = tin_value_asnumber(argv[0]);
+        if(number >= (int)ta->count - 1)
+        {
+            return tin_value_makenull(vm->state);
+        }
+        number++;
+    }
+    if(ta->count == 0)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_value_makefixednumber(vm->state, number);
+}
+
+static TinValue objfn_typedarray_iteratorvalue(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t index;
+    TinTypedArray* ta;
+    index = tin_args_checknumber(vm, argv, argc, 0);
+    ta = tin_value_astypedarray(instance);
+    if(ta->count <= index)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return tin_typedarray_get(vm->state, ta, index);
+}
+
+static TinValue objfn_typedarray_tostring(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinWriter wr;
+    (void)argc;
+    (void)argv;
+    tin_writer_init_string(vm->state, &wr);
+    tin_towriter_typedarray(vm->state, &wr, tin_value_astypedarray(instance));
+    return tin_value_fromobject(tin_writer_get_string(&wr));
+}
+
+static TinValue objfn_typedarray_toarray(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    size_t i;
+    TinArray* array;
+    TinTypedArray* ta;
+    (void)argc;
+    (void)argv;
+    ta = tin_value_astypedarray(instance);
+    array = tin_object_makearray(vm->state);
+    tin_state_pushroot(vm->state, (TinObject*)array);
+    tin_vallist_ensuresize(vm->state, &array->list, ta->count);
+    for(i = 0; i < ta->count; i++)
+    {
+        tin_vallist_set(vm->state, &array->list, i, tin_typedarray_get(vm->state, ta, i));
+    }
+    tin_state_poproot(vm->state);
+    return tin_value_fromobject(array);
+}
+
+static TinValue objfn_typedarray_clone(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    TinTypedArray* copy;
+    (void)argc;
+    (void)argv;
+    ta = tin_value_astypedarray(instance);
+    copy = tin_object_maketypedarray(vm->state, ta->kind, ta->count);
+    if(ta->count > 0)
+    {
+        memcpy(copy->data.raw, ta->data.raw, ta->count * sizeof(double));
+    }
+    return tin_value_fromobject(copy);
+}
+
+static TinValue objfn_typedarray_sum(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    (void)argc;
+    (void)argv;
+    ta = tin_value_astypedarray(instance);
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return tin_value_makefixednumber(vm->state, tin_typed_sumi64(ta->data.i64, ta->count));
+    }
+    return tin_value_makefloatnumber(vm->state, tin_typed_sumf64(ta->data.f64, ta->count));
+}
+
+/* the other operand of dot() and add(): a typed array of the same kind and length */
+static TinTypedArray* tin_typedarray_checkother(TinVM* vm, TinTypedArray* ta, const char* name, size_t argc, TinValue* argv)
+{
+    TinTypedArray* other;
+    if(argc == 0 || !tin_value_istypedarray(argv[0]) || tin_value_astypedarray(argv[0])->kind != ta->kind)
+    {
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s.%s expects a %s", tin_typedarray_classname(ta), name, tin_typedarray_classname(ta));
+        return NULL;
+    }
+    other = tin_value_astypedarray(argv[0]);
+    if(other->count != ta->count)
+    {
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s.%s: lengths differ (%d and %d)", tin_typedarray_classname(ta), name, (int)ta->count, (int)other->count);
+        return NULL;
+    }
+    return other;
+}
+
+static TinValue objfn_typedarray_dot(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    TinTypedArray* other;
+    ta = tin_value_astypedarray(instance);
+    other = tin_typedarray_checkother(vm, ta, "dot", argc, argv);
+    if(other == NULL)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return tin_value_makefixednumber(vm->state, tin_typed_doti64(ta->data.i64, other->data.i64, ta->count));
+    }
+    return tin_value_makefloatnumber(vm->state, tin_typed_dotf64(ta->data.f64, other->data.f64, ta->count));
+}
+
+/* multiplies every element by a number, in place. an Int64Array is scaled by the integer part of the factor. */
+static TinValue objfn_typedarray_scale(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    ta = tin_value_astypedarray(instance);
+    if(argc == 0 || !tin_value_isnumber(argv[0]))
+    {
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s.scale expects a number", tin_typedarray_classname(ta));
+        return tin_value_makenull(vm->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        tin_typed_scalei64(ta->data.i64, ta->count, tin_value_asfixednumber(argv[0]));
+    }
+    else
+    {
+        tin_typed_scalef64(ta->data.f64, ta->count, tin_value_asfloatnumber(argv[0]));
+    }
+    return instance;
+}
+
+/* adds a number, or the elements of another array of the same kind and length, in place */
+static TinValue objfn_typedarray_add(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    TinTypedArray* other;
+    ta = tin_value_astypedarray(instance);
+    if(argc > 0 && tin_value_isnumber(argv[0]))
+    {
+        if(ta->kind == TINTYPED_INT64)
+        {
+            tin_typed_addscalari64(ta->data.i64, ta->count, tin_value_asfixednumber(argv[0]));
+        }
+        else
+        {
+            tin_typed_addscalarf64(ta->data.f64, ta->count, tin_value_asfloatnumber(argv[0]));
+        }
+        return instance;
+    }
+    other = tin_typedarray_checkother(vm, ta, "add", argc, argv);
+    if(other == NULL)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        tin_typed_addi64(ta->data.i64, other->data.i64, ta->count);
+    }
+    else
+    {
+        tin_typed_addf64(ta->data.f64, other->data.f64, ta->count);
+    }
+    return instance;
+}
+
+static TinValue tin_typedarray_minmax(TinVM* vm, TinValue instance, bool wantmax)
+{
+    TinTypedArray* ta;
+    ta = tin_value_astypedarray(instance);
+    if(ta->count == 0)
+    {
+        return tin_value_makenull(vm->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return tin_value_makefixednumber(vm->state, tin_typed_minmaxi64(ta->data.i64, ta->count, wantmax));
+    }
+    return tin_value_makefloatnumber(vm->state, tin_typed_minmaxf64(ta->data.f64, ta->count, wantmax));
+}
+
+static TinValue objfn_typedarray_min(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)argc;
+    (void)argv;
+    return tin_typedarray_minmax(vm, instance, false);
+}
+
+static TinValue objfn_typedarray_max(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)argc;
+    (void)argv;
+    return tin_typedarray_minmax(vm, instance, true);
+}
+
+static TinValue objfn_typedarray_fill(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    TinTypedArray* ta;
+    ta = tin_value_astypedarray(instance);
+    if(argc == 0 || !tin_value_isnumber(argv[0]))
+    {
+        tin_state_raiseerror(vm->state, RUNTIME_ERROR, "%s.fill expects a number", tin_typedarray_classname(ta));
+        return tin_value_makenull(vm->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        tin_typed_filli64(ta->data.i64, ta->count, tin_value_asfixednumber(argv[0]));
+    }
+    else
+    {
+        tin_typed_fillf64(ta->data.f64, ta->count, tin_value_asfloatnumber(argv[0]));
+    }
+    return instance;
+}
+
+static TinClass* tin_open_typedarray_class(TinState* state, const char* name, TinNativeMethodFn constructor)
+{
+    TinClass* klass;
+    klass = tin_object_makeclassname(state, name);
+    {
+        tin_class_bindconstructor(state, klass, constructor);
+        tin_class_bindmethod(state, klass, "[]", objfn_typedarray_subscript);
+        tin_class_bindmethod(state, klass, "push", objfn_typedarray_push);
+        tin_class_bindmethod(state, klass, "pop", objfn_typedarray_pop);
+        tin_class_bindmethod(state, klass, "iterator", objfn_typedarray_iterator);
+        tin_class_bindmethod(state, klass, "iteratorValue", objfn_typedarray_iteratorvalue);
+        tin_class_bindmethod(state, klass, "toString", objfn_typedarray_tostring);
+        tin_class_bindmethod(state, klass, "toArray", objfn_typedarray_toarray);
+        tin_class_bindmethod(state, klass, "clone", objfn_typedarray_clone);
+        tin_class_bindmethod(state, klass, "sum", objfn_typedarray_sum);
+        tin_class_bindmethod(state, klass, "dot", objfn_typedarray_dot);
+        tin_class_bindmethod(state, klass, "scale", objfn_typedarray_scale);
+        tin_class_bindmethod(state, klass, "add", objfn_typedarray_add);
+        tin_class_bindmethod(state, klass, "min", objfn_typedarray_min);
+        tin_class_bindmethod(state, klass, "max", objfn_typedarray_max);
+        tin_class_bindmethod(state, klass, "fill", objfn_typedarray_fill);
+        tin_class_bindgetset(state, klass, "length", objfn_typedarray_length, NULL, false);
+    }
+    tin_state_setglobal(state, klass->name, tin_value_fromobject(klass));
+    return klass;
+}
+
+void tin_open_typedarray_library(TinState* state)
+{
+    state->primfloat64arrayclass = tin_open_typedarray_class(state, "Float64Array", objfn_float64array_constructor);
+    state->primint64arrayclass = tin_open_typedarray_class(state, "Int64Array", objfn_int64array_constructor);
+}
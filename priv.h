@@ -39,10 +39,40 @@
 #define UINT8_COUNT UINT8_MAX + 1
 #define UINT16_COUNT UINT16_MAX + 1
 
+/* size of the blocks the AST arena carves its allocations from */
+#define TIN_AST_ARENABLOCKSIZE (64 * 1024)
+/* allocations are rounded up to this, so any node type can live at any offset */
+#define TIN_AST_ARENAALIGN 16
+
 struct TinAstExpression
 {
     TinAstExprType type;
     size_t line;
+    /* 1-based; 0 if unknown */
+    size_t column;
+};
+
+struct TinAstArenaBlock
+{
+    TinAstArenaBlock* next;
+    size_t size;
+    size_t used;
+    uint8_t* data;
+};
+
+/*
+* bump allocator for everything that only lives while one module is compiled; see ccast.c.
+* $bytesused is what was handed out, $bytesreserved what the blocks take up.
+*/
+struct TinAstArena
+{
+    TinAstArenaBlock* head;
+    /* the most recent allocation from $head, which tin_astarena_grow can extend in place */
+    void* last;
+    size_t blockcount;
+    size_t allocations;
+    size_t bytesused;
+    size_t bytesreserved;
 };
 
 struct TinAstPrivate
@@ -64,6 +94,8 @@ struct TinAstEmitter
     TinChunk* chunk;
     TinAstCompiler* compiler;
     size_t lastline;
+    /* the column of the expression being emitted */
+    size_t column;
     size_t loopstart;
     TinAstPrivList privates;
     TinUintList breaks;
@@ -369,6 +401,7 @@ struct TinAstToken
     TinAstTokType type;
     size_t length;
     size_t line;
+    size_t column;
     TinValue value;
 };
 
@@ -431,6 +464,8 @@ struct TinEmulatedFile
 struct TinAstScanner
 {
     size_t line;
+    /* where $line starts, for the columns of tokens */
+    const char* linestart;
     const char* start;
     const char* current;
     const char* filename;
@@ -0,0 +1,359 @@
+
+#include "priv.h"
+
+/*
+* shapes describe which field of an instance lives in which slot.
+* every class has a tree of them, rooted at klass->rootshape (no fields); adding a field to
+* an instance moves it to the child shape for that field, creating the child if needed.
+* instances that got their fields assigned in the same order thus share a shape, and a field
+* read is a slot lookup, which the vm inline caches remember per shape.
+*
+* an instance goes into "dictionary mode" (shape is NULL, fields live in inst->fields)
+* once it would have more than TIN_SHAPE_MAXFIELDS fields, or when its class already has
+* TIN_SHAPE_MAXPERCLASS shapes, which only happens when fields get added in lots of different orders.
+*
+* a field that is set to null stays in its slot, but counts as absent, just like
+* deleting it from the table would.
+*/
+
+static TinShape* tin_shape_make(TinState* state, TinShape* from, TinString* key)
+{
+    size_t i;
+    TinShape* shape;
+    shape = (TinShape*)tin_gcmem_allocate(state, sizeof(TinShape), 1);
+    state->lastshapeid++;
+    shape->id = state->lastshapeid;
+    shape->keys = NULL;
+    shape->fieldcount = 0;
+    shape->children = NULL;
+    shape->childcount = 0;
+    shape->childcap = 0;
+    if(from != NULL)
+    {
+        shape->keys = (TinString**)tin_gcmem_allocate(state, sizeof(TinString*), from->fieldcount + 1);
+        for(i = 0; i < from->fieldcount; i++)
+        {
+            shape->keys[i] = from->keys[i];
+        }
+        shape->keys[from->fieldcount] = key;
+        shape->fieldcount = from->fieldcount + 1;
+    }
+    return shape;
+}
+
+TinShape* tin_shape_getroot(TinState* state, TinClass* klass)
+{
+    if(klass->rootshape == NULL)
+    {
+        klass->rootshape = tin_shape_make(state, NULL, NULL);
+    }
+    return klass->rootshape;
+}
+
+/* returns NULL if the class is out of shapes */
+static TinShape* tin_shape_addfield(TinState* state, TinClass* klass, TinShape* shape, TinString* key)
+{
+    size_t i;
+    size_t oldcap;
+    TinShape* child;
+    for(i = 0; i < shape->childcount; i++)
+    {
+        child = shape->children[i];
+        if(child->keys[child->fieldcount - 1] == key)
+        {
+            return child;
+        }
+    }
+    if(shape->fieldcount >= TIN_SHAPE_MAXFIELDS || klass->shapecount >= TIN_SHAPE_MAXPERCLASS)
+    {
+        return NULL;
+    }
+    child = tin_shape_make(state, shape, key);
+    if(shape->childcount == shape->childcap)
+    {
+        oldcap = shape->childcap;
+        shape->childcap = (oldcap < 4) ? 4 : (oldcap * 2);
+        shape->children = (TinShape**)tin_gcmem_growarray(state, shape->children, sizeof(TinShape*), oldcap, shape->childcap);
+    }
+    shape->children[shape->childcount] = child;
+    shape->childcount++;
+    klass->shapecount++;
+    return child;
+}
+
+int tin_shape_findslot(TinShape* shape, TinString* key)
+{
+    size_t i;
+    for(i = 0; i < shape->fieldcount; i++)
+    {
+        if(shape->keys[i] == key)
+        {
+            return (int)i;
+        }
+    }
+    /* shape keys are interned, a key that isn't may still have the same text as one of them */
+    if(!key->interned)
+    {
+        for(i = 0; i < shape->fieldcount; i++)
+        {
+            if(tin_string_equal(NULL, shape->keys[i], key))
+            {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+void tin_shape_mark(TinVM* vm, TinShape* shape)
+{
+    size_t i;
+    if(shape == NULL)
+    {
+        return;
+    }
+    /* the keys before the last one were added, and are marked, by the parents */
+    if(shape->fieldcount > 0)
+    {
+        tin_gcmem_markobject(vm, (TinObject*)shape->keys[shape->fieldcount - 1]);
+    }
+    for(i = 0; i < shape->childcount; i++)
+    {
+        tin_shape_mark(vm, shape->children[i]);
+    }
+}
+
+void tin_shape_destroy(TinState* state, TinShape* shape)
+{
+    size_t i;
+    if(shape == NULL)
+    {
+        return;
+    }
+    for(i = 0; i < shape->childcount; i++)
+    {
+        tin_shape_destroy(state, shape->children[i]);
+    }
+    tin_gcmem_freearray(state, sizeof(TinShape*), shape->children, shape->childcap);
+    tin_gcmem_freearray(state, sizeof(TinString*), shape->keys, shape->fieldcount);
+    tin_gcmem_free(state, sizeof(TinShape), shape);
+}
+
+static void tin_instance_ensureslots(TinState* state, TinInstance* inst, size_t count)
+{
+    size_t newcap;
+    TinValue* newslots;
+    if(count <= inst->slotcap)
+    {
+        return;
+    }
+    newcap = (inst->slotcap < 4) ? 4 : (inst->slotcap * 2);
+    newslots = (TinValue*)tin_gcmem_allocate(state, sizeof(TinValue), newcap);
+    memcpy(newslots, inst->slots, sizeof(TinValue) * inst->shape->fieldcount);
+    if(inst->slots != inst->inlineslots)
+    {
+        tin_gcmem_freearray(state, sizeof(TinValue), inst->slots, inst->slotcap);
+    }
+    inst->slots = newslots;
+    inst->slotcap = newcap;
+}
+
+static void tin_instance_todictionary(TinState* state, TinInstance* inst)
+{
+    size_t i;
+    TinShape* shape;
+    shape = inst->shape;
+    for(i = 0; i < shape->fieldcount; i++)
+    {
+        if(!tin_value_isnull(inst->slots[i]))
+        {
+            tin_table_set(state, &inst->fields, shape->keys[i], inst->slots[i]);
+        }
+    }
+    inst->shape = NULL;
+    if(inst->slots != inst->inlineslots)
+    {
+        tin_gcmem_freearray(state, sizeof(TinValue), inst->slots, inst->slotcap);
+    }
+    inst->slots = inst->inlineslots;
+    inst->slotcap = inst->inlinecap;
+}
+
+bool tin_instance_getfield(TinInstance* inst, TinString* key, TinValue* dest)
+{
+    int slot;
+    if(inst->shape == NULL)
+    {
+        return tin_table_get(&inst->fields, key, dest);
+    }
+    slot = tin_shape_findslot(inst->shape, key);
+    if(slot == -1 || tin_value_isnull(inst->slots[slot]))
+    {
+        return false;
+    }
+    *dest = inst->slots[slot];
+    return true;
+}
+
+bool tin_instance_getfieldslot(TinInstance* inst, TinString* key, TinValue** dest)
+{
+    int slot;
+    if(inst->shape == NULL)
+    {
+        return tin_table_get_slot(&inst->fields, key, dest);
+    }
+    slot = tin_shape_findslot(inst->shape, key);
+    if(slot == -1 || tin_value_isnull(inst->slots[slot]))
+    {
+        return false;
+    }
+    *dest = &inst->slots[slot];
+    return true;
+}
+
+/* setting a field to null removes it */
+void tin_instance_setfield(TinState* state, TinInstance* inst, TinString* key, TinValue value)
+{
+    int slot;
+    TinShape* next;
+    if(!key->interned)
+    {
+        tin_state_pushvalueroot(state, value);
+        key = tin_string_intern(state, key);
+        tin_state_poproot(state);
+    }
+    if(inst->shape != NULL)
+    {
+        slot = tin_shape_findslot(inst->shape, key);
+        if(slot != -1)
+        {
+            inst->slots[slot] = value;
+            tin_gcmem_writebarrier(state, (TinObject*)inst, value);
+            return;
+        }
+        if(tin_value_isnull(value))
+        {
+            return;
+        }
+        tin_state_pushroot(state, (TinObject*)key);
+        tin_state_pushvalueroot(state, value);
+        next = tin_shape_addfield(state, inst->klass, inst->shape, key);
+        if(next != NULL)
+        {
+            tin_instance_ensureslots(state, inst, next->fieldcount);
+            inst->slots[next->fieldcount - 1] = value;
+            inst->shape = next;
+            tin_gcmem_writebarrier(state, (TinObject*)inst, value);
+            if(inst->klass->instancefields < next->fieldcount)
+            {
+                inst->klass->instancefields = next->fieldcount;
+            }
+            tin_state_poproots(state, 2);
+            return;
+        }
+        tin_instance_todictionary(state, inst);
+        tin_state_poproots(state, 2);
+    }
+    if(tin_value_isnull(value))
+    {
+        tin_table_delete(&inst->fields, key);
+    }
+    else
+    {
+        tin_table_set(state, &inst->fields, key, value);
+    }
+}
+
+size_t tin_instance_fieldcount(TinInstance* inst)
+{
+    size_t i;
+    size_t count;
+    if(inst->shape == NULL)
+    {
+        return tin_table_getcount(&inst->fields);
+    }
+    count = 0;
+    for(i = 0; i < inst->shape->fieldcount; i++)
+    {
+        if(!tin_value_isnull(inst->slots[i]))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* same contract as util_table_iterator: returns the index of the next field after $index, or -1 */
+int tin_instance_iterator(TinInstance* inst, int index)
+{
+    size_t i;
+    if(inst->shape == NULL)
+    {
+        return util_table_iterator(&inst->fields, index);
+    }
+    for(i = (size_t)(index + 1); i < inst->shape->fieldcount; i++)
+    {
+        if(!tin_value_isnull(inst->slots[i]))
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+TinString* tin_instance_iteratorkey(TinInstance* inst, int index)
+{
+    if(inst->shape == NULL)
+    {
+        if(index < 0 || index >= (int)tin_table_getcapacity(&inst->fields))
+        {
+            return NULL;
+        }
+        return tin_table_getindex(&inst->fields, index)->key;
+    }
+    if(index < 0 || index >= (int)inst->shape->fieldcount)
+    {
+        return NULL;
+    }
+    return inst->shape->keys[index];
+}
+
+TinValue tin_instance_iteratorvalue(TinState* state, TinInstance* inst, int index)
+{
+    if(inst->shape == NULL)
+    {
+        if(index < 0 || index >= (int)tin_table_getcapacity(&inst->fields))
+        {
+            return tin_value_makenull(state);
+        }
+        return tin_table_getindex(&inst->fields, index)->value;
+    }
+    if(index < 0 || index >= (int)inst->shape->fieldcount)
+    {
+        return tin_value_makenull(state);
+    }
+    return inst->slots[index];
+}
+
+void tin_instance_markfields(TinVM* vm, TinInstance* inst)
+{
+    size_t i;
+    if(inst->shape == NULL)
+    {
+        tin_gcmem_marktable(vm, &inst->fields);
+        return;
+    }
+    for(i = 0; i < inst->shape->fieldcount; i++)
+    {
+        tin_gcmem_markvalue(vm, inst->slots[i]);
+    }
+}
+
+void tin_instance_destroyfields(TinState* state, TinInstance* inst)
+{
+    if(inst->slots != inst->inlineslots)
+    {
+        tin_gcmem_freearray(state, sizeof(TinValue), inst->slots, inst->slotcap);
+    }
+    tin_table_destroy(state, &inst->fields);
+}
@@ -67,12 +67,14 @@ static void tin_util_default_printf(TinState* state, const char* message)
 
 TinState* tin_make_state()
 {
+    size_t i;
     TinState* state;
     state = (TinState*)malloc(sizeof(TinState));
     {
         state->config.dumpbytecode = false;
         state->config.dumpast = false;
         state->config.runafterdump = true;
+        state->config.cachedir = NULL;
     }
     {
         state->primclassclass = NULL;
@@ -86,10 +88,30 @@ TinState* tin_make_state()
         state->primarrayclass = NULL;
         state->primmapclass = NULL;
         state->primrangeclass = NULL;
+        state->primfloat64arrayclass = NULL;
+        state->primint64arrayclass = NULL;
+        state->primstringbuilderclass = NULL;
+    }
+    for(i = 0; i < TINSYM_TOTAL; i++)
+    {
+        state->symbols[i] = NULL;
     }
     state->gcbytescount = 0;
     state->gcnext = 256 * 1024;
+    state->gcoldbytes = 0;
+    state->gcmajornext = TIN_GC_NURSERY_SIZE;
     state->gcallow = false;
+    state->gcminorcount = 0;
+    state->gcmajorcount = 0;
+    state->gclastpause = 0;
+    state->gcmaxpause = 0;
+    state->gctotalpause = 0;
+    state->gcmarkthreads = TIN_GC_MARKTHREADS;
+    if(state->gcmarkthreads > TIN_GC_MAXMARKTHREADS)
+    {
+        state->gcmarkthreads = TIN_GC_MAXMARKTHREADS;
+    }
+    tin_slab_init(state);
     /* io stuff */
     {
         state->errorfn = tin_util_default_error;
@@ -102,6 +124,10 @@ TinState* tin_make_state()
     state->gcrootcount = 0;
     state->gcrootcapacity = 0;
     state->lastmodule = NULL;
+    state->images = NULL;
+    state->classversion = 0;
+    state->icachehits = 0;
+    state->icachemisses = 0;
     tin_writer_init_file(state, &state->debugwriter, stdout, true);
     state->scanner = (TinAstScanner*)malloc(sizeof(TinAstScanner));
     state->parser = (TinAstParser*)malloc(sizeof(TinAstParser));
@@ -110,8 +136,10 @@ TinState* tin_make_state()
     tin_astemit_init(state, state->emitter);
     state->optimizer = (TinAstOptimizer*)malloc(sizeof(TinAstOptimizer));
     tin_astopt_init(state, state->optimizer);
+    state->astarena = NULL;
     state->vm = (TinVM*)malloc(sizeof(TinVM));
     tin_vm_init(state, state->vm);
+    tin_state_initsymbols(state);
     tin_api_init(state);
     tin_open_core_library(state);
     return state;
@@ -133,12 +161,31 @@ int64_t tin_destroy_state(TinState* state)
     free(state->emitter);
     free(state->optimizer);
     tin_vm_destroy(state->vm);
+    tin_slab_destroy(state);
+    tin_image_destroyall(state);
     free(state->vm);
     amount = state->gcbytescount;
     free(state);
     return amount;
 }
 
+void tin_state_initsymbols(TinState* state)
+{
+    size_t i;
+    static const char* names[TINSYM_TOTAL] =
+    {
+        "+", "-", "*", "**", "%", "/", "#",
+        "&", "|", "^", "<<", ">>",
+        "==", ">", ">=", "<", "<=",
+        "!", "[]",
+        "iterator", "iteratorValue", TIN_VALUE_CTORNAME, "toString",
+    };
+    for(i = 0; i < TINSYM_TOTAL; i++)
+    {
+        state->symbols[i] = tin_string_copyconst(state, names[i]);
+    }
+}
+
 void tin_api_init(TinState* state)
 {
     const char* apiname;
@@ -158,7 +205,7 @@ void tin_api_destroy(TinState* state)
 TinValue tin_state_getglobalvalue(TinState* state, TinString* name)
 {
     TinValue global;
-    if(!tin_table_get(&state->vm->globals->values, name, &global))
+    if(!tin_vm_getglobal(state->vm, name, &global))
     {
         return tin_value_makenull(state);
     }
@@ -183,14 +230,14 @@ void tin_state_setglobal(TinState* state, TinString* name, TinValue value)
     tin_table_set(state, &state->vm->globals->values, name, value);
     tin_state_poproots(state, 2);
     */
-    tin_table_set(state, &state->vm->globals->values, name, value);
+    tin_vm_setglobal(state, name, value);
 
 }
 
 bool tin_state_hasglobal(TinState* state, TinString* name)
 {
     TinValue global;
-    return tin_table_get(&state->vm->globals->values, name, &global);
+    return tin_vm_getglobal(state->vm, name, &global);
 }
 
 void tin_state_defnativefunc(TinState* state, const char* name, TinNativeFunctionFn native)
@@ -206,7 +253,7 @@ void tin_state_defnativeprimitive(TinState* state, const char* name, TinNativePr
 {
     tin_state_pushroot(state, (TinObject*)tin_string_copyconst(state, name));
     tin_state_pushroot(state, (TinObject*)tin_object_makenativeprimitive(state, native, tin_value_asstring(tin_state_peekroot(state, 0))));
-    tin_table_set(state, &state->vm->globals->values, tin_value_asstring(tin_state_peekroot(state, 1)), tin_state_peekroot(state, 0));
+    tin_vm_setglobal(state, tin_value_asstring(tin_state_peekroot(state, 1)), tin_state_peekroot(state, 0));
     tin_state_poproots(state, 2);
 }
 
@@ -215,7 +262,7 @@ TinValue tin_state_getinstancemethod(TinState* state, TinValue callee, TinString
     TinValue mthval;
     TinClass* klass;
     klass = tin_state_getclassfor(state, callee);
-    if((tin_value_isinstance(callee) && tin_table_get(&tin_value_asinstance(callee)->fields, mthname, &mthval)) || tin_table_get(&klass->methods, mthname, &mthval))
+    if((tin_value_isinstance(callee) && tin_instance_getfield(tin_value_asinstance(callee), mthname, &mthval)) || tin_table_get(&klass->methods, mthname, &mthval))
     {
         return mthval;
     }
@@ -316,6 +363,7 @@ static inline TinCallFrame* setup_call(TinState* state, TinFunction* callee, Tin
         tin_vm_raiseerror(vm, "attempt to call a null value");
         return NULL;
     }
+    tin_function_ensureloaded(state, callee);
     if(ignfiber)
     {
         if(fiber == NULL)
@@ -571,6 +619,81 @@ TinInterpretResult tin_state_callvalue(TinState* state, TinValue callee, TinValu
     return tin_state_callmethod(state, callee, callee, argv, argc, ignfiber);
 }
 
+/*
+* prepared calls check the callee, and make room on the fiber for its frame and stack, once.
+* each tin_state_invokeprepared then only pushes the frame and the arguments and runs it, instead of
+* going through tin_state_callvalue; callees that aren't script functions taking exactly $argc arguments
+* still do, though.
+* returns false, with an error raised, if there is no fiber to call on.
+*/
+bool tin_state_preparecall(TinState* state, TinPreparedCall* pc, TinValue callee, uint8_t argc)
+{
+    TinFiber* fiber;
+    TinFunction* function;
+    fiber = state->vm->fiber;
+    pc->state = state;
+    pc->fiber = fiber;
+    pc->callee = callee;
+    pc->argc = argc;
+    pc->function = NULL;
+    pc->closure = NULL;
+    if(tin_state_ensurefiber(state->vm, fiber))
+    {
+        return false;
+    }
+    if(tin_value_isclosure(callee))
+    {
+        function = tin_value_asclosure(callee)->function;
+    }
+    else if(tin_value_isfunction(callee))
+    {
+        function = tin_value_asfunction(callee);
+    }
+    else
+    {
+        return true;
+    }
+    if(function->argcount != argc || function->vararg)
+    {
+        return true;
+    }
+    tin_function_ensureloaded(state, function);
+    pc->function = function;
+    if(tin_value_isclosure(callee))
+    {
+        pc->closure = tin_value_asclosure(callee);
+    }
+    tin_fiber_ensurestack(state, fiber, function->maxslots + (int)(fiber->stacktop - fiber->stackvalues));
+    return true;
+}
+
+/* calls a callee prepared with tin_state_preparecall, with pc->argc arguments from $argv */
+TinInterpretResult tin_state_invokeprepared(TinPreparedCall* pc, TinValue* argv)
+{
+    uint8_t i;
+    TinFiber* fiber;
+    TinCallFrame* frame;
+    if(pc->function == NULL)
+    {
+        return tin_state_callvalue(pc->state, pc->callee, argv, pc->argc, false);
+    }
+    fiber = pc->fiber;
+    /* whatever the callee does, the fiber is back at the same frame count and stack top when it returns */
+    frame = &fiber->framevalues[fiber->framecount++];
+    frame->slots = fiber->stacktop;
+    *fiber->stacktop++ = tin_value_fromobject(pc->function);
+    for(i = 0; i < pc->argc; i++)
+    {
+        *fiber->stacktop++ = argv[i];
+    }
+    frame->ip = pc->function->chunk.code;
+    frame->closure = pc->closure;
+    frame->function = pc->function;
+    frame->ignresult = false;
+    frame->returntonative = true;
+    return execute_call(pc->state, frame);
+}
+
 TinInterpretResult tin_state_findandcallmethod(TinState* state, TinValue callee, TinString* mthname, TinValue* argv, uint8_t argc, bool ignfiber)
 {
     TinClass* klass;
@@ -588,7 +711,7 @@ TinInterpretResult tin_state_findandcallmethod(TinState* state, TinValue callee,
         }
     }
     klass = tin_state_getclassfor(state, callee);
-    if((tin_value_isinstance(callee) && tin_table_get(&tin_value_asinstance(callee)->fields, mthname, &mthval)) || tin_table_get(&klass->methods, mthname, &mthval))
+    if((tin_value_isinstance(callee) && tin_instance_getfield(tin_value_asinstance(callee), mthname, &mthval)) || tin_table_get(&klass->methods, mthname, &mthval))
     {
         return tin_state_callmethod(state, callee, mthval, argv, argc, ignfiber);
     }
@@ -707,6 +830,20 @@ TinClass* tin_state_getclassfor(TinState* state, TinValue value)
                     return state->primrangeclass;
                 }
                 break;
+            case TINTYPE_TYPEDARRAY:
+                {
+                    if(tin_value_astypedarray(value)->kind == TINTYPED_INT64)
+                    {
+                        return state->primint64arrayclass;
+                    }
+                    return state->primfloat64arrayclass;
+                }
+                break;
+            case TINTYPE_STRINGBUILDER:
+                {
+                    return state->primstringbuilderclass;
+                }
+                break;
             case TINTYPE_REFERENCE:
                 {
                     slot = tin_value_asreference(value)->slot;
@@ -735,32 +872,22 @@ TinClass* tin_state_getclassfor(TinState* state, TinValue value)
     return NULL;
 }
 
-static void free_statements(TinState* state, TinAstExprList* statements)
-{
-    size_t i;
-    for(i = 0; i < statements->count; i++)
-    {
-        tin_ast_destroyexpression(state, statements->values[i]);
-    }
-    tin_exprlist_destroy(state, statements);
-}
-
-
 TinModule* tin_state_compilemodule(TinState* state, TinString* module_name, const char* code, size_t len)
 {
     clock_t t;
     clock_t total_t;
     bool allowedgc;
     TinModule* module;
+    TinAstArena arena;
+    TinAstArena* prevarena;
     TinAstExprList statements;
     allowedgc = state->gcallow;
     state->gcallow = false;
     state->haderror = false;
     module = NULL;
-    // This is a lbc format
-    if((code[1] << 8 | code[0]) == TIN_BYTECODE_MAGIC_NUMBER)
+    if(tin_image_isimage(code, len))
     {
-        module = tin_ioutil_readmodule(state, code, len);
+        module = tin_image_load(state, code, len);
     }
     else
     {
@@ -770,10 +897,16 @@ TinModule* tin_state_compilemodule(TinState* state, TinString* module_name, cons
         {
             total_t = t = clock();
         }
+        /* the tree, and everything else only needed until the module is emitted, lives in here */
+        tin_astarena_init(&arena);
+        prevarena = state->astarena;
+        state->astarena = &arena;
         tin_exprlist_init(&statements);
         if(tin_astparser_parsesource(state->parser, module_name->data, code, len, &statements))
         {
-            free_statements(state, &statements);
+            state->astarena = prevarena;
+            tin_astarena_destroy(&arena);
+            state->gcallow = allowedgc;
             return NULL;
         }
         if(state->config.dumpast)
@@ -792,10 +925,20 @@ TinModule* tin_state_compilemodule(TinState* state, TinString* module_name, cons
             t = clock();
         }
         module = tin_astemit_modemit(state->emitter, &statements, module_name);
-        free_statements(state, &statements);
+        state->astarena = prevarena;
+        tin_astarena_destroy(&arena);
+        if(!state->haderror)
+        {
+            tin_astopt_optbytecode(state, module);
+            if(state->config.dumpbytecode)
+            {
+                tin_disassemble_module(state, module, code);
+            }
+        }
         if(measurecompilationtime)
         {
             printf("Emitting:       %gms\n", (double)(clock() - t) / CLOCKS_PER_SEC * 1000);
+            printf("AST arena:      %gkb in %d allocations, %d blocks\n", (double)arena.bytesused / 1024, (int)arena.allocations, (int)arena.blockcount);
             printf("\nTotal:          %gms\n-----------------------\n",
                    (double)(clock() - total_t) / CLOCKS_PER_SEC * 1000 + lastsourcetime);
         }
@@ -822,18 +965,23 @@ TinInterpretResult tin_state_execsource(TinState* state, const char* module_name
 
 TinInterpretResult tin_state_internexecsource(TinState* state, TinString* module_name, const char* code, size_t len)
 {
-    intptr_t istack;
-    intptr_t itop;
-    intptr_t idif;
     TinModule* module;
-    TinFiber* fiber;
-    TinInterpretResult result;
     module = tin_state_compilemodule(state, module_name, code, len);
     if(module == NULL)
     {
         return TIN_MAKESTATUS(TINSTATE_COMPILEERROR, tin_value_makenull(state));
     }
-    
+    return tin_state_runmodule(state, module);
+}
+
+/* runs a module returned by tin_state_compilemodule or tin_image_loadfile */
+TinInterpretResult tin_state_runmodule(TinState* state, TinModule* module)
+{
+    intptr_t istack;
+    intptr_t itop;
+    intptr_t idif;
+    TinFiber* fiber;
+    TinInterpretResult result;
     result = tin_vm_execmodule(state, module);
     fiber = module->mainfiber;
     if(!state->haderror && !fiber->abort && fiber->stacktop != fiber->stackvalues)
@@ -851,6 +999,7 @@ TinInterpretResult tin_state_internexecsource(TinState* state, TinString* module
 
 bool tin_state_compileandsave(TinState* state, char* files[], size_t numfiles, const char* outputfile)
 {
+    bool written;
     size_t i;
     size_t len;
     char* filename;
@@ -887,17 +1036,14 @@ bool tin_state_compileandsave(TinState* state, char* files[], size_t numfiles, c
         tin_state_raiseerror(state, COMPILE_ERROR, "failed to open file '%s' for writing", outputfile);
         return false;
     }
-    tin_ioutil_writeuint16(file, TIN_BYTECODE_MAGIC_NUMBER);
-    tin_ioutil_writeuint8(file, TIN_BYTECODE_VERSION);
-    tin_ioutil_writeuint16(file, numfiles);
-    for(i = 0; i < numfiles; i++)
+    written = tin_image_write(state, compiledmodules, numfiles, file);
+    tin_gcmem_freearray(state, sizeof(TinModule*), compiledmodules, numfiles + 1);
+    fclose(file);
+    if(!written)
     {
-        tin_ioutil_writemodule(compiledmodules[i], file);
+        tin_state_raiseerror(state, COMPILE_ERROR, "failed to write bytecode to '%s'", outputfile);
     }
-    tin_ioutil_writeuint16(file, TIN_BYTECODE_END_NUMBER);
-    tin_gcmem_free(state, sizeof(TinModule), compiledmodules);
-    fclose(file);
-    return true;
+    return written;
 }
 
 static char* tin_util_readsource(TinState* state, const char* file, char** patchedfilename, size_t* dlen)
@@ -927,19 +1073,78 @@ static char* tin_util_readsource(TinState* state, const char* file, char** patch
     return source;
 }
 
+/* like tin_state_execsource, but goes through the compilation cache; see image.c */
+static TinInterpretResult tin_state_execcached(TinState* state, const char* file, const char* patchedfilename, const char* source, size_t len)
+{
+    bool stored;
+    clock_t t;
+    char* entry;
+    TinString* module_name;
+    TinModule* module;
+    t = 0;
+    if(measurecompilationtime)
+    {
+        t = clock();
+    }
+    entry = tin_image_cachepath(state->config.cachedir, file);
+    module = tin_image_loadcached(state, entry, source, len);
+    if(module != NULL)
+    {
+        if(measurecompilationtime)
+        {
+            printf("cache hit:      %gms (%s)\n", (double)(clock() - t) / CLOCKS_PER_SEC * 1000, entry);
+        }
+    }
+    else
+    {
+        module_name = tin_string_copy(state, patchedfilename, strlen(patchedfilename));
+        module = tin_state_compilemodule(state, module_name, source, len);
+        if(module == NULL)
+        {
+            free(entry);
+            return TIN_MAKESTATUS(TINSTATE_COMPILEERROR, tin_value_makenull(state));
+        }
+        stored = tin_image_savecached(state, state->config.cachedir, entry, module, source, len);
+        if(measurecompilationtime)
+        {
+            printf("cache miss:     %s (%s)\n", stored ? "stored" : "failed to store", entry);
+        }
+    }
+    free(entry);
+    return tin_state_runmodule(state, module);
+}
+
 TinInterpretResult tin_state_execfile(TinState* state, const char* file)
 {
     size_t len;
     char* source;
     char* patchedfilename;
+    TinModule* module;
     TinInterpretResult result;
     patchedfilename = NULL;
+    /* images are mapped rather than read */
+    if(tin_image_fileisimage(file))
+    {
+        module = tin_image_loadfile(state, file);
+        if(module == NULL)
+        {
+            return TIN_MAKESTATUS(TINSTATE_COMPILEERROR, tin_value_makenull(state));
+        }
+        return tin_state_runmodule(state, module);
+    }
     source = tin_util_readsource(state, file, &patchedfilename, &len);
     if(source == NULL)
     {
         return INTERPRET_RUNTIME_FAIL(state);
     }
-    result = tin_state_execsource(state, patchedfilename, source, len);
+    if(state->config.cachedir != NULL && !state->config.dumpast && !state->config.dumpbytecode)
+    {
+        result = tin_state_execcached(state, file, patchedfilename, source, len);
+    }
+    else
+    {
+        result = tin_state_execsource(state, patchedfilename, source, len);
+    }
     free(patchedfilename);
     free(source);
     return result;
@@ -0,0 +1,99 @@
+#!/usr/bin/ruby
+
+# builds the interpreter twice - once as-is, once with extra defines - and
+# compares wall time and peak RSS of the given scripts.
+# scripts are run from, and relative to, the top of the source tree.
+#
+# usage:
+#   ruby tests/bench/bench.rb -D TIN_USE_NANBOXING bintrees*.tin mandel*.tin
+#   ruby tests/bench/bench.rb -r 5 -D TIN_USE_NANBOXING -D SOMETHING_ELSE perceptron.tin
+#
+
+require "optparse"
+require "fileutils"
+
+CFLAGS = "-O2 -w"
+LDFLAGS = "-ldl -lm -lreadline -lpthread"
+
+class Bench
+  def initialize(opts)
+    @opts = opts
+    @srcdir = File.expand_path(File.join(File.dirname(__FILE__), "..", ".."))
+    @builddir = File.join(@srcdir, "_bench_build")
+  end
+
+  def build(name, defines)
+    FileUtils.mkdir_p(@builddir)
+    exe = File.join(@builddir, name)
+    dflags = defines.map{|d| "-D" + d }.join(" ")
+    srcs = Dir.glob(File.join(@srcdir, "*.c")).join(" ")
+    cmd = sprintf("gcc %s %s -o %p %s %s", CFLAGS, dflags, exe, srcs, LDFLAGS)
+    $stderr.printf("building %s ...\n", name)
+    if not system(cmd) then
+      $stderr.printf("build of %p failed\n", name)
+      exit(1)
+    end
+    return exe
+  end
+
+  # linux-only: peak RSS is sampled from /proc while the child runs.
+  def runonce(exe, script)
+    hwm = 0
+    t = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    pid = Process.spawn(exe, script, out: File::NULL, err: File::NULL, chdir: @srcdir)
+    loop do
+      begin
+        File.foreach(sprintf("/proc/%d/status", pid)) do |line|
+          if line.start_with?("VmHWM:") then
+            hwm = [hwm, line.split[1].to_i].max
+          end
+        end
+      rescue Errno::ENOENT, Errno::ESRCH
+      end
+      break if Process.waitpid(pid, Process::WNOHANG)
+      sleep(0.002)
+    end
+    return [Process.clock_gettime(Process::CLOCK_MONOTONIC) - t, hwm]
+  end
+
+  def measure(exe, script)
+    runs = (1 .. @opts.runs).map{ runonce(exe, script) }
+    return [runs.map{|r| r[0] }.min, runs.map{|r| r[1] }.max]
+  end
+
+  def main(scripts)
+    base = build("base", [])
+    variant = build("variant", @opts.defines)
+    printf("%-20s %12s %12s %8s %12s %12s\n", "script", "base(s)", "variant(s)", "speedup", "base(KiB)", "variant(KiB)")
+    scripts.each do |script|
+      bt, bm = measure(base, script)
+      vt, vm = measure(variant, script)
+      printf("%-20s %12.3f %12.3f %7.2fx %12d %12d\n", File.basename(script), bt, vt, bt / vt, bm, vm)
+    end
+  end
+end
+
+class Options
+  attr_accessor :defines, :runs
+  def initialize
+    @defines = []
+    @runs = 3
+  end
+end
+
+begin
+  opts = Options.new
+  OptionParser.new{|prs|
+    prs.on("-D<name>", "add a define for the variant build"){|v|
+      opts.defines.push(v)
+    }
+    prs.on("-r<n>", "--runs=<n>", "number of runs per script (best time is reported)"){|v|
+      opts.runs = v.to_i
+    }
+  }.parse!
+  if ARGV.empty? then
+    $stderr.printf("usage: bench.rb -D<define> <script...>\n")
+    exit(1)
+  end
+  Bench.new(opts).main(ARGV)
+end
@@ -25,7 +25,7 @@
 #define TIN_VERSION_MAJOR 0
 #define TIN_VERSION_MINOR 1
 #define TIN_VERSION_STRING "0.1"
-#define TIN_BYTECODE_VERSION 0
+#define TIN_BYTECODE_VERSION 4
 
 #define TESTING
 // #define DEBUG
@@ -57,10 +57,78 @@
 #define TIN_MAX_INTERPOLATION_NESTING 4
 
 #define TIN_GC_HEAP_GROW_FACTOR 2
+/*
+* how many bytes may be allocated between two minor collections.
+* a major collection happens once the old generation grew by TIN_GC_HEAP_GROW_FACTOR.
+*/
+#define TIN_GC_NURSERY_SIZE (1024 * 1024 * 2)
+
+/*
+* how many threads mark objects during a collection, by default. 1 marks on the collecting thread only.
+* can be changed at runtime through GC.markThreads.
+*/
+#ifndef TIN_GC_MARKTHREADS
+    #define TIN_GC_MARKTHREADS 1
+#endif
+
+/*
+* strings longer than this are neither hashed nor interned when they are made: that only happens once they
+* are used as a table key (see tin_string_intern). strings read from files, and the results of StringBuilder,
+* Array.join and tin_string_format, are never interned up front, whatever their length.
+*/
+#define TIN_STRING_MAXINTERN 128
+
+/*
+* tables (see modmap.c) probe TIN_TABLE_GROUPWIDTH control bytes at once, and rehash once
+* more than TIN_TABLE_MAXLOADNUM / TIN_TABLE_MAXLOADDEN of their slots have been used.
+*/
+#define TIN_TABLE_GROUPWIDTH 16
+#define TIN_TABLE_MINCAPACITY 8
+#define TIN_TABLE_MAXLOADNUM 7
+#define TIN_TABLE_MAXLOADDEN 8
+
+/* how many entries of a line table lie between two of its checkpoints; finding a line decodes at most this many */
+#define TIN_CHUNK_LINECHECKPOINT 32
+
+/*
+* objects up to TIN_SLAB_MAXSIZE bytes are carved out of TIN_SLAB_SIZE-sized slabs,
+* one set of slabs per size class (multiples of TIN_SLAB_GRANULARITY). see gcmem.c
+* every slab has one allocation bit and one mark bit per TIN_SLAB_GRANULARITY bytes.
+*/
+#define TIN_SLAB_SIZE (1024 * 16)
+#define TIN_SLAB_GRANULARITY 16
+#define TIN_SLAB_MAXSIZE 256
+#define TIN_SLAB_CLASSCOUNT (TIN_SLAB_MAXSIZE / TIN_SLAB_GRANULARITY)
+#define TIN_SLAB_BITMAPWORDS (TIN_SLAB_SIZE / TIN_SLAB_GRANULARITY / 64)
+/* how many empty slabs are kept for reuse, instead of being returned to the system */
+#define TIN_SLAB_MAXSPARE (TIN_GC_NURSERY_SIZE / TIN_SLAB_SIZE)
 #define TIN_CALL_FRAMES_MAX (1024*8)
 #define TIN_INITIAL_CALL_FRAMES 128
 #define TIN_CONTAINER_OUTPUT_MAX 10
 
+/*
+* how many receiver classes each field/method access site remembers.
+* 1 makes the caches purely monomorphic.
+*/
+#define TIN_INLINECACHE_WAYS 4
+
+/*
+* instances keep their fields in a flat slot array described by a shape (see shape.c).
+* past this many fields, or once a class has this many shapes, they use a TinTable instead.
+*/
+#define TIN_SHAPE_MAXFIELDS 32
+#define TIN_SHAPE_MAXPERCLASS 64
+/* at most this many slots are allocated together with the instance itself */
+#define TIN_INSTANCE_MAXINLINE 8
+
+/*
+* when defined, TinValue is a NaN-boxed 64bit word instead of a tagged struct.
+* halves the size of stack slots, arrays and table entries.
+* fixed numbers are limited to 48 bits; larger values are stored as floats.
+* can also be passed via CFLAGS, i.e., make CFLAGS+=-DTIN_USE_NANBOXING
+*/
+//#define TIN_USE_NANBOXING
+
 
 #if defined(__ANDROID__) || defined(_ANDROID_)
     #define TIN_OS_UNIXLIKE
@@ -84,6 +152,17 @@
     #define TIN_USE_LIBREADLINE
 #endif
 
+/*
+* parallel marking needs pthreads and the gcc/clang __atomic builtins; -DTIN_GC_NOPARALLELMARK turns it off.
+* without it, marking always happens on the collecting thread, and GC.markThreads stays at 1.
+*/
+#if defined(TIN_OS_UNIXLIKE) && defined(__GNUC__) && !defined(TIN_GC_NOPARALLELMARK)
+    #define TIN_GC_PARALLELMARK
+    #define TIN_GC_MAXMARKTHREADS 64
+#else
+    #define TIN_GC_MAXMARKTHREADS 1
+#endif
+
 #ifdef TIN_USE_LIBREADLINE
 #else
     #define TIN_REPL_INPUT_MAX 1024
@@ -92,9 +171,8 @@
 #define UNREACHABLE assert(false);
 
 
-// Do not change these, or old bytecode files will break!
+// Do not change these, or old bytecode files will break! the image format itself is described in image.c
 #define TIN_BYTECODE_MAGIC_NUMBER 6932
-#define TIN_BYTECODE_END_NUMBER 2942
 #define TIN_STRING_KEY 48
 
 #define TIN_TESTS_DIRECTORY "tests"
@@ -367,6 +445,39 @@ enum TinOpCode
     OP_REFFIELD,
 
     OP_REFSET,
+
+    /* OP_CALLFUNCTION in tail position, always followed by OP_RETURN */
+    OP_TAILCALL,
+
+    /*
+    * superinstructions, see tin_astopt_optbytecode. each one replaces the first opcode of the sequence it stands for,
+    * and leaves the rest of it in place, so they are as long as that sequence.
+    */
+    OP_LOCALSETPOP,
+    OP_LOCALLOCALARITH,
+    OP_LOCALCONSTARITH,
+    OP_LOCALLOCALBRANCH,
+    OP_LOCALCONSTBRANCH,
+    OP_LOCALINCR,
+
+    /*
+    * quickened forms, see tin_chunk_genericop. the vm writes these over the generic instruction once it has
+    * seen the operand types they expect, and writes the generic one back when that stops being true.
+    * they are never emitted by the compiler, and never saved.
+    */
+    OP_MATHADDINT,
+    OP_MATHADDFLOAT,
+    OP_MATHSUBINT,
+    OP_MATHSUBFLOAT,
+    OP_MATHMULTINT,
+    OP_MATHMULTFLOAT,
+    OP_LESSTHANINT,
+    OP_LESSTHANFLOAT,
+    OP_GREATERTHANINT,
+    OP_GREATERTHANFLOAT,
+    OP_GETINDEXARRAY,
+    OP_FIELDGETSLOT,
+    OP_GETINDEXTYPED,
 };
 
 
@@ -395,6 +506,15 @@ enum TinObjType
     TINTYPE_REFERENCE,
     TINTYPE_NUMBER,
     TINTYPE_BOOL,
+    TINTYPE_TYPEDARRAY,
+    TINTYPE_STRINGBUILDER,
+};
+
+/* element type of a TinTypedArray */
+enum TinTypedKind
+{
+    TINTYPED_FLOAT64,
+    TINTYPED_INT64,
 };
 
 enum TinValType
@@ -439,13 +559,44 @@ enum TinAstOptType
     TINOPTSTATE_LINEINFO,
     TINOPTSTATE_PRIVATENAMES,
     TINOPTSTATE_CFOR,
+    TINOPTSTATE_SUPERINSTRUCTIONS,
     TINOPTSTATE_TOTAL
 };
 
+/* well-known names that the vm, the natives and the compiler look up; interned once per state, see tin_state_initsymbols */
+enum TinSymbol
+{
+    TINSYM_ADD,
+    TINSYM_SUB,
+    TINSYM_MULT,
+    TINSYM_POWER,
+    TINSYM_MOD,
+    TINSYM_DIV,
+    TINSYM_FLOORDIV,
+    TINSYM_BINAND,
+    TINSYM_BINOR,
+    TINSYM_BINXOR,
+    TINSYM_LEFTSHIFT,
+    TINSYM_RIGHTSHIFT,
+    TINSYM_EQUAL,
+    TINSYM_GREATERTHAN,
+    TINSYM_GREATEREQUAL,
+    TINSYM_LESSTHAN,
+    TINSYM_LESSEQUAL,
+    TINSYM_NOT,
+    TINSYM_SUBSCRIPT,
+    TINSYM_ITERATOR,
+    TINSYM_ITERATORVALUE,
+    TINSYM_CONSTRUCTOR,
+    TINSYM_TOSTRING,
+    TINSYM_TOTAL
+};
+
 
 
 typedef enum /**/ TinValType TinValType;
 typedef enum /**/ TinObjType TinObjType;
+typedef enum /**/ TinTypedKind TinTypedKind;
 typedef struct /**/ TinObject TinObject;
 typedef struct /**/ TinValue TinValue;
 
@@ -453,6 +604,7 @@ typedef enum /**/TinOpCode TinOpCode;
 typedef enum /**/TinAstExprType TinAstExprType;
 typedef enum /**/TinAstOptLevel TinAstOptLevel;
 typedef enum /**/TinAstOptType TinAstOptType;
+typedef enum /**/TinSymbol TinSymbol;
 typedef enum /**/TinAstPrecedence TinAstPrecedence;
 typedef enum /**/TinAstTokType TinAstTokType;
 typedef enum /**/TinStatus TinStatus;
@@ -464,8 +616,11 @@ typedef struct /**/TinVM TinVM;
 typedef struct /**/TinAstParser TinAstParser;
 typedef struct /**/TinAstEmitter TinAstEmitter;
 typedef struct /**/TinAstOptimizer TinAstOptimizer;
+typedef struct /**/TinAstArena TinAstArena;
+typedef struct /**/TinAstArenaBlock TinAstArenaBlock;
 typedef struct /**/TinState TinState;
 typedef struct /**/TinInterpretResult TinInterpretResult;
+typedef struct /**/TinPreparedCall TinPreparedCall;
 typedef struct /**/TinMap TinMap;
 typedef struct /**/TinNumber TinNumber;
 typedef struct /**/TinString TinString;
@@ -473,9 +628,18 @@ typedef struct /**/TinModule TinModule;
 typedef struct /**/TinFiber TinFiber;
 typedef struct /**/TinUserdata TinUserdata;
 typedef struct /**/TinChunk TinChunk;
+typedef struct /**/TinLineCheckpoint TinLineCheckpoint;
+typedef struct /**/TinInlineCacheEntry TinInlineCacheEntry;
+typedef struct /**/TinInlineFieldEntry TinInlineFieldEntry;
+typedef struct /**/TinInlineCache TinInlineCache;
+typedef struct /**/TinShape TinShape;
+typedef struct /**/TinSlab TinSlab;
+typedef struct /**/TinSlabClass TinSlabClass;
+typedef struct /**/TinGCPool TinGCPool;
 typedef struct /**/TinTabEntry TinTabEntry;
 typedef struct /**/TinTable TinTable;
 typedef struct /**/TinFunction TinFunction;
+typedef struct /**/TinImage TinImage;
 typedef struct /**/TinUpvalue TinUpvalue;
 typedef struct /**/TinClosure TinClosure;
 typedef struct /**/TinNativeFunction TinNativeFunction;
@@ -488,6 +652,8 @@ typedef struct /**/TinInstance TinInstance;
 typedef struct /**/TinBoundMethod TinBoundMethod;
 typedef struct /**/TinArray TinArray;
 typedef struct /**/TinRange TinRange;
+typedef struct /**/TinTypedArray TinTypedArray;
+typedef struct /**/TinStringBuilder TinStringBuilder;
 typedef struct /**/TinField TinField;
 typedef struct /**/TinReference TinReference;
 typedef struct /**/TinAstToken TinAstToken;
@@ -573,23 +739,47 @@ struct TinObject
 {
     /* the type of this object */
     TinObjType type;
-    TinObject* next;
-    bool marked;
+    /* true while the object is in the remembered set (or always watched) */
+    bool remembered;
     bool mustfree;
 };
 
-struct TinValue
-{
-    TinValType type;
-    bool isfixednumber;
-    union
+#if defined(TIN_USE_NANBOXING)
+    /*
+    * layout:
+    *   float:  any double that does not have all bits of TIN_NANBOX_QNAN set
+    *   object: TIN_NANBOX_SIGNBIT | TIN_NANBOX_QNAN | pointer
+    *   fixed:  TIN_NANBOX_QNAN | TIN_NANBOX_TAGFIXED | 48bit two's complement
+    *   null/false/true: TIN_NANBOX_QNAN | 1/2/3
+    */
+    #define TIN_NANBOX_SIGNBIT ((uint64_t)0x8000000000000000)
+    #define TIN_NANBOX_QNAN ((uint64_t)0x7ffc000000000000)
+    #define TIN_NANBOX_TAGFIXED ((uint64_t)0x0001000000000000)
+    #define TIN_NANBOX_PAYLOADMASK ((uint64_t)0x0000ffffffffffff)
+    #define TIN_NANBOX_TAGNULL 1
+    #define TIN_NANBOX_TAGFALSE 2
+    #define TIN_NANBOX_TAGTRUE 3
+    #define TIN_NANBOX_FIXEDMIN (-((int64_t)1 << 47))
+    #define TIN_NANBOX_FIXEDMAX (((int64_t)1 << 47) - 1)
+
+    struct TinValue
     {
-        bool boolval;
-        int64_t numfixedval;
-        double numfloatval;
-        TinObject* obj;
+        uint64_t raw;
     };
-};
+#else
+    struct TinValue
+    {
+        TinValType type;
+        bool isfixednumber;
+        union
+        {
+            bool boolval;
+            int64_t numfixedval;
+            double numfloatval;
+            TinObject* obj;
+        };
+    };
+#endif
 
 struct TinValList
 {
@@ -597,6 +787,8 @@ struct TinValList
     size_t count;
     size_t elemsize;
     TinValue* values;
+    /* the object this list belongs to, if any; stores into it go through the write barrier */
+    TinObject* owner;
 };
 
 struct TinVarList
@@ -627,6 +819,16 @@ struct TinAstByteList
     uint8_t* values;
 };
 
+/* where decoding the line table can start; see tin_chunk_getposition */
+struct TinLineCheckpoint
+{
+    /* the entry at $offset of the line table, which starts at $pc */
+    uint32_t pc;
+    uint32_t line;
+    uint32_t column;
+    uint32_t offset;
+};
+
 struct TinChunk
 {
     /* how many items this chunk holds */
@@ -634,10 +836,114 @@ struct TinChunk
     size_t capacity;
     uint8_t* code;
     bool haslineinfo;
-    size_t linecount;
+    /* the line table: delta encoded (pc, line, column) entries, see tin_chunk_push */
+    size_t linelength;
     size_t linecap;
-    uint16_t* lines;
+    uint8_t* lineinfo;
+    /* every TIN_CHUNK_LINECHECKPOINT-th entry of the line table */
+    size_t checkpointcount;
+    size_t checkpointcap;
+    TinLineCheckpoint* checkpoints;
+    /* the last entry of the line table, and how many there are */
+    size_t lastlinepc;
+    size_t lastline;
+    size_t lastcolumn;
+    size_t lineentries;
     TinValList constants;
+    /* the string and number constants by value, while the chunk is emitted; see tin_chunk_addconst */
+    uint32_t* constindex;
+    size_t constindexcap;
+    size_t constindexcount;
+    /* how many inline cache slots the code refers to */
+    size_t icachecount;
+    /* allocated on first use by the vm */
+    TinInlineCache* icaches;
+    /* global cells linked to the name constants of this chunk, indexed like constants, see tin_chunk_getglobalref */
+    size_t globalrefcount;
+    TinValue** globalrefs;
+    /* the code points into a bytecode image (see image.c), and is not freed with the chunk */
+    bool codeinimage;
+};
+
+struct TinInlineCacheEntry
+{
+    TinClass* klass;
+    /* TinClass.methodsversion at the time of the lookup */
+    size_t version;
+    /* whether the lookup found anything; if not, value is null */
+    bool found;
+    TinValue value;
+};
+
+struct TinInlineFieldEntry
+{
+    TinShape* shape;
+    /* TinShape.id, in case the shape was freed and its memory reused */
+    size_t shapeid;
+    /* slot index of the field, or -1 if instances of this shape don't have it */
+    int slot;
+};
+
+/*
+* every OP_FIELDGET, OP_FIELDSET, OP_INVOKEMETHOD and OP_INVOKEIGNORING carries the index of one of these.
+* method entries are only valid as long as the version of the class matches.
+*/
+struct TinInlineCache
+{
+    TinInlineCacheEntry entries[TIN_INLINECACHE_WAYS];
+    /* which entry to replace next when all are taken */
+    size_t nextway;
+    TinInlineFieldEntry fieldentries[TIN_INLINECACHE_WAYS];
+    size_t nextfieldway;
+};
+
+struct TinShape
+{
+    /* unique across the state, see TinInlineFieldEntry */
+    size_t id;
+    /* field names in slot order */
+    TinString** keys;
+    size_t fieldcount;
+    /* shapes that have one more field than this one */
+    TinShape** children;
+    size_t childcount;
+    size_t childcap;
+};
+
+struct TinSlab
+{
+    /* links within TinSlabClass.partial or TinSlabClass.full */
+    TinSlab* next;
+    TinSlab* prev;
+    /* links within TinState.gcallslabs */
+    TinSlab* allnext;
+    TinSlab* allprev;
+    /* NULL for a slab that holds a single object bigger than TIN_SLAB_MAXSIZE */
+    TinSlabClass* sizeclass;
+    /* free cells of this slab, linked through their first word */
+    void* freelist;
+    size_t livecount;
+    /* bytes mapped for this slab */
+    size_t mapsize;
+    /* one bit per TIN_SLAB_GRANULARITY bytes of the slab, set at the first byte of a cell in use */
+    uint64_t allocbits[TIN_SLAB_BITMAPWORDS];
+    /* same layout; set for objects that survived a collection, see gcmem.c */
+    uint64_t markbits[TIN_SLAB_BITMAPWORDS];
+};
+
+struct TinSlabClass
+{
+    size_t cellsize;
+    size_t cellsperslab;
+    /* slabs that have free cells */
+    TinSlab* partial;
+    /* slabs that don't */
+    TinSlab* full;
+    size_t slabcount;
+    /* cells in use */
+    size_t livecount;
+    /* cells handed out since the state was created */
+    size_t allocations;
 };
 
 struct TinWriter
@@ -677,13 +983,26 @@ struct TinTable
 {
     TinState* state;
 
+    /* the object this table belongs to, if any; stores into it go through the write barrier */
+    TinObject* owner;
+
     /* how many entries are in this table */
     int count;
 
-    /* how many entries could be held */
+    /* how many slots there are; always zero or a power of two */
     int capacity;
 
-    /* the actual entries */
+    /* how many more empty slots may be filled before the table is rehashed */
+    int growthleft;
+
+    /*
+    * one control byte per slot: TIN_TABLE_CTRLEMPTY, TIN_TABLE_CTRLDELETED, or the low 7 bits
+    * of the key's hash. the first TIN_TABLE_GROUPWIDTH bytes are mirrored past the end,
+    * so that a group can be loaded at any slot without wrapping around.
+    */
+    uint8_t* control;
+
+    /* the actual entries, indexed like $control. the key of an unused slot is NULL */
     TinTabEntry* entries;
 };
 
@@ -696,12 +1015,29 @@ struct TinNumber
 struct TinString
 {
     TinObject object;
-    /* the hash of this string - note that it is only unique to the context! */
+    /* the hash of this string, valid once $hashed is set - use tin_string_gethash */
     uint32_t hash;
+    bool hashed;
+    /*
+    * true if this is the one TinString in the string registry with this text, so that comparing pointers
+    * is enough to compare it with another interned string. tables only hold interned keys, apart from
+    * the empty string, which is never registered.
+    */
+    bool interned;
     /* this is handled by sds - use tin_string_getlength to get the length! */
     char* data;
 };
 
+/*
+* StringBuilder: a mutable sds buffer that grows geometrically, so that building a string piece by piece
+* is linear. nothing is hashed or interned until toString() turns it into a TinString.
+*/
+struct TinStringBuilder
+{
+    TinObject object;
+    char* data;
+};
+
 struct TinFunction
 {
     TinObject object;
@@ -712,6 +1048,28 @@ struct TinFunction
     size_t maxslots;
     bool vararg;
     TinModule* module;
+    /*
+    * if not NULL, the body (chunk) of this function has not been read from $image yet.
+    * see tin_function_ensureloaded.
+    */
+    TinImage* image;
+    uint32_t imageindex;
+};
+
+/*
+* a loaded bytecode image. the bytes stay around (mapped, or in one heap block) for as long as the state does,
+* since the code of the functions read from it is used in place.
+*/
+struct TinImage
+{
+    uint8_t* data;
+    size_t length;
+    /* whether $data was mapped from a file, rather than allocated */
+    bool mapped;
+    /* every string of the image, made (and interned) when the image is loaded. these are gc roots */
+    size_t stringcount;
+    TinString** strings;
+    TinImage* next;
 };
 
 struct TinUpvalue
@@ -826,6 +1184,17 @@ struct TinClass
     * that is, eg for TinString: TinString <- TinObject <- TinClass
     */
     TinClass* parentclass;
+    /*
+    * changes every time 'methods' does. taken from TinState.classversion, so it's
+    * unique across classes, and a class reusing the memory of a freed one never matches stale cache entries.
+    */
+    size_t methodsversion;
+    /* shape of instances without fields; created along with the first instance */
+    TinShape* rootshape;
+    /* how many shapes hang off of rootshape */
+    size_t shapecount;
+    /* the most fields any instance had so far, used to size the inline slots of new instances */
+    size_t instancefields;
 };
 
 struct TinInstance
@@ -833,7 +1202,15 @@ struct TinInstance
     TinObject object;
     /* the class that corresponds to this instance */
     TinClass* klass;
+    /* which field is in which slot. NULL if the instance is in dictionary mode */
+    TinShape* shape;
+    /* field values; points to inlineslots until there are more fields than fit there */
+    TinValue* slots;
+    size_t slotcap;
+    size_t inlinecap;
+    /* holds the fields in dictionary mode only */
     TinTable fields;
+    TinValue inlineslots[];
 };
 
 struct TinBoundMethod
@@ -865,6 +1242,24 @@ struct TinRange
     double to;
 };
 
+/*
+* Float64Array and Int64Array: unboxed numbers in one contiguous buffer.
+* the buffer is plain memory (no TinValues in it), so the collector never has to look inside.
+*/
+struct TinTypedArray
+{
+    TinObject object;
+    TinTypedKind kind;
+    size_t count;
+    size_t capacity;
+    union
+    {
+        void* raw;
+        double* f64;
+        int64_t* i64;
+    } data;
+};
+
 struct TinField
 {
     TinObject object;
@@ -886,11 +1281,28 @@ struct TinInterpretResult
     TinValue result;
 };
 
+/*
+* a callee that native code calls over and over with the same number of arguments,
+* like the comparator of Array.sort. see tin_state_preparecall.
+*/
+struct TinPreparedCall
+{
+    TinState* state;
+    TinFiber* fiber;
+    TinValue callee;
+    uint8_t argc;
+    /* set if the callee is a script function (or closure) taking exactly argc arguments, NULL otherwise */
+    TinFunction* function;
+    TinClosure* closure;
+};
+
 struct TinConfig
 {
     bool dumpbytecode;
     bool dumpast;
     bool runafterdump;
+    /* where tin_state_execfile caches compiled scripts; NULL (the default) disables the cache */
+    const char* cachedir;
 };
 
 struct TinState
@@ -899,8 +1311,27 @@ struct TinState
     TinWriter stdoutwriter;
     /* how much was allocated in total? */
     int64_t gcbytescount;
+    /* the next collection (minor, unless gcmajornext was reached) happens once gcbytescount gets here */
     int64_t gcnext;
+    /* size of the heap after the last collection, i.e. the old generation */
+    int64_t gcoldbytes;
+    int64_t gcmajornext;
     bool gcallow;
+    /* collection statistics, see the GC class. pauses are in seconds */
+    size_t gcminorcount;
+    size_t gcmajorcount;
+    double gclastpause;
+    double gcmaxpause;
+    double gctotalpause;
+    /* see TIN_GC_MARKTHREADS */
+    size_t gcmarkthreads;
+    /* small objects live in here, see tin_slab_allocate */
+    TinSlabClass gcslabs[TIN_SLAB_CLASSCOUNT];
+    /* every slab that is in use, including those of objects bigger than TIN_SLAB_MAXSIZE */
+    TinSlab* gcallslabs;
+    /* empty slabs, not tied to any size class */
+    TinSlab* gcspareslabs;
+    size_t gcsparecount;
     TinValList gclightobjects;
     TinErrorFn errorfn;
     TinPrintFn printfn;
@@ -911,6 +1342,8 @@ struct TinState
     TinAstParser* parser;
     TinAstEmitter* emitter;
     TinAstOptimizer* optimizer;
+    /* the arena of the module being compiled; NULL outside of tin_state_compilemodule */
+    TinAstArena* astarena;
     /*
     * recursive pointer to the current VM instance.
     * using 'state->vm->state' will in turn mean this instance, etc.
@@ -920,6 +1353,8 @@ struct TinState
     TinFunction* capifunction;
     TinFiber* capifiber;
     TinString* capiname;
+    /* indexed by TinSymbol */
+    TinString* symbols[TINSYM_TOTAL];
     /* when using debug routines, this is the writer that output is called on */
     TinWriter debugwriter;
     // class class
@@ -936,26 +1371,51 @@ struct TinState
     TinClass* primarrayclass;
     TinClass* primmapclass;
     TinClass* primrangeclass;
+    TinClass* primfloat64arrayclass;
+    TinClass* primint64arrayclass;
+    TinClass* primstringbuilderclass;
     TinModule* lastmodule;
+    /* every bytecode image loaded into this state, see image.c */
+    TinImage* images;
+    /* the last version handed out to a class, see tin_class_touchmethods */
+    size_t classversion;
+    /* the last TinShape.id handed out */
+    size_t lastshapeid;
+    /* inline cache statistics, see VM.cacheHits and VM.cacheMisses */
+    size_t icachehits;
+    size_t icachemisses;
 };
 
 struct TinVM
 {
     /* the current state */
     TinState* state;
-    /* currently held objects */
-    TinObject* gcobjects;
+    /* old objects that had a young object stored into them since the last collection */
+    TinObject** gcremembered;
+    size_t gcrememberedcount;
+    size_t gcrememberedcap;
+    /* old objects that are mutated without a write barrier, and get scanned on every minor collection */
+    TinObject** gcwatched;
+    size_t gcwatchedcount;
+    size_t gcwatchedcap;
     /* currently cached strings */
     TinTable gcstrings;
     /* currently loaded/defined modules */
     TinMap* modules;
     /* currently defined globals */
     TinMap* globals;
+    /* maps global names to an index into globalcells; see tin_vm_globalcell */
+    TinTable globalslots;
+    TinValue** globalcells;
+    size_t globalcount;
+    size_t globalcap;
     TinFiber* fiber;
     // For garbage collection
     size_t gcgraycount;
     size_t gcgraycapacity;
     TinObject** gcgraystack;
+    /* threads for parallel marking; created by the first collection that needs them */
+    TinGCPool* gcpool;
 };
 
 #include "protall.inc"
@@ -974,15 +1434,251 @@ struct TinVM
 
 */
 #define tin_value_asnumber(v) \
-    (((v).isfixednumber) ? ((v).numfixedval) : ((v).numfloatval) )
+    tin_value_asfloatnumber(v)
 
 #define tin_value_fromobject(obj) tin_value_fromobject_actual((TinObject*)obj)
 
+#if defined(TIN_USE_NANBOXING)
+
+static inline bool tin_value_isobject(TinValue v)
+{
+    return ((v.raw & (TIN_NANBOX_QNAN | TIN_NANBOX_SIGNBIT)) == (TIN_NANBOX_QNAN | TIN_NANBOX_SIGNBIT));
+}
+
+static inline bool tin_value_isnull(TinValue v)
+{
+    return (v.raw == (TIN_NANBOX_QNAN | TIN_NANBOX_TAGNULL));
+}
+
+static inline bool tin_value_isbool(TinValue v)
+{
+    return ((v.raw | 1) == (TIN_NANBOX_QNAN | TIN_NANBOX_TAGTRUE));
+}
+
+static inline bool tin_value_isfixednumber(TinValue v)
+{
+    return ((v.raw & (TIN_NANBOX_QNAN | TIN_NANBOX_SIGNBIT | TIN_NANBOX_TAGFIXED)) == (TIN_NANBOX_QNAN | TIN_NANBOX_TAGFIXED));
+}
+
+static inline bool tin_value_isfloatnumber(TinValue v)
+{
+    return ((v.raw & TIN_NANBOX_QNAN) != TIN_NANBOX_QNAN);
+}
+
+static inline bool tin_value_isnumber(TinValue v)
+{
+    return (tin_value_isfloatnumber(v) || tin_value_isfixednumber(v));
+}
+
+static inline TinValType tin_value_valtype(TinValue v)
+{
+    if(tin_value_isnumber(v))
+    {
+        return TINVAL_NUMBER;
+    }
+    if(tin_value_isobject(v))
+    {
+        return TINVAL_OBJECT;
+    }
+    if(tin_value_isbool(v))
+    {
+        return TINVAL_BOOL;
+    }
+    return TINVAL_NULL;
+}
+
+static inline bool tin_value_asbool(TinValue v)
+{
+    return (v.raw == (TIN_NANBOX_QNAN | TIN_NANBOX_TAGTRUE));
+}
+
+static inline int64_t tin_value_asrawfixednumber(TinValue v)
+{
+    /* sign-extend the 48bit payload */
+    return ((int64_t)(v.raw << 16)) >> 16;
+}
+
+static inline double tin_value_asrawfloatnumber(TinValue v)
+{
+    double d;
+    memcpy(&d, &v.raw, sizeof(double));
+    return d;
+}
+
+static inline double tin_value_asfloatnumber(TinValue v)
+{
+    if(tin_value_isfloatnumber(v))
+    {
+        return tin_value_asrawfloatnumber(v);
+    }
+    if(tin_value_isfixednumber(v))
+    {
+        return tin_value_asrawfixednumber(v);
+    }
+    return 0;
+}
+
+static inline int64_t tin_value_asfixednumber(TinValue v)
+{
+    if(tin_value_isfixednumber(v))
+    {
+        return tin_value_asrawfixednumber(v);
+    }
+    if(tin_value_isfloatnumber(v))
+    {
+        return tin_value_asrawfloatnumber(v);
+    }
+    return 0;
+}
+
+static inline void tin_value_setnull(TinValue* tv)
+{
+    tv->raw = (TIN_NANBOX_QNAN | TIN_NANBOX_TAGNULL);
+}
+
+static inline TinValue tin_value_makebool(TinState* state, bool b) 
+{
+    TinValue tv;
+    (void)state;
+    tv.raw = (TIN_NANBOX_QNAN | (b ? TIN_NANBOX_TAGTRUE : TIN_NANBOX_TAGFALSE));
+    return tv;
+}
+
+static inline TinValue tin_value_makefloatnumber(TinState* state, double num)
+{
+    TinValue v;
+    (void)state;
+    /* arbitrary NaN payloads could alias a tag, so store the canonical quiet NaN instead */
+    if(num != num)
+    {
+        num = NAN;
+    }
+    memcpy(&v.raw, &num, sizeof(double));
+    return v;
+}
+
+static inline TinValue tin_value_makefixednumber(TinState* state, int64_t num)
+{
+    TinValue v;
+    if(num < TIN_NANBOX_FIXEDMIN || num > TIN_NANBOX_FIXEDMAX)
+    {
+        return tin_value_makefloatnumber(state, num);
+    }
+    v.raw = (TIN_NANBOX_QNAN | TIN_NANBOX_TAGFIXED | ((uint64_t)num & TIN_NANBOX_PAYLOADMASK));
+    return v;
+}
+
+#else
+
 static inline bool tin_value_isobject(TinValue v)
 {
     return v.type == TINVAL_OBJECT;
 }
 
+static inline bool tin_value_isnull(TinValue v)
+{
+    return (v.type == TINVAL_NULL);
+}
+
+static inline bool tin_value_isbool(TinValue v)
+{
+    return v.type == TINVAL_BOOL;
+}
+
+static inline bool tin_value_isnumber(TinValue v)
+{
+    return v.type == TINVAL_NUMBER;
+}
+
+static inline bool tin_value_isfixednumber(TinValue v)
+{
+    return v.isfixednumber;
+}
+
+static inline bool tin_value_isfloatnumber(TinValue v)
+{
+    return (v.type == TINVAL_NUMBER && !v.isfixednumber);
+}
+
+static inline TinValType tin_value_valtype(TinValue v)
+{
+    return v.type;
+}
+
+static inline bool tin_value_asbool(TinValue v)
+{
+    return v.boolval;
+}
+
+static inline int64_t tin_value_asrawfixednumber(TinValue v)
+{
+    return v.numfixedval;
+}
+
+static inline double tin_value_asrawfloatnumber(TinValue v)
+{
+    return v.numfloatval;
+}
+
+static inline double tin_value_asfloatnumber(TinValue v)
+{
+    if(v.isfixednumber)
+    {
+        return v.numfixedval;
+    }
+    return v.numfloatval;
+}
+
+static inline int64_t tin_value_asfixednumber(TinValue v)
+{
+    if(!v.isfixednumber)
+    {
+        return v.numfloatval;
+    }
+    return v.numfixedval;
+}
+
+static inline void tin_value_setnull(TinValue* tv)
+{
+    tv->type = TINVAL_NULL;
+    tv->isfixednumber = false;
+    tv->numfixedval = 0;
+    tv->numfloatval = 0;
+    tv->boolval = false;
+}
+
+static inline TinValue tin_value_makebool(TinState* state, bool b) 
+{
+    TinValue tv;
+    (void)state;
+    tin_value_setnull(&tv);
+    tv.type = TINVAL_BOOL;
+    tv.boolval = b;
+    return tv;
+}
+
+static inline TinValue tin_value_makefloatnumber(TinState* state, double num)
+{
+    TinValue v;
+    (void)state;
+    v.type = TINVAL_NUMBER;
+    v.isfixednumber = false;
+    v.numfloatval = num;
+    return v;
+}
+
+static inline TinValue tin_value_makefixednumber(TinState* state, int64_t num)
+{
+    TinValue v;
+    (void)state;
+    v.type = TINVAL_NUMBER;
+    v.isfixednumber = true;
+    v.numfixedval = num;
+    return v;
+}
+
+#endif
+
 static inline bool tin_value_istype(TinValue value, int t)
 {
     int ot;
@@ -1054,25 +1750,10 @@ static inline bool tin_value_isarray(TinValue v)
     return tin_value_istype(v, TINTYPE_ARRAY);
 }
 
-static inline bool tin_value_isnull(TinValue v)
-{
-    return (v.type == TINVAL_NULL);
-}
-
-static inline bool tin_value_isbool(TinValue v)
-{
-    return v.type == TINVAL_BOOL;
-}
-
-static inline bool tin_value_isnumber(TinValue v)
-{
-    return v.type == TINVAL_NUMBER;
-}
-
 static inline bool tin_value_isfalsey(TinValue v)
 {
     return (
-        (tin_value_isbool(v) && !v.boolval) ||
+        (tin_value_isbool(v) && !tin_value_asbool(v)) ||
         tin_value_isnull(v) ||
         (tin_value_isnumber(v) && tin_value_asnumber(v) == 0)
     );
@@ -1098,42 +1779,39 @@ static inline bool tin_value_isrange(TinValue value)
     return tin_value_istype(value, TINTYPE_RANGE);
 }
 
-static inline bool tin_value_isfield(TinValue value)
+static inline bool tin_value_istypedarray(TinValue value)
 {
-    return tin_value_istype(value, TINTYPE_FIELD);
+    return tin_value_istype(value, TINTYPE_TYPEDARRAY);
 }
 
-static inline bool tin_value_isreference(TinValue value)
+static inline bool tin_value_isstringbuilder(TinValue value)
 {
-    return tin_value_istype(value, TINTYPE_REFERENCE);
+    return tin_value_istype(value, TINTYPE_STRINGBUILDER);
 }
 
-static inline bool tin_value_asbool(TinValue v)
+static inline bool tin_value_isfield(TinValue value)
 {
-    return v.boolval;
+    return tin_value_istype(value, TINTYPE_FIELD);
 }
 
-static inline double tin_value_asfloatnumber(TinValue v)
+static inline bool tin_value_isreference(TinValue value)
 {
-    if(v.isfixednumber)
-    {
-        return v.numfixedval;
-    }
-    return v.numfloatval;
+    return tin_value_istype(value, TINTYPE_REFERENCE);
 }
 
-static inline int64_t tin_value_asfixednumber(TinValue v)
+static inline TinString* tin_value_asstring(TinValue v)
 {
-    if(!v.isfixednumber)
-    {
-        return v.numfloatval;
-    }
-    return v.numfixedval;
+    return (TinString*)tin_value_asobject(v);
 }
 
-static inline TinString* tin_value_asstring(TinValue v)
+static inline uint32_t tin_string_gethash(TinString* string)
 {
-    return (TinString*)tin_value_asobject(v);
+    if(!string->hashed)
+    {
+        string->hash = tin_util_hashstring(string->data, tin_string_getlength(string));
+        string->hashed = true;
+    }
+    return string->hash;
 }
 
 static inline char* tin_value_ascstring(TinValue v)
@@ -1216,38 +1894,29 @@ static inline TinRange* tin_value_asrange(TinValue v)
     return (TinRange*)tin_value_asobject(v);
 }
 
-static inline TinField* tin_value_asfield(TinValue v)
+static inline TinTypedArray* tin_value_astypedarray(TinValue v)
 {
-    return (TinField*)tin_value_asobject(v);
+    return (TinTypedArray*)tin_value_asobject(v);
 }
 
-static inline TinFiber* tin_value_asfiber(TinValue v)
+static inline TinStringBuilder* tin_value_asstringbuilder(TinValue v)
 {
-    return (TinFiber*)tin_value_asobject(v);
+    return (TinStringBuilder*)tin_value_asobject(v);
 }
 
-static inline TinReference* tin_value_asreference(TinValue v)
+static inline TinField* tin_value_asfield(TinValue v)
 {
-    return (TinReference*)tin_value_asobject(v);
+    return (TinField*)tin_value_asobject(v);
 }
 
-static inline void tin_value_setnull(TinValue* tv)
+static inline TinFiber* tin_value_asfiber(TinValue v)
 {
-    tv->type = TINVAL_NULL;
-    tv->isfixednumber = false;
-    tv->numfixedval = 0;
-    tv->numfloatval = 0;
-    tv->boolval = false;
+    return (TinFiber*)tin_value_asobject(v);
 }
 
-static inline TinValue tin_value_makebool(TinState* state, bool b) 
+static inline TinReference* tin_value_asreference(TinValue v)
 {
-    TinValue tv;
-    (void)state;
-    tin_value_setnull(&tv);
-    tv.type = TINVAL_BOOL;
-    tv.boolval = b;
-    return tv;
+    return (TinReference*)tin_value_asobject(v);
 }
 
 static inline TinValue tin_value_makenull(TinState* state)
@@ -1255,7 +1924,6 @@ static inline TinValue tin_value_makenull(TinState* state)
     TinValue tv;
     (void)state;
     tin_value_setnull(&tv);
-    tv.type = TINVAL_NULL;
     return tv;
 }
 
@@ -1263,3 +1931,12 @@ static inline TinValue tin_value_makestring(TinState* state, const char* text)
 {
     return tin_value_fromobject(tin_string_copy((state), (text), strlen(text)));
 }
+
+/* reads the body of $function from its bytecode image, if that hasn't happened yet. see image.c */
+static inline void tin_function_ensureloaded(TinState* state, TinFunction* function)
+{
+    if(function->image != NULL)
+    {
+        tin_image_loadfunction(state, function);
+    }
+}
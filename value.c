@@ -3,6 +3,22 @@
 #include <stdio.h>
 #include "priv.h"
 
+#if defined(TIN_USE_NANBOXING)
+
+TinValue tin_value_fromobject_actual(TinObject* obj)
+{
+    TinValue val;
+    val.raw = (TIN_NANBOX_SIGNBIT | TIN_NANBOX_QNAN | (uint64_t)(uintptr_t)obj);
+    return val;
+}
+
+TinObject* tin_value_asobject(TinValue v)
+{
+    return (TinObject*)(uintptr_t)(v.raw & ~(TIN_NANBOX_SIGNBIT | TIN_NANBOX_QNAN));
+}
+
+#else
+
 TinValue tin_value_fromobject_actual(TinObject* obj)
 {
     TinValue val;
@@ -12,12 +28,12 @@ TinValue tin_value_fromobject_actual(TinObject* obj)
     return val;
 }
 
-
 TinObject* tin_value_asobject(TinValue v)
 {
     return v.obj;
 }
 
+#endif
 
 TinObjType tin_value_type(TinValue v)
 {
@@ -39,33 +55,15 @@ TinValue tin_value_makenumber(TinState* state, double num)
     return tin_value_makefloatnumber(state, num);
 }
 
-TinValue tin_value_makefloatnumber(TinState* state, double num)
-{
-    (void)state;
-    TinValue v;
-    v.type = TINVAL_NUMBER;
-    v.isfixednumber = false;
-    v.numfloatval = num;
-    return v;
-}
-
-
-TinValue tin_value_makefixednumber(TinState* state, int64_t num)
-{
-    (void)state;
-    TinValue v;
-    v.type = TINVAL_NUMBER;
-    v.isfixednumber = true;
-    v.numfixedval = num;
-    return v;
-}
-
 bool tin_valcompare_object(TinState* state, const TinValue a, const TinValue b)
 {
-    (void)state;
-    (void)b;
-    switch(a.obj->type)
+    switch(tin_value_asobject(a)->type)
     {
+        case TINTYPE_STRING:
+            {
+                return tin_value_isstring(b) && tin_string_equal(state, tin_value_asstring(a), tin_value_asstring(b));
+            }
+            break;
         default:
             {
                 fprintf(stderr, "missing equality comparison for type '%s'", tin_tostring_typename(a));
@@ -84,14 +82,14 @@ bool tin_value_compare(TinState* state, const TinValue a, const TinValue b)
     if(tin_value_isinstance(a))
     {
         args[0] = b;
-        inret = tin_state_callinstancemethod(state, a, tin_string_copyconst(state, "=="), args, 1);
+        inret = tin_state_callinstancemethod(state, a, state->symbols[TINSYM_EQUAL], args, 1);
         if(inret.type == TINSTATE_OK)
         {
             return false;
         }
     }
-    t1 = a.type;
-    t2 = b.type;
+    t1 = tin_value_valtype(a);
+    t2 = tin_value_valtype(b);
     //fprintf(stderr, "compare: t1=%d t2=%d\n", t1, t2);
     if(t1 == t2)
     {
@@ -99,11 +97,11 @@ bool tin_value_compare(TinState* state, const TinValue a, const TinValue b)
         {
             case TINVAL_NUMBER:
                 {
-                    if(a.isfixednumber && b.isfixednumber)
+                    if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                     {
                         return (tin_value_asfixednumber(a) == tin_value_asfixednumber(b));
                     }
-                    else if(!a.isfixednumber && !b.isfixednumber)
+                    else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                     {
                         return (tin_value_asfloatnumber(a) == tin_value_asfloatnumber(b));
                     }
@@ -117,7 +115,7 @@ bool tin_value_compare(TinState* state, const TinValue a, const TinValue b)
                 break;
             case TINVAL_BOOL:
                 {
-                    return a.boolval == b.boolval;
+                    return tin_value_asbool(a) == tin_value_asbool(b);
                 }
                 break;
             case TINVAL_OBJECT:
@@ -183,9 +181,10 @@ TinString* tin_value_tostring(TinState* state, TinValue object)
         chunk->count = 0;
         tin_vallist_setcount(&chunk->constants, 0);
         function->maxslots = 3;
-        tin_chunk_push(state, chunk, OP_INVOKEMETHOD, 1);
+        tin_chunk_push(state, chunk, OP_INVOKEMETHOD, 1, 0);
         tin_chunk_emitbyte(state, chunk, 0);
-        tin_chunk_emitshort(state, chunk, tin_chunk_addconst(state, chunk, tin_value_makestring(state, "toString")));
+        tin_chunk_emitshort(state, chunk, tin_chunk_addconst(state, chunk, tin_value_fromobject(state->symbols[TINSYM_TOSTRING])));
+        tin_chunk_emitshort(state, chunk, tin_chunk_addcache(state, chunk));
         tin_chunk_emitbyte(state, chunk, OP_RETURN);
     }
     tin_fiber_ensurestack(state, fiber, function->maxslots + (int)(fiber->stacktop - fiber->stackvalues));
@@ -334,7 +333,7 @@ TinValue tin_value_callnew(TinVM* vm, const char* name, TinValue* args, size_t a
 {
     TinValue value;
     TinClass* klass;
-    if(!tin_table_get(&vm->globals->values, tin_string_copyconst(vm->state, name), &value))
+    if(!tin_vm_getglobal(vm, tin_string_copyconst(vm->state, name), &value))
     {
         tin_vm_raiseerror(vm, "failed to create instance of class %s: class not found", name);
         return tin_value_makenull(vm->state);
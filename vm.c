@@ -66,7 +66,6 @@
 // likewise, any macro that uses tin_vmmac_recoverstate can't be turned into
 // a function.
 #define tin_vmmac_recoverstate(est) \
-    tin_vmintern_writeframe(est, est->ip); \
     est->fiber = est->vm->fiber; \
     if(est->fiber == NULL) \
     { \
@@ -89,6 +88,7 @@
 
 
 #define tin_vmmac_raiseerrorfmtcont(format, ...) \
+    tin_vmintern_writeframe(est, est->ip); \
     if(tin_vm_raiseerror(est->vm, format, __VA_ARGS__)) \
     { \
         tin_vmmac_recoverstate(est);  \
@@ -101,6 +101,7 @@
 
 
 #define tin_vmmac_raiseerrorfmtnocont(format, ...) \
+    tin_vmintern_writeframe(est, est->ip); \
     if(tin_vm_raiseerror(est->vm, format, __VA_ARGS__)) \
     { \
         tin_vmmac_recoverstate(est);  \
@@ -116,7 +117,7 @@
 
 #define tin_vmmac_advinvokefromclass(zklass, mthname, argc, raiseerr, stat, ignoring, callee) \
     TinValue mthval; \
-    if((tin_value_isinstance(callee) && (tin_table_get(&tin_value_asinstance(callee)->fields, mthname, &mthval))) \
+    if((tin_value_isinstance(callee) && (tin_instance_getfield(tin_value_asinstance(callee), mthname, &mthval))) \
        || tin_table_get(&zklass->stat, mthname, &mthval)) \
     { \
         if(ignoring) \
@@ -155,22 +156,22 @@
     tin_vmmac_advinvokefromclass(klass, mthname, argc, raiseerr, stat, ignoring, tin_vmintern_peek(est, argc))
 
 // calls tin_vmmac_recoverstate
-#define tin_vmmac_invokemethod(instance, mthname, argc) \
+/* mthsym is a TinSymbol, see tin_state_initsymbols */
+#define tin_vmmac_invokemethod(instance, mthsym, argc) \
     if(tin_value_isnull(instance)) \
     { \
-        /*fprintf(stderr, "mthname=<%s>\n", mthname); */\
-        tin_vmmac_raiseerrorfmtcont("cannot call method '%s' of null-instance", mthname); \
+        tin_vmmac_raiseerrorfmtcont("cannot call method '%s' of null-instance", est->state->symbols[mthsym]->data); \
     } \
     TinClass* klass = tin_state_getclassfor(est->state, instance); \
     if(klass == NULL) \
     { \
-        tin_vmmac_raiseerrorfmtcont("cannot call method '%s' of a non-class", mthname); \
+        tin_vmmac_raiseerrorfmtcont("cannot call method '%s' of a non-class", est->state->symbols[mthsym]->data); \
     } \
     tin_vmintern_writeframe(est, est->ip); \
-    tin_vmmac_advinvokefromclass(klass, tin_string_copyconst(est->state, mthname), argc, true, methods, false, instance); \
+    tin_vmmac_advinvokefromclass(klass, est->state->symbols[mthsym], argc, true, methods, false, instance); \
     tin_vmintern_readframe(est);
 
-#define tin_vmmac_binaryop(op, opstring) \
+#define tin_vmmac_binaryop(op, opsym) \
     TinValue a = tin_vmintern_peek(est, 1); \
     TinValue b = tin_vmintern_peek(est, 0); \
     /* implicitly converts NULL to numeric 0 */ \
@@ -180,7 +181,7 @@
         { \
             if(!tin_value_isnull(b)) \
             { \
-                tin_vmmac_raiseerrorfmtcont("cannot use op '%s' with a 'number' and a '%s'", opstring, tin_tostring_typename(b)); \
+                tin_vmmac_raiseerrorfmtcont("cannot use op '%s' with a 'number' and a '%s'", est->state->symbols[opsym]->data, tin_tostring_typename(b)); \
             } \
         } \
         tin_vmintern_drop(est); \
@@ -198,15 +199,111 @@
         } \
         else \
         { \
-            tin_vmmac_raiseerrorfmtcont("cannot use op %s on a null value", opstring); \
+            tin_vmmac_raiseerrorfmtcont("cannot use op %s on a null value", est->state->symbols[opsym]->data); \
             *(est->fiber->stacktop - 1) = tin_value_makebool(est->state, false);\
         } \
     } \
     else \
     { \
-        tin_vmmac_invokemethod(a, opstring, 1); \
+        tin_vmmac_invokemethod(a, opsym, 1); \
     }
 
+/*
+* each arithmetic and comparison opcode has its own handler, which does two fixed or two float numbers
+* inline. mixed numbers, null and objects (operator methods, errors) go through tin_vmmac_binaryop.
+* the results are the same as the ones vm_binaryop_actual computes.
+* $qint and $qfloat are the quickened forms the instruction is rewritten to once it has seen two fixed
+* or two float numbers, or $op itself when there are none.
+*/
+#define tin_vmmac_arithop(op, opsym, cop, qint, qfloat) \
+    TinValue vala; \
+    TinValue valb; \
+    vala = tin_vmintern_peek(est, 1); \
+    valb = tin_vmintern_peek(est, 0); \
+    if(tin_value_isfixednumber(vala) && tin_value_isfixednumber(valb)) \
+    { \
+        if((qint) != (op)) \
+        { \
+            est->ip[-1] = (qint); \
+        } \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = tin_value_makefixednumber(est->state, tin_value_asrawfixednumber(vala) cop tin_value_asrawfixednumber(valb)); \
+        continue; \
+    } \
+    if(tin_value_isfloatnumber(vala) && tin_value_isfloatnumber(valb)) \
+    { \
+        if((qfloat) != (op)) \
+        { \
+            est->ip[-1] = (qfloat); \
+        } \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = tin_value_makefloatnumber(est->state, tin_value_asrawfloatnumber(vala) cop tin_value_asrawfloatnumber(valb)); \
+        continue; \
+    } \
+    tin_vmmac_binaryop(op, opsym); \
+    continue;
+
+#define tin_vmmac_bitop(op, opsym, cop) \
+    TinValue vala; \
+    TinValue valb; \
+    vala = tin_vmintern_peek(est, 1); \
+    valb = tin_vmintern_peek(est, 0); \
+    if(tin_value_isfixednumber(vala) && tin_value_isfixednumber(valb)) \
+    { \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = tin_value_makefixednumber(est->state, tin_value_asrawfixednumber(vala) cop tin_value_asrawfixednumber(valb)); \
+        continue; \
+    } \
+    tin_vmmac_binaryop(op, opsym); \
+    continue;
+
+#define tin_vmmac_compareop(op, opsym, cop, qint, qfloat) \
+    TinValue vala; \
+    TinValue valb; \
+    vala = tin_vmintern_peek(est, 1); \
+    valb = tin_vmintern_peek(est, 0); \
+    if(tin_value_isfixednumber(vala) && tin_value_isfixednumber(valb)) \
+    { \
+        if((qint) != (op)) \
+        { \
+            est->ip[-1] = (qint); \
+        } \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = tin_value_makebool(est->state, tin_value_asrawfixednumber(vala) cop tin_value_asrawfixednumber(valb)); \
+        continue; \
+    } \
+    if(tin_value_isfloatnumber(vala) && tin_value_isfloatnumber(valb)) \
+    { \
+        if((qfloat) != (op)) \
+        { \
+            est->ip[-1] = (qfloat); \
+        } \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = tin_value_makebool(est->state, tin_value_asrawfloatnumber(vala) cop tin_value_asrawfloatnumber(valb)); \
+        continue; \
+    } \
+    tin_vmmac_binaryop(op, opsym); \
+    continue;
+
+/*
+* handler of a quickened arithmetic or comparison instruction: does the operation if both operands pass
+* $isfn, otherwise writes $generic back over the instruction, and runs that instead.
+*/
+#define tin_vmmac_quickop(generic, isfn, asfn, makefn, cop) \
+    TinValue vala; \
+    TinValue valb; \
+    vala = tin_vmintern_peek(est, 1); \
+    valb = tin_vmintern_peek(est, 0); \
+    if(isfn(vala) && isfn(valb)) \
+    { \
+        tin_vmintern_drop(est); \
+        est->fiber->stacktop[-1] = makefn(est->state, asfn(vala) cop asfn(valb)); \
+        continue; \
+    } \
+    est->ip--; \
+    est->ip[0] = (generic); \
+    continue;
+
 enum
 {
     RECOVER_RETURNOK,
@@ -224,6 +321,9 @@ TIN_VM_INLINE TinValue tin_vmintern_readconstant(TinExecState *est);
 TIN_VM_INLINE TinValue tin_vmintern_readconstantlong(TinExecState *est);
 TIN_VM_INLINE TinString *tin_vmintern_readstring(TinExecState *est);
 TIN_VM_INLINE TinString *tin_vmintern_readstringlong(TinExecState *est);
+TIN_VM_INLINE TinInlineCache *tin_vmintern_readcache(TinExecState *est);
+TIN_VM_INLINE bool tin_vmintern_cachedmethod(TinExecState *est, TinInlineCache *ic, TinClass *klass, TinString *name, TinValue *dest);
+TIN_VM_INLINE TinValue *tin_vmintern_cachedfield(TinExecState *est, TinInlineCache *ic, TinInstance *inst, TinString *name);
 TIN_VM_INLINE void tin_vmintern_push(TinExecState *est, TinValue v);
 TIN_VM_INLINE TinValue tin_vmintern_pop(TinExecState* est);
 TIN_VM_INLINE void tin_vmintern_drop(TinExecState* est);
@@ -285,6 +385,100 @@ TIN_VM_INLINE TinString* tin_vmintern_readstringlong(TinExecState* est)
     return tin_value_asstring(tin_vmintern_readconstantlong(est));
 }
 
+TIN_VM_INLINE TinInlineCache* tin_vmintern_readcache(TinExecState* est)
+{
+    return tin_chunk_getcache(est->state, est->currentchunk, tin_vmintern_readshort(est));
+}
+
+/*
+* same as tin_table_get(&klass->methods, name, dest), but remembers the result in $ic.
+* an entry is only used while the class' methodsversion is unchanged.
+*/
+TIN_VM_INLINE bool tin_vmintern_cachedmethod(TinExecState* est, TinInlineCache* ic, TinClass* klass, TinString* name, TinValue* dest)
+{
+    size_t i;
+    size_t way;
+    TinInlineCacheEntry* entry;
+    way = ic->nextway;
+    for(i = 0; i < TIN_INLINECACHE_WAYS; i++)
+    {
+        entry = &ic->entries[i];
+        if(entry->klass == klass)
+        {
+            if(entry->version == klass->methodsversion)
+            {
+                est->state->icachehits++;
+                *dest = entry->value;
+                return entry->found;
+            }
+            /* stale entry of the same class; refresh it in place */
+            way = i;
+            break;
+        }
+    }
+    est->state->icachemisses++;
+    entry = &ic->entries[way];
+    if(way == ic->nextway)
+    {
+        ic->nextway = (ic->nextway + 1) % TIN_INLINECACHE_WAYS;
+    }
+    entry->klass = klass;
+    entry->version = klass->methodsversion;
+    entry->found = tin_table_get(&klass->methods, name, dest);
+    if(!entry->found)
+    {
+        *dest = tin_value_makenull(est->state);
+    }
+    entry->value = *dest;
+    return entry->found;
+}
+
+/*
+* returns the slot holding field $name of $inst, or NULL if it has none.
+* the slot may hold null, which means the field was removed.
+* for instances that have a shape, the slot index is remembered in $ic.
+*/
+TIN_VM_INLINE TinValue* tin_vmintern_cachedfield(TinExecState* est, TinInlineCache* ic, TinInstance* inst, TinString* name)
+{
+    size_t i;
+    TinValue* pval;
+    TinShape* shape;
+    TinInlineFieldEntry* entry;
+    shape = inst->shape;
+    if(shape == NULL)
+    {
+        if(tin_table_get_slot(&inst->fields, name, &pval))
+        {
+            return pval;
+        }
+        return NULL;
+    }
+    for(i = 0; i < TIN_INLINECACHE_WAYS; i++)
+    {
+        entry = &ic->fieldentries[i];
+        if(entry->shape == shape && entry->shapeid == shape->id)
+        {
+            est->state->icachehits++;
+            if(entry->slot == -1)
+            {
+                return NULL;
+            }
+            return &inst->slots[entry->slot];
+        }
+    }
+    est->state->icachemisses++;
+    entry = &ic->fieldentries[ic->nextfieldway];
+    ic->nextfieldway = (ic->nextfieldway + 1) % TIN_INLINECACHE_WAYS;
+    entry->shape = shape;
+    entry->shapeid = shape->id;
+    entry->slot = tin_shape_findslot(shape, name);
+    if(entry->slot == -1)
+    {
+        return NULL;
+    }
+    return &inst->slots[entry->slot];
+}
+
 
 TIN_VM_INLINE void tin_vmintern_push(TinExecState* est, TinValue v)
 {
@@ -333,6 +527,16 @@ TIN_VM_INLINE void tin_vmintern_writeframe(TinExecState* est, uint8_t* ip)
     est->frame->ip = ip;
 }
 
+/*
+* natives can call back into scripts (Array.sort, Array.map, ...), which may grow and move the frames and the
+* stack of the fiber; picks the caller's frame and slots up again once such a native returned.
+*/
+TIN_VM_INLINE void tin_vmintern_refreshframe(TinExecState* est)
+{
+    est->frame = &est->fiber->framevalues[est->fiber->framecount - 1];
+    est->slots = est->frame->slots;
+}
+
 void tin_vmintern_resetstack(TinVM* vm)
 {
     if(vm->fiber != NULL)
@@ -344,30 +548,179 @@ void tin_vmintern_resetstack(TinVM* vm)
 void tin_vmintern_resetvm(TinState* state, TinVM* vm)
 {
     vm->state = state;
-    vm->gcobjects = NULL;
+    vm->gcremembered = NULL;
+    vm->gcrememberedcount = 0;
+    vm->gcrememberedcap = 0;
+    vm->gcwatched = NULL;
+    vm->gcwatchedcount = 0;
+    vm->gcwatchedcap = 0;
     vm->fiber = NULL;
     vm->gcgraystack = NULL;
     vm->gcgraycount = 0;
     vm->gcgraycapacity = 0;
+    vm->gcpool = NULL;
     tin_strreg_init(vm->state);
     vm->globals = NULL;
     vm->modules = NULL;
+    tin_table_init(state, &vm->globalslots);
+    vm->globalcells = NULL;
+    vm->globalcount = 0;
+    vm->globalcap = 0;
 }
 
 void tin_vm_init(TinState* state, TinVM* vm)
 {
     tin_vmintern_resetvm(state, vm);
     vm->globals = tin_object_makemap(state);
+    vm->globals->onindexfn = tin_vm_accessglobal;
     vm->modules = tin_object_makemap(state);
 }
 
 void tin_vm_destroy(TinVM* vm)
 {
+    size_t i;
+    tin_gcpool_destroy(vm);
     tin_strreg_destroy(vm->state);
-    tin_object_destroylistof(vm->state, vm->gcobjects);
+    tin_slab_destroyobjects(vm->state);
+    free(vm->gcgraystack);
+    vm->gcgraystack = NULL;
+    vm->gcgraycapacity = 0;
+    free(vm->gcremembered);
+    free(vm->gcwatched);
+    for(i = 0; i < vm->globalcount; i++)
+    {
+        tin_gcmem_free(vm->state, sizeof(TinValue), vm->globalcells[i]);
+    }
+    tin_gcmem_freearray(vm->state, sizeof(TinValue*), vm->globalcells, vm->globalcap);
+    tin_table_destroy(vm->state, &vm->globalslots);
     tin_vmintern_resetvm(vm->state, vm);
 }
 
+/*
+* globals that compiled code refers to get a cell - a TinValue that never moves - which
+* OP_GLOBALGET, OP_GLOBALSET and OP_REFGLOBAL use directly, instead of looking the name up
+* in vm->globals every time. cells are created on first reference, so code can refer to
+* globals that are only defined later; until then, the cell holds null.
+* once a name has a cell, the cell is what holds its value. vm->globals only gets the name
+* (when the global is first given a value, so that it shows up when the map is walked), and
+* the value stored next to it is brought up to date by tin_vm_syncglobals, before the map is
+* copied, printed, or marked by the gc. reads through the map go through the cells.
+*/
+TinValue* tin_vm_findglobalcell(TinVM* vm, TinString* name)
+{
+    TinValue index;
+    if(!tin_table_get(&vm->globalslots, name, &index))
+    {
+        return NULL;
+    }
+    return vm->globalcells[(size_t)tin_value_asfixednumber(index)];
+}
+
+TinValue* tin_vm_globalcell(TinState* state, TinString* name)
+{
+    size_t oldcap;
+    TinVM* vm;
+    TinValue* cell;
+    vm = state->vm;
+    cell = tin_vm_findglobalcell(vm, name);
+    if(cell != NULL)
+    {
+        return cell;
+    }
+    tin_state_pushroot(state, (TinObject*)name);
+    cell = (TinValue*)tin_gcmem_allocate(state, sizeof(TinValue), 1);
+    if(!tin_table_get(&vm->globals->values, name, cell))
+    {
+        *cell = tin_value_makenull(state);
+    }
+    if(vm->globalcount == vm->globalcap)
+    {
+        oldcap = vm->globalcap;
+        vm->globalcap = (oldcap < 16) ? 16 : (oldcap * 2);
+        vm->globalcells = (TinValue**)tin_gcmem_growarray(state, vm->globalcells, sizeof(TinValue*), oldcap, vm->globalcap);
+    }
+    vm->globalcells[vm->globalcount] = cell;
+    tin_table_set(state, &vm->globalslots, name, tin_value_makefixednumber(state, vm->globalcount));
+    vm->globalcount++;
+    tin_state_poproots(state, 1);
+    return cell;
+}
+
+void tin_vm_setglobal(TinState* state, TinString* name, TinValue value)
+{
+    TinValue* cell;
+    cell = tin_vm_findglobalcell(state->vm, name);
+    if(tin_value_isnull(value))
+    {
+        /* like any other map, a global set to null is gone from it */
+        tin_table_delete(&state->vm->globals->values, name);
+    }
+    else if(cell == NULL || tin_value_isnull(*cell))
+    {
+        tin_table_set(state, &state->vm->globals->values, name, value);
+    }
+    if(cell != NULL)
+    {
+        *cell = value;
+    }
+}
+
+bool tin_vm_getglobal(TinVM* vm, TinString* name, TinValue* dest)
+{
+    TinValue* cell;
+    cell = tin_vm_findglobalcell(vm, name);
+    if(cell != NULL)
+    {
+        *dest = *cell;
+        return !tin_value_isnull(*cell);
+    }
+    return tin_table_get(&vm->globals->values, name, dest);
+}
+
+/* copies the value of every cell back into vm->globals, dropping the globals whose cell holds null */
+void tin_vm_syncglobals(TinVM* vm)
+{
+    int i;
+    TinValue* cell;
+    TinTabEntry* entry;
+    TinTable* slots;
+    slots = &vm->globalslots;
+    for(i = 0; i < slots->capacity; i++)
+    {
+        entry = &slots->entries[i];
+        if(entry->key == NULL)
+        {
+            continue;
+        }
+        cell = vm->globalcells[(size_t)tin_value_asfixednumber(entry->value)];
+        if(tin_value_isnull(*cell))
+        {
+            tin_table_delete(&vm->globals->values, entry->key);
+        }
+        else
+        {
+            tin_table_set(vm->state, &vm->globals->values, entry->key, *cell);
+        }
+    }
+}
+
+/* subscripting the 'globals' map goes through the cells, just like compiled code does */
+TinValue tin_vm_accessglobal(TinVM* vm, TinMap* map, TinString* name, TinValue* val)
+{
+    TinValue value;
+    (void)map;
+    if(val != NULL)
+    {
+        tin_vm_setglobal(vm->state, name, *val);
+        return *val;
+    }
+    if(!tin_vm_getglobal(vm, name, &value))
+    {
+        return tin_value_makenull(vm->state);
+    }
+    return value;
+}
+
 void tin_vm_callexitjump(TinVM* vm)
 {
     (void)vm;
@@ -408,18 +761,40 @@ void tin_vmintern_tracestack(TinVM* vm, TinWriter* wr)
     tin_writer_writeformat(wr, "\n");
 }
 
+/* writes the stack trace line of $frame to $dest (like snprintf), with the line and column it is at */
+static int tin_vm_writeframe(char* dest, size_t size, TinCallFrame* frame)
+{
+    size_t line;
+    size_t column;
+    const char* name;
+    TinFunction* function;
+    TinChunk* chunk;
+    function = frame->function;
+    if(function == NULL || function->name == NULL)
+    {
+        return snprintf(dest, size, "\tin %s()\n", "unknown");
+    }
+    name = function->name->data;
+    chunk = &function->chunk;
+    if(!chunk->haslineinfo)
+    {
+        return snprintf(dest, size, "\tin %s()\n", name);
+    }
+    tin_chunk_getposition(chunk, frame->ip - chunk->code - 1, &line, &column);
+    if(column != 0)
+    {
+        return snprintf(dest, size, "[line %d:%d] in %s()\n", (int)line, (int)column, name);
+    }
+    return snprintf(dest, size, "[line %d] in %s()\n", (int)line, name);
+}
+
 bool tin_vm_handleruntimeerror(TinVM* vm, TinString* errorstring)
 {
     int i;
     int count;
-    bool haschunk;
     size_t length;
     char* start;
     char* buffer;
-    const char* name;
-    TinCallFrame* frame;
-    TinFunction* function;
-    TinChunk* chunk;
     TinValue errval;
     TinFiber* fiber;
     TinFiber* caller;
@@ -451,27 +826,7 @@ bool tin_vm_handleruntimeerror(TinVM* vm, TinString* errorstring)
     length = snprintf(NULL, 0, "%s%s\n", COLOR_RED, errorstring->data);
     for(i = count; i >= 0; i--)
     {
-        frame = &fiber->framevalues[i];
-        function = frame->function;
-        chunk = &function->chunk;
-        name = "unknown";
-        haschunk = false;
-        if(function != NULL)
-        {
-            if(function->name != NULL)
-            {
-                haschunk = true;
-                name = function->name->data;
-            }
-        }
-        if(haschunk && chunk->haslineinfo)
-        {
-            length += snprintf(NULL, 0, "[line %d] in %s()\n", (int)tin_chunk_getline(chunk, frame->ip - chunk->code - 1), name);
-        }
-        else
-        {
-            length += snprintf(NULL, 0, "\tin %s()\n", name);
-        }
+        length += tin_vm_writeframe(NULL, 0, &fiber->framevalues[i]);
     }
     length += snprintf(NULL, 0, "%s", COLOR_RESET);
     buffer = (char*)malloc(length + 1);
@@ -479,27 +834,7 @@ bool tin_vm_handleruntimeerror(TinVM* vm, TinString* errorstring)
     start = buffer + sprintf(buffer, "%s%s\n", COLOR_RED, errorstring->data);
     for(i = count; i >= 0; i--)
     {
-        frame = &fiber->framevalues[i];
-        function = frame->function;
-        chunk = &function->chunk;
-        haschunk = false;
-        name = "unknown";
-        if(function != NULL)
-        {
-            if(function->name != NULL)
-            {
-                haschunk = true;
-                name = function->name->data;
-            }
-        }
-        if(haschunk && chunk->haslineinfo)
-        {
-            start += sprintf(start, "[line %d] in %s()\n", (int)tin_chunk_getline(chunk, frame->ip - chunk->code - 1), name);
-        }
-        else
-        {
-            start += sprintf(start, "\tin %s()\n", name);
-        }
+        start += tin_vm_writeframe(start, length + 1 - (start - buffer), &fiber->framevalues[i]);
     }
     start += sprintf(start, "%s", COLOR_RESET);
     tin_state_raiseerror(vm->state, RUNTIME_ERROR, buffer);
@@ -556,6 +891,7 @@ bool tin_vm_callcallable(TinVM* vm, TinFunction* function, TinClosure* closure,
     TinFiber* fiber;
     TinArray* array;
     fiber = vm->fiber;
+    tin_function_ensureloaded(vm->state, function);
 
     #if 0
     //if(fiber->framecount == TIN_CALL_FRAMES_MAX)
@@ -656,6 +992,11 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
     TinInstance* instance;
     TinClass* klass;
     (void)valfiber;
+    /*
+    * done here rather than after the call, since calling a function may grow (and move) the frames of the
+    * fiber, leaving est->frame dangling until tin_vmmac_recoverstate reads it again.
+    */
+    tin_vmintern_writeframe(est, est->ip);
     if(tin_value_isobject(callee))
     {
         if(tin_vm_setexitjump(est->vm))
@@ -682,6 +1023,7 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                     est->vm->fiber->stacktop -= argc + 1;
                     tin_vm_push(est->vm, result);
                     tin_vmmac_popgc(est);
+                    tin_vmintern_refreshframe(est);
                     return false;
                 }
                 break;
@@ -695,6 +1037,10 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                         est->fiber->stacktop -= argc;
                     }
                     tin_vmmac_popgc(est);
+                    if(!bres)
+                    {
+                        tin_vmintern_refreshframe(est);
+                    }
                     return bres;
                 }
                 break;
@@ -713,6 +1059,7 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                         }
                     }
                     tin_vmmac_popgc(est);
+                    tin_vmintern_refreshframe(est);
                     return false;
                 }
                 break;
@@ -726,6 +1073,10 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                         est->fiber->stacktop -= argc;
                     }
                     tin_vmmac_popgc(est);
+                    if(!bres)
+                    {
+                        tin_vmintern_refreshframe(est);
+                    }
                     return bres;
                 }
                 break;
@@ -758,6 +1109,7 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                         est->vm->fiber->stacktop -= argc + 1;
                         tin_vm_push(est->vm, result);
                         tin_vmmac_popgc(est);
+                        tin_vmintern_refreshframe(est);
                         return false;
                     }
                     else if(tin_value_isprimmethod(mthval))
@@ -770,6 +1122,7 @@ bool tin_vm_callvalue(TinExecState* est, TinValue callee, TinString* name, uint8
                             return true;
                         }
                         tin_vmmac_popgc(est);
+                        tin_vmintern_refreshframe(est);
                         return false;
                     }
                     else
@@ -850,6 +1203,7 @@ void tin_vmintern_closeupvalues(TinVM* vm, const TinValue* last)
         upvalue = fiber->openupvalues;
         upvalue->closed = *upvalue->location;
         upvalue->location = &upvalue->closed;
+        tin_gcmem_writebarrier(vm->state, (TinObject*)upvalue, upvalue->closed);
         fiber->openupvalues = upvalue->next;
     }
 }
@@ -867,32 +1221,6 @@ TinInterpretResult tin_vm_execmodule(TinState* state, TinModule* module)
     return result;
 }
 
-TIN_VM_INLINE const char* vmutil_op2s(int op)
-{
-    switch(op)
-    {
-        case OP_MATHADD: return "+";
-        case OP_MATHSUB: return "-";
-        case OP_MATHMULT: return "*";
-        case OP_MATHPOWER: return "**";
-        case OP_MATHMOD: return "%";
-        case OP_MATHDIV: return "/";
-        case OP_BINAND: return "&";
-        case OP_BINOR: return "|";
-        case OP_BINXOR: return "^";
-        case OP_LEFTSHIFT: return "<<";
-        case OP_RIGHTSHIFT: return ">>";
-        case OP_EQUAL: return "==";
-        case OP_GREATERTHAN: return ">";
-        case OP_GREATEREQUAL: return ">=";
-        case OP_LESSTHAN: return "<";
-        case OP_LESSEQUAL: return "<=";
-        default:
-            break;
-    }
-    return "??";
-}
-
 TIN_VM_INLINE int vmutil_numtoint32(TinValue val)
 {
     if(tin_value_isnull(val))
@@ -901,13 +1229,13 @@ TIN_VM_INLINE int vmutil_numtoint32(TinValue val)
     }
     if(tin_value_isbool(val))
     {
-        return val.boolval;
+        return tin_value_asbool(val);
     }
-    if(val.isfixednumber)
+    if(tin_value_isfixednumber(val))
     {
-        return val.numfixedval;
+        return tin_value_asfixednumber(val);
     }
-    return tin_util_numbertoint32(val.numfloatval);
+    return tin_util_numbertoint32(tin_value_asfloatnumber(val));
 }
 
 TIN_VM_INLINE unsigned int vmutil_numtouint32(TinValue val)
@@ -918,13 +1246,13 @@ TIN_VM_INLINE unsigned int vmutil_numtouint32(TinValue val)
     }
     if(tin_value_isbool(val))
     {
-        return val.boolval;
+        return tin_value_asbool(val);
     }
-    if(val.isfixednumber)
+    if(tin_value_isfixednumber(val))
     {
-        return val.numfixedval;
+        return tin_value_asfixednumber(val);
     }
-    return tin_util_numbertouint32(val.numfloatval);
+    return tin_util_numbertouint32(tin_value_asfloatnumber(val));
 }
 
 TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, TinValue b)
@@ -937,11 +1265,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
     {
         case OP_MATHMOD:
             {
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefixednumber(est->vm->state, tin_value_asfixednumber(a) % tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefloatnumber(est->vm->state, fmod(tin_value_asfloatnumber(a),  tin_value_asfloatnumber(b)));
                 }
@@ -960,11 +1288,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
             break;
         case OP_MATHADD:
             {
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefixednumber(est->vm->state, tin_value_asfixednumber(a) + tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefloatnumber(est->vm->state, tin_value_asfloatnumber(a) + tin_value_asfloatnumber(b));
                 }
@@ -977,11 +1305,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
             break;
         case OP_MATHSUB:
             {
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefixednumber(est->vm->state, tin_value_asfixednumber(a) - tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefloatnumber(est->vm->state, tin_value_asfloatnumber(a) - tin_value_asfloatnumber(b));
                 }
@@ -994,11 +1322,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
             break;
         case OP_MATHMULT:
             {
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefixednumber(est->vm->state, tin_value_asfixednumber(a) * tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefloatnumber(est->vm->state, tin_value_asfloatnumber(a) * tin_value_asfloatnumber(b));
                 }
@@ -1011,11 +1339,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
             break;
         case OP_MATHDIV:
             {
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefixednumber(est->vm->state, tin_value_asfixednumber(a) / tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     res = tin_value_makefloatnumber(est->vm->state, tin_value_asfloatnumber(a) / tin_value_asfloatnumber(b));
                 }
@@ -1054,7 +1382,7 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
                 unsigned int uright;
                 uleft = vmutil_numtoint32(a);
                 uright = vmutil_numtouint32(b);
-                if(!b.isfixednumber)
+                if(!tin_value_isfixednumber(b))
                 {
                     ires = uleft << (uright & 0x1F);
                 }
@@ -1072,7 +1400,7 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
                 unsigned int uright;
                 uleft = vmutil_numtoint32(a);
                 uright = vmutil_numtouint32(b);
-                if(!b.isfixednumber)
+                if(!tin_value_isfixednumber(b))
                 {
                     ires = uleft >> (uright & 0x1F);
                 }
@@ -1086,11 +1414,11 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
         case OP_EQUAL:
             {
                 eq = false;
-                if(a.isfixednumber && b.isfixednumber)
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
                 {
                     eq = (tin_value_asfixednumber(a) == tin_value_asfixednumber(b));
                 }
-                else if(!a.isfixednumber && !b.isfixednumber)
+                else if(!tin_value_isfixednumber(a) && !tin_value_isfixednumber(b))
                 {
                     eq = (tin_value_asfloatnumber(a) == tin_value_asfloatnumber(b));
                 }
@@ -1131,30 +1459,396 @@ TIN_VM_INLINE bool vm_binaryop_actual(TinExecState* est, int op, TinValue a, Tin
     return true;
 }
 
-// OP_CALLFUNCTION
-TIN_VM_INLINE bool tin_vmdo_call(TinExecState* est, TinValue* finalresult)
+/* comparison $op (OP_EQUAL to OP_LESSEQUAL) of two numbers, same as vm_binaryop_actual */
+TIN_VM_INLINE bool vmutil_numcompare(int op, TinValue a, TinValue b)
+{
+    switch(op)
+    {
+        case OP_EQUAL:
+            {
+                if(tin_value_isfixednumber(a) && tin_value_isfixednumber(b))
+                {
+                    return tin_value_asfixednumber(a) == tin_value_asfixednumber(b);
+                }
+                return tin_value_asnumber(a) == tin_value_asnumber(b);
+            }
+            break;
+        case OP_GREATERTHAN:
+            return tin_value_asnumber(a) > tin_value_asnumber(b);
+        case OP_GREATEREQUAL:
+            return tin_value_asnumber(a) >= tin_value_asnumber(b);
+        case OP_LESSTHAN:
+            return tin_value_asnumber(a) < tin_value_asnumber(b);
+        case OP_LESSEQUAL:
+            return tin_value_asnumber(a) <= tin_value_asnumber(b);
+        default:
+            break;
+    }
+    return false;
+}
+
+// OP_CALLFUNCTION
+/*
+* script functions whose arity matches the call exactly, and that take no varargs, don't need any
+* of the argument fixups in tin_vm_callcallable. if the frame and stack capacity that the function
+* needs (maxslots, computed by the compiler) is already there, the new frame is set up right here.
+* returns false if the call has to go through tin_vm_callvalue instead.
+*/
+TIN_VM_INLINE bool tin_vmintern_getfastcallee(TinValue callee, uint8_t argc, TinFunction** function, TinClosure** closure)
+{
+    if(!tin_value_isobject(callee))
+    {
+        return false;
+    }
+    if(tin_value_isclosure(callee))
+    {
+        *closure = tin_value_asclosure(callee);
+        *function = (*closure)->function;
+    }
+    else if(tin_value_isfunction(callee))
+    {
+        *closure = NULL;
+        *function = tin_value_asfunction(callee);
+    }
+    else
+    {
+        return false;
+    }
+    return ((*function)->argcount == argc && !(*function)->vararg && (*function)->image == NULL);
+}
+
+TIN_VM_INLINE bool tin_vmintern_fastcall(TinExecState* est, TinValue callee, uint8_t argc)
+{
+    TinFiber* fiber;
+    TinCallFrame* frame;
+    TinFunction* function;
+    TinClosure* closure;
+    fiber = est->fiber;
+    if(!tin_vmintern_getfastcallee(callee, argc, &function, &closure))
+    {
+        return false;
+    }
+    if(fiber->framecount == fiber->framecap || (size_t)(fiber->stacktop - fiber->stackvalues) + function->maxslots > fiber->stackcap)
+    {
+        return false;
+    }
+    tin_vmintern_writeframe(est, est->ip);
+    frame = &fiber->framevalues[fiber->framecount++];
+    frame->function = function;
+    frame->closure = closure;
+    frame->ip = function->chunk.code;
+    frame->slots = fiber->stacktop - argc - 1;
+    frame->ignresult = false;
+    frame->returntonative = false;
+    tin_vmintern_readframe(est);
+    tin_vmmac_traceframe(fiber);
+    return true;
+}
+
+/*
+* "return f(...)": the callee and its arguments replace the current frame, instead of getting a new one
+* on top of it. the frame keeps its ignresult and returntonative flags, so the eventual OP_RETURN of the
+* callee goes where the current function would have returned to.
+* only plain script functions with an exact arity are handled; everything else is called normally, and
+* returns to the OP_RETURN that the compiler emits right after OP_TAILCALL.
+*/
+TIN_VM_INLINE bool tin_vmintern_tailcall(TinExecState* est, TinValue callee, uint8_t argc)
+{
+    size_t i;
+    TinFiber* fiber;
+    TinCallFrame* frame;
+    TinFunction* function;
+    TinClosure* closure;
+    TinValue* args;
+    fiber = est->fiber;
+    frame = est->frame;
+    if(!tin_vmintern_getfastcallee(callee, argc, &function, &closure))
+    {
+        return false;
+    }
+    /* a module's own frame can't be replaced, since OP_RETURN stores its result in the module */
+    if(fiber->framecount == 1 || frame->function->module != function->module)
+    {
+        return false;
+    }
+    tin_vmintern_closeupvalues(est->vm, est->slots);
+    args = fiber->stacktop - argc - 1;
+    for(i = 0; i <= argc; i++)
+    {
+        est->slots[i] = args[i];
+    }
+    fiber->stacktop = est->slots + argc + 1;
+    frame->function = function;
+    frame->closure = closure;
+    frame->ip = function->chunk.code;
+    tin_fiber_ensurestack(est->state, fiber, function->maxslots + (int)(fiber->stacktop - fiber->stackvalues));
+    tin_vmintern_readframe(est);
+    tin_vmmac_traceframe(fiber);
+    return true;
+}
+
+TIN_VM_INLINE bool tin_vmdo_call(TinExecState* est, TinValue* finalresult)
+{
+    size_t argc;
+    TinValue peeked;
+    TinString* name;
+    argc = tin_vmintern_readbyte(est);
+    tin_vmintern_writeframe(est, est->ip);
+    name = tin_vmintern_readstringlong(est);
+    peeked = tin_vmintern_peek(est, argc);
+    if(tin_vmintern_fastcall(est, peeked, argc))
+    {
+        return true;
+    }
+    tin_vmmac_callvalue(peeked, name, argc);
+    return true;
+}
+
+// OP_TAILCALL
+TIN_VM_INLINE bool tin_vmdo_tailcall(TinExecState* est, TinValue* finalresult)
+{
+    size_t argc;
+    TinValue peeked;
+    TinString* name;
+    argc = tin_vmintern_readbyte(est);
+    tin_vmintern_writeframe(est, est->ip);
+    name = tin_vmintern_readstringlong(est);
+    peeked = tin_vmintern_peek(est, argc);
+    if(tin_vmintern_tailcall(est, peeked, argc) || tin_vmintern_fastcall(est, peeked, argc))
+    {
+        return true;
+    }
+    tin_vmmac_callvalue(peeked, name, argc);
+    return true;
+}
+
+TIN_VM_INLINE TinValue tin_vmintern_arrayget(TinExecState* est, TinArray* array, TinValue key)
+{
+    int index;
+    TinValList* vl;
+    vl = &array->list;
+    index = tin_value_asnumber(key);
+    if(index < 0)
+    {
+        index = fmax(0, tin_vallist_count(vl) + index);
+    }
+    if(tin_vallist_capacity(vl) <= (size_t)index)
+    {
+        return tin_value_makenull(est->state);
+    }
+    return tin_vallist_get(vl, index);
+}
+
+TIN_VM_INLINE TinValue tin_vmintern_typedget(TinExecState* est, TinTypedArray* ta, TinValue key)
+{
+    int index;
+    index = tin_value_asnumber(key);
+    if(index < 0)
+    {
+        index = fmax(0, (int)ta->count + index);
+    }
+    if(ta->count <= (size_t)index)
+    {
+        return tin_value_makenull(est->state);
+    }
+    if(ta->kind == TINTYPED_INT64)
+    {
+        return tin_value_makefixednumber(est->state, ta->data.i64[index]);
+    }
+    return tin_value_makefloatnumber(est->state, ta->data.f64[index]);
+}
+
+/*
+* subscripts of arrays and typed arrays (number index), maps (string key) and strings (number index) are done right here,
+* with the same semantics as objfn_array_subscript, objfn_typedarray_subscript, objfn_map_subscript and objfn_string_subscript.
+* everything else, including ranges, errors and maps with an onindexfn, goes through the "[]" method.
+* an array subscript quickens the OP_GETINDEX it was called for to OP_GETINDEXARRAY, a typed array one to OP_GETINDEXTYPED.
+*/
+TIN_VM_INLINE bool tin_vmintern_getindexfast(TinExecState* est)
+{
+    int index;
+    TinValue value;
+    TinValue object;
+    TinValue key;
+    TinMap* map;
+    TinString* string;
+    TinString* c;
+    object = tin_vmintern_peek(est, 1);
+    key = tin_vmintern_peek(est, 0);
+    if(!tin_value_isobject(object))
+    {
+        return false;
+    }
+    if(tin_value_isarray(object) && tin_value_isnumber(key))
+    {
+        value = tin_vmintern_arrayget(est, tin_value_asarray(object), key);
+        est->ip[-1] = OP_GETINDEXARRAY;
+    }
+    else if(tin_value_istypedarray(object) && tin_value_isnumber(key))
+    {
+        value = tin_vmintern_typedget(est, tin_value_astypedarray(object), key);
+        est->ip[-1] = OP_GETINDEXTYPED;
+    }
+    else if(tin_value_ismap(object) && tin_value_isstring(key))
+    {
+        map = tin_value_asmap(object);
+        if(map->onindexfn != NULL)
+        {
+            return false;
+        }
+        if(!tin_table_get(&map->values, tin_value_asstring(key), &value))
+        {
+            value = tin_value_makenull(est->state);
+        }
+    }
+    else if(tin_value_isstring(object) && tin_value_isnumber(key))
+    {
+        string = tin_value_asstring(object);
+        index = tin_value_asnumber(key);
+        value = tin_value_makenull(est->state);
+        if(index < 0)
+        {
+            index = tin_string_getutflength(string) + index;
+        }
+        if(index >= 0)
+        {
+            c = tin_string_codepointat(est->state, string, tin_util_ucharoffset(string->data, index));
+            if(c != NULL)
+            {
+                value = tin_value_fromobject(c);
+            }
+        }
+    }
+    else
+    {
+        return false;
+    }
+    tin_vmintern_drop(est);
+    est->fiber->stacktop[-1] = value;
+    return true;
+}
+
+TIN_VM_INLINE bool tin_vmintern_setindexfast(TinExecState* est)
 {
-    size_t argc;
-    TinValue peeked;
-    TinString* name;
-    argc = tin_vmintern_readbyte(est);
-    tin_vmintern_writeframe(est, est->ip);
-    name = tin_vmintern_readstringlong(est);
-    peeked = tin_vmintern_peek(est, argc);
-    tin_vmmac_callvalue(peeked, name, argc);
+    int index;
+    TinValue value;
+    TinValue object;
+    TinValue key;
+    TinValList* vl;
+    TinMap* map;
+    TinTypedArray* ta;
+    object = tin_vmintern_peek(est, 2);
+    key = tin_vmintern_peek(est, 1);
+    value = tin_vmintern_peek(est, 0);
+    if(!tin_value_isobject(object))
+    {
+        return false;
+    }
+    if(tin_value_isarray(object) && tin_value_isnumber(key))
+    {
+        vl = &tin_value_asarray(object)->list;
+        index = tin_value_asnumber(key);
+        if(index < 0)
+        {
+            index = fmax(0, tin_vallist_count(vl) + index);
+        }
+        tin_vallist_set(est->state, vl, index, value);
+    }
+    else if(tin_value_istypedarray(object) && tin_value_isnumber(key) && tin_value_isnumber(value))
+    {
+        /* growing the array, and storing non-numbers (an error), is left to the "[]" method */
+        ta = tin_value_astypedarray(object);
+        index = tin_value_asnumber(key);
+        if(index < 0)
+        {
+            index = fmax(0, (int)ta->count + index);
+        }
+        if(ta->count <= (size_t)index)
+        {
+            return false;
+        }
+        if(ta->kind == TINTYPED_INT64)
+        {
+            ta->data.i64[index] = tin_value_asfixednumber(value);
+        }
+        else
+        {
+            ta->data.f64[index] = tin_value_asfloatnumber(value);
+        }
+    }
+    else if(tin_value_ismap(object) && tin_value_isstring(key))
+    {
+        map = tin_value_asmap(object);
+        if(map->onindexfn != NULL)
+        {
+            return false;
+        }
+        tin_map_set(est->state, map, tin_value_asstring(key), value);
+    }
+    else
+    {
+        return false;
+    }
+    est->fiber->stacktop -= 2;
+    est->fiber->stacktop[-1] = value;
     return true;
 }
 
+/*
+* OP_FIELDGETSLOT: an OP_FIELDGET that found a field of an instance with a shape. succeeds as long as
+* one of the field entries of its cache still gives the instance a non-null slot.
+*/
+TIN_VM_INLINE bool tin_vmintern_fieldgetslot(TinExecState* est)
+{
+    size_t i;
+    TinValue object;
+    TinShape* shape;
+    TinInstance* instobj;
+    TinInlineCache* ic;
+    TinInlineFieldEntry* entry;
+    ic = tin_vmintern_readcache(est);
+    object = tin_vmintern_peek(est, 1);
+    if(!tin_value_isinstance(object))
+    {
+        return false;
+    }
+    instobj = tin_value_asinstance(object);
+    shape = instobj->shape;
+    if(shape == NULL)
+    {
+        return false;
+    }
+    for(i = 0; i < TIN_INLINECACHE_WAYS; i++)
+    {
+        entry = &ic->fieldentries[i];
+        if(entry->shape == shape && entry->shapeid == shape->id)
+        {
+            if(entry->slot == -1 || tin_value_isnull(instobj->slots[entry->slot]))
+            {
+                return false;
+            }
+            est->state->icachehits++;
+            tin_vmintern_drop(est);
+            est->fiber->stacktop[-1] = instobj->slots[entry->slot];
+            return true;
+        }
+    }
+    return false;
+}
+
 // OP_FIELDGET
 TIN_VM_INLINE bool tin_vmdo_fieldget(TinExecState* est, TinValue* finalresult)
 {
     TinValue tmpval;
     TinValue object;
     TinValue getval;
+    TinValue* pval;
     TinString* name;
     TinClass* klassobj;
     TinField* field;
     TinInstance* instobj;
+    TinInlineCache* ic;
+    ic = tin_vmintern_readcache(est);
     object = tin_vmintern_peek(est, 1);
     name = tin_value_asstring(tin_vmintern_peek(est, 0));
     if(tin_value_isnull(object))
@@ -1164,9 +1858,18 @@ TIN_VM_INLINE bool tin_vmdo_fieldget(TinExecState* est, TinValue* finalresult)
     if(tin_value_isinstance(object))
     {
         instobj = tin_value_asinstance(object);
-        if(!tin_table_get(&instobj->fields, name, &getval))
+        pval = tin_vmintern_cachedfield(est, ic, instobj, name);
+        if(pval != NULL && !tin_value_isnull(*pval))
+        {
+            getval = *pval;
+            if(instobj->shape != NULL)
+            {
+                est->ip[-3] = OP_FIELDGETSLOT;
+            }
+        }
+        else
         {
-            if(tin_table_get(&instobj->klass->methods, name, &getval))
+            if(tin_vmintern_cachedmethod(est, ic, instobj->klass, name, &getval))
             {
                 if(tin_value_isfield(getval))
                 {
@@ -1232,7 +1935,7 @@ TIN_VM_INLINE bool tin_vmdo_fieldget(TinExecState* est, TinValue* finalresult)
         {
             tin_vmmac_raiseerrorfmtnocont("GET_FIELD: cannot get class object for type '%s'", tin_tostring_typename(object));
         }
-        if(tin_table_get(&klassobj->methods, name, &getval))
+        if(tin_vmintern_cachedmethod(est, ic, klassobj, name, &getval))
         {
             if(tin_value_isfield(getval))
             {
@@ -1271,10 +1974,13 @@ TIN_VM_INLINE bool tin_vmdo_fieldset(TinExecState* est, TinValue* finalresult)
     TinValue tmpval;
     TinValue setter;
     TinValue instval;
+    TinValue* pval;
     TinClass* klassobj;
     TinField* field;
     TinString* fieldname;
     TinInstance* instobj;
+    TinInlineCache* ic;
+    ic = tin_vmintern_readcache(est);
     instval = tin_vmintern_peek(est, 2);
     value = tin_vmintern_peek(est, 1);
     fieldname = tin_value_asstring(tin_vmintern_peek(est, 0));
@@ -1320,7 +2026,7 @@ TIN_VM_INLINE bool tin_vmdo_fieldset(TinExecState* est, TinValue* finalresult)
     else if(tin_value_isinstance(instval))
     {
         instobj = tin_value_asinstance(instval);
-        if(tin_table_get(&instobj->klass->methods, fieldname, &setter) && tin_value_isfield(setter))
+        if(tin_vmintern_cachedmethod(est, ic, instobj->klass, fieldname, &setter) && tin_value_isfield(setter))
         {
             field = tin_value_asfield(setter);
             if(field->setter == NULL)
@@ -1336,13 +2042,15 @@ TIN_VM_INLINE bool tin_vmdo_fieldset(TinExecState* est, TinValue* finalresult)
             tin_vmintern_readframe(est);
             return true;
         }
-        if(tin_value_isnull(value))
+        pval = tin_vmintern_cachedfield(est, ic, instobj, fieldname);
+        if(pval != NULL && instobj->shape != NULL)
         {
-            tin_table_delete(&instobj->fields, fieldname);
+            *pval = value;
+            tin_gcmem_writebarrier(est->state, (TinObject*)instobj, value);
         }
         else
         {
-            tin_table_set(est->state, &instobj->fields, fieldname, value);
+            tin_instance_setfield(est->state, instobj, fieldname, value);
         }
         tin_vmintern_dropn(est, 2);// Pop field name and the value
         est->fiber->stacktop[-1] = value;
@@ -1354,7 +2062,7 @@ TIN_VM_INLINE bool tin_vmdo_fieldset(TinExecState* est, TinValue* finalresult)
         {
             tin_vmmac_raiseerrorfmtnocont("SET_FIELD: only instances and classes have fields", 0);
         }
-        if(tin_table_get(&klassobj->methods, fieldname, &setter) && tin_value_isfield(setter))
+        if(tin_vmintern_cachedmethod(est, ic, klassobj, fieldname, &setter) && tin_value_isfield(setter))
         {
             field = tin_value_asfield(setter);
             if(field->setter == NULL)
@@ -1417,6 +2125,7 @@ TIN_VM_INLINE bool tin_vmdo_makeclosure(TinExecState* est, TinValue* finalresult
         {
             closure->upvalues[i] = est->upvalues[index];
         }
+        tin_gcmem_barrierobject(est->state, (TinObject*)closure, (TinObject*)closure->upvalues[i]);
     }
     return true;
 }
@@ -1433,28 +2142,27 @@ TIN_VM_INLINE bool tin_vmdo_makeclass(TinExecState* est, TinValue* finalresult)
     klassobj->parentclass = est->state->primobjectclass;
     tin_table_add_all(est->state, &klassobj->parentclass->methods, &klassobj->methods);
     tin_table_add_all(est->state, &klassobj->parentclass->staticfields, &klassobj->staticfields);
-    tin_table_set(est->state, &est->vm->globals->values, name, tin_value_fromobject(klassobj));
+    tin_class_touchmethods(est->state, klassobj);
+    tin_vm_setglobal(est->state, name, tin_value_fromobject(klassobj));
     return true;
 }
 
 // OP_MAKEMETHOD
 TIN_VM_INLINE bool tin_vmdo_makemethod(TinExecState* est, TinValue* finalresult)
 {
-    size_t ctorlen;
-    const char* ctorname;
     TinString* name;
     TinClass* klassobj;
     (void)finalresult;
-    ctorname = TIN_VALUE_CTORNAME;
-    ctorlen = strlen(ctorname);
     klassobj = tin_value_asclass(tin_vmintern_peek(est, 1));
     name = tin_vmintern_readstringlong(est);
+    /* constant strings are interned, so this is the constructor iff it is the same string */
     if((klassobj->initmethod == NULL || (klassobj->parentclass != NULL && klassobj->initmethod == ((TinClass*)klassobj->parentclass)->initmethod))
-       && tin_string_getlength(name) == ctorlen && memcmp(name->data, ctorname, ctorlen) == 0)
+       && name == est->state->symbols[TINSYM_CONSTRUCTOR])
     {
         klassobj->initmethod = tin_value_asobject(tin_vmintern_peek(est, 0));
     }
     tin_table_set(est->state, &klassobj->methods, name, tin_vmintern_peek(est, 0));
+    tin_class_touchmethods(est->state, klassobj);
     tin_vmintern_drop(est);
     return true;
 }
@@ -1479,7 +2187,7 @@ TIN_VM_INLINE bool tin_vmdo_objectpushfield(TinExecState* est, TinValue* finalre
     else if(tin_value_isinstance(operand))
     {
         tinst =tin_value_asinstance(operand); 
-        tin_table_set(est->state, &tinst->fields, tin_value_asstring(peek1), peek0);
+        tin_instance_setfield(est->state, tinst, tin_value_asstring(peek1), peek0);
     }
     else
     {
@@ -1526,7 +2234,7 @@ TIN_VM_INLINE bool tin_vmdo_reffield(TinExecState* est, TinValue* finalresult)
     if(tin_value_isinstance(object))
     {
         name = tin_value_asstring(tin_vmintern_peek(est, 0));
-        if(!tin_table_get_slot(&tin_value_asinstance(object)->fields, name, &pval))
+        if(!tin_instance_getfieldslot(tin_value_asinstance(object), name, &pval))
         {
             tin_vmmac_raiseerrorfmtnocont("attempt to reference a null value", 0);
         }
@@ -1546,29 +2254,26 @@ TIN_VM_INLINE bool tin_vmdo_reffield(TinExecState* est, TinValue* finalresult)
 // OP_GLOBALSET
 TIN_VM_INLINE bool tin_vmdo_globalset(TinExecState* est, TinValue* finalresult)
 {
-    TinString* name;
+    uint16_t index;
+    TinValue* cell;
     (void)finalresult;
-    name = tin_vmintern_readstringlong(est);
-    tin_table_set(est->state, &est->vm->globals->values, name, tin_vmintern_peek(est, 0));
+    index = tin_vmintern_readshort(est);
+    cell = tin_chunk_getglobalref(est->state, est->currentchunk, index);
+    if(tin_value_isnull(*cell) || tin_value_isnull(tin_vmintern_peek(est, 0)))
+    {
+        /* first definition, or the global going away; otherwise the cell alone is written */
+        tin_vm_setglobal(est->state, tin_value_asstring(tin_vallist_get(&est->currentchunk->constants, index)), tin_vmintern_peek(est, 0));
+        return true;
+    }
+    *cell = tin_vmintern_peek(est, 0);
     return true;
 }
 
 // OP_GLOBALGET
 TIN_VM_INLINE bool tin_vmdo_globalget(TinExecState* est, TinValue* finalresult)
 {
-    TinValue setval;
-    TinString* name;
     (void)finalresult;
-    name = tin_vmintern_readstringlong(est);
-    //fprintf(stderr, "GET_GLOBAL: %s\n", name->data);
-    if(!tin_table_get(&est->vm->globals->values, name, &setval))
-    {
-        tin_vmintern_push(est, tin_value_makenull(est->vm->state));
-    }
-    else
-    {
-        tin_vmintern_push(est, setval);
-    }
+    tin_vmintern_push(est, *tin_chunk_getglobalref(est->state, est->currentchunk, tin_vmintern_readshort(est)));
     return true;
 }
 
@@ -1593,17 +2298,13 @@ TIN_VM_INLINE bool tin_vmdo_localset(TinExecState* est, TinValue* finalresult)
 // OP_REFGLOBAL
 TIN_VM_INLINE bool tin_vmdo_refglobal(TinExecState* est, TinValue* finalresult)
 {
-    TinString* name;
     TinValue* pval;
-    name = tin_vmintern_readstringlong(est);
-    if(tin_table_get_slot(&est->vm->globals->values, name, &pval))
-    {
-        tin_vmintern_push(est, tin_value_fromobject(tin_object_makereference(est->state, pval)));
-    }
-    else
+    pval = tin_chunk_getglobalref(est->state, est->currentchunk, tin_vmintern_readshort(est));
+    if(tin_value_isnull(*pval))
     {
         tin_vmmac_raiseerrorfmtnocont("attempt to reference a null value", 0);
     }
+    tin_vmintern_push(est, tin_value_fromobject(tin_object_makereference(est->state, pval)));
     return true;
 }
 
@@ -1614,11 +2315,14 @@ TIN_VM_INLINE bool tin_vmdo_invokeignoring(TinExecState* est, TinValue* finalres
     TinValue mthval;
     TinValue receiver;
     TinValue vmthval;
+    TinValue* pval;
     TinClass* type;
     TinInstance* instance;
     TinString* mthname;
+    TinInlineCache* ic;
     argc = tin_vmintern_readbyte(est);
     mthname = tin_vmintern_readstringlong(est);
+    ic = tin_vmintern_readcache(est);
     receiver = tin_vmintern_peek(est, argc);
     if(tin_value_isnull(receiver))
     {
@@ -1627,7 +2331,7 @@ TIN_VM_INLINE bool tin_vmdo_invokeignoring(TinExecState* est, TinValue* finalres
     tin_vmintern_writeframe(est, est->ip);
     if(tin_value_isclass(receiver))
     {
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval)))
+        if((tin_value_isinstance(receiver) && (tin_instance_getfield(tin_value_asinstance(receiver), mthname, &mthval)))
            || tin_table_get(&tin_value_asclass(receiver)->staticfields, mthname, &mthval))
         {
             if(tin_vm_callvalue(est, mthval, mthname, argc))
@@ -1649,15 +2353,16 @@ TIN_VM_INLINE bool tin_vmdo_invokeignoring(TinExecState* est, TinValue* finalres
     else if(tin_value_isinstance(receiver))
     {
         instance = tin_value_asinstance(receiver);
-        if(tin_table_get(&instance->fields, mthname, &vmthval))
+        pval = tin_vmintern_cachedfield(est, ic, instance, mthname);
+        if(pval != NULL && !tin_value_isnull(*pval))
         {
+            vmthval = *pval;
             est->fiber->stacktop[-argc - 1] = vmthval;
             tin_vmmac_callvalue(vmthval, mthname, argc);
             tin_vmintern_readframe(est);
             return true;
         }
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval)))
-           || tin_table_get(&instance->klass->methods, mthname, &mthval))
+        if(tin_vmintern_cachedmethod(est, ic, instance->klass, mthname, &mthval))
         {
             if(tin_vm_callvalue(est, mthval, mthname, argc))
             {
@@ -1682,7 +2387,7 @@ TIN_VM_INLINE bool tin_vmdo_invokeignoring(TinExecState* est, TinValue* finalres
         {
             tin_vmmac_raiseerrorfmtnocont("cannot get class", 0);
         }
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval))) || tin_table_get(&type->methods, mthname, &mthval))
+        if(tin_vmintern_cachedmethod(est, ic, type, mthname, &mthval))
         {
             if(tin_vm_callvalue(est, mthval, mthname, argc))
             {
@@ -1710,11 +2415,14 @@ TIN_VM_INLINE bool tin_vmdo_invokemethod(TinExecState* est, TinValue* finalresul
     TinValue mthval;
     TinValue receiver;
     TinValue vmthval;
+    TinValue* pval;
     TinClass* type;
     TinString* mthname;
     TinInstance* instance;
+    TinInlineCache* ic;
     argc = tin_vmintern_readbyte(est);
     mthname = tin_vmintern_readstringlong(est);
+    ic = tin_vmintern_readcache(est);
     receiver = tin_vmintern_peek(est, argc);
     
     if(tin_value_isnull(receiver))
@@ -1724,7 +2432,7 @@ TIN_VM_INLINE bool tin_vmdo_invokemethod(TinExecState* est, TinValue* finalresul
     tin_vmintern_writeframe(est, est->ip);
     if(tin_value_isclass(receiver))
     {
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval)))
+        if((tin_value_isinstance(receiver) && (tin_instance_getfield(tin_value_asinstance(receiver), mthname, &mthval)))
            || tin_table_get(&tin_value_asclass(receiver)->staticfields, mthname, &mthval))
         {
             tin_vmmac_callvalue(mthval, mthname, argc);
@@ -1738,15 +2446,16 @@ TIN_VM_INLINE bool tin_vmdo_invokemethod(TinExecState* est, TinValue* finalresul
     else if(tin_value_isinstance(receiver))
     {
         instance = tin_value_asinstance(receiver);
-        if(tin_table_get(&instance->fields, mthname, &vmthval))
+        pval = tin_vmintern_cachedfield(est, ic, instance, mthname);
+        if(pval != NULL && !tin_value_isnull(*pval))
         {
+            vmthval = *pval;
             est->fiber->stacktop[-argc - 1] = vmthval;
             tin_vmmac_callvalue(vmthval, mthname, argc);
             tin_vmintern_readframe(est);
             return true;
         }
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval)))
-           || tin_table_get(&instance->klass->methods, mthname, &mthval))
+        if(tin_vmintern_cachedmethod(est, ic, instance->klass, mthname, &mthval))
         {
             tin_vmmac_callvalue(mthval, mthname, argc);
         }
@@ -1763,7 +2472,7 @@ TIN_VM_INLINE bool tin_vmdo_invokemethod(TinExecState* est, TinValue* finalresul
         {
             tin_vmmac_raiseerrorfmtnocont("cannot get class", 0);
         }
-        if((tin_value_isinstance(receiver) && (tin_table_get(&tin_value_asinstance(receiver)->fields, mthname, &mthval))) || tin_table_get(&type->methods, mthname, &mthval))
+        if(tin_vmintern_cachedmethod(est, ic, type, mthname, &mthval))
         {
             tin_vmmac_callvalue(mthval, mthname, argc);
         }
@@ -1801,7 +2510,6 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
 {
     //vartop
     uint8_t instruction;
-    uint8_t nowinstr;
     TinValList* values;
     TinExecState eststack;
     TinExecState* est;
@@ -1904,6 +2612,26 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
             &&OP_REFUPVAL,
             &&OP_REFFIELD,
             &&OP_REFSET,
+            &&OP_TAILCALL,
+            &&OP_LOCALSETPOP,
+            &&OP_LOCALLOCALARITH,
+            &&OP_LOCALCONSTARITH,
+            &&OP_LOCALLOCALBRANCH,
+            &&OP_LOCALCONSTBRANCH,
+            &&OP_LOCALINCR,
+            &&OP_MATHADDINT,
+            &&OP_MATHADDFLOAT,
+            &&OP_MATHSUBINT,
+            &&OP_MATHSUBFLOAT,
+            &&OP_MATHMULTINT,
+            &&OP_MATHMULTFLOAT,
+            &&OP_LESSTHANINT,
+            &&OP_LESSTHANFLOAT,
+            &&OP_GREATERTHANINT,
+            &&OP_GREATERTHANFLOAT,
+            &&OP_GETINDEXARRAY,
+            &&OP_FIELDGETSLOT,
+            &&OP_GETINDEXTYPED,
         };
 
     #endif
@@ -1927,14 +2655,12 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
 
         #ifdef TIN_USE_COMPUTEDGOTO
             instruction = *est->ip++;
-            nowinstr = instruction;
             #ifdef TIN_TRACE_EXECUTION
                 tin_disassemble_instruction(est->state, est->currentchunk, (size_t)(est->ip - est->currentchunk->code - 1), NULL);
             #endif
             goto* dispatchtable[instruction];
         #else
             instruction = *est->ip++;
-            nowinstr = instruction;
             #ifdef TIN_TRACE_EXECUTION
                 tin_disassemble_instruction(est->state, est->currentchunk, (size_t)(est->ip - est->currentchunk->code - 1), NULL);
             #endif
@@ -2061,7 +2787,7 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                     tin_vmmac_raiseerror("operand must be a number");
                 }
                 popped = tin_vmintern_pop(est);
-                if(popped.isfixednumber)
+                if(tin_value_isfixednumber(popped))
                 {
                     tmpval = tin_value_makefixednumber(est->vm->state, -tin_value_asfixednumber(popped));
                 }
@@ -2079,7 +2805,7 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 if(tin_value_isinstance(tin_vmintern_peek(est, 0)))
                 {
                     tin_vmintern_writeframe(est, est->ip);
-                    tin_vmmac_invokefromclass(tin_value_asinstance(tin_vmintern_peek(est, 0))->klass, tin_string_copyconst(est->state, "!"), 0, false, methods, false);
+                    tin_vmmac_invokefromclass(tin_value_asinstance(tin_vmintern_peek(est, 0))->klass, est->state->symbols[TINSYM_NOT], 0, false, methods, false);
                     continue;
                 }
                 popped = tin_vmintern_pop(est);
@@ -2115,29 +2841,93 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 }
                 else
                 {
-                    tin_vmmac_invokemethod(vala, "#", 1);
+                    tin_vmmac_invokemethod(vala, TINSYM_FLOORDIV, 1);
                 }
                 continue;
             }
             op_case(OP_MATHADD)
+            {
+                tin_vmmac_arithop(OP_MATHADD, TINSYM_ADD, +, OP_MATHADDINT, OP_MATHADDFLOAT);
+            }
             op_case(OP_MATHSUB)
+            {
+                tin_vmmac_arithop(OP_MATHSUB, TINSYM_SUB, -, OP_MATHSUBINT, OP_MATHSUBFLOAT);
+            }
             op_case(OP_MATHMULT)
-            op_case(OP_MATHPOWER)
-            op_case(OP_MATHMOD)
+            {
+                tin_vmmac_arithop(OP_MATHMULT, TINSYM_MULT, *, OP_MATHMULTINT, OP_MATHMULTFLOAT);
+            }
             op_case(OP_MATHDIV)
+            {
+                tin_vmmac_arithop(OP_MATHDIV, TINSYM_DIV, /, OP_MATHDIV, OP_MATHDIV);
+            }
+            op_case(OP_MATHMOD)
+            {
+                TinValue vala;
+                TinValue valb;
+                vala = tin_vmintern_peek(est, 1);
+                valb = tin_vmintern_peek(est, 0);
+                if(tin_value_isfixednumber(vala) && tin_value_isfixednumber(valb))
+                {
+                    tin_vmintern_drop(est);
+                    est->fiber->stacktop[-1] = tin_value_makefixednumber(est->state, tin_value_asrawfixednumber(vala) % tin_value_asrawfixednumber(valb));
+                    continue;
+                }
+                if(tin_value_isfloatnumber(vala) && tin_value_isfloatnumber(valb))
+                {
+                    tin_vmintern_drop(est);
+                    est->fiber->stacktop[-1] = tin_value_makefloatnumber(est->state, fmod(tin_value_asrawfloatnumber(vala), tin_value_asrawfloatnumber(valb)));
+                    continue;
+                }
+                tin_vmmac_binaryop(OP_MATHMOD, TINSYM_MOD);
+                continue;
+            }
+            op_case(OP_MATHPOWER)
+            {
+                tin_vmmac_binaryop(OP_MATHPOWER, TINSYM_POWER);
+                continue;
+            }
             op_case(OP_BINAND)
+            {
+                tin_vmmac_bitop(OP_BINAND, TINSYM_BINAND, &);
+            }
             op_case(OP_BINOR)
+            {
+                tin_vmmac_bitop(OP_BINOR, TINSYM_BINOR, |);
+            }
             op_case(OP_BINXOR)
+            {
+                tin_vmmac_bitop(OP_BINXOR, TINSYM_BINXOR, ^);
+            }
             op_case(OP_LEFTSHIFT)
+            {
+                tin_vmmac_binaryop(OP_LEFTSHIFT, TINSYM_LEFTSHIFT);
+                continue;
+            }
             op_case(OP_RIGHTSHIFT)
+            {
+                tin_vmmac_binaryop(OP_RIGHTSHIFT, TINSYM_RIGHTSHIFT);
+                continue;
+            }
             op_case(OP_EQUAL)
+            {
+                tin_vmmac_compareop(OP_EQUAL, TINSYM_EQUAL, ==, OP_EQUAL, OP_EQUAL);
+            }
             op_case(OP_GREATERTHAN)
+            {
+                tin_vmmac_compareop(OP_GREATERTHAN, TINSYM_GREATERTHAN, >, OP_GREATERTHANINT, OP_GREATERTHANFLOAT);
+            }
             op_case(OP_GREATEREQUAL)
+            {
+                tin_vmmac_compareop(OP_GREATEREQUAL, TINSYM_GREATEREQUAL, >=, OP_GREATEREQUAL, OP_GREATEREQUAL);
+            }
             op_case(OP_LESSTHAN)
+            {
+                tin_vmmac_compareop(OP_LESSTHAN, TINSYM_LESSTHAN, <, OP_LESSTHANINT, OP_LESSTHANFLOAT);
+            }
             op_case(OP_LESSEQUAL)
             {
-                tin_vmmac_binaryop(nowinstr, vmutil_op2s(nowinstr));
-                continue;
+                tin_vmmac_compareop(OP_LESSEQUAL, TINSYM_LESSEQUAL, <=, OP_LESSEQUAL, OP_LESSEQUAL);
             }
             op_case(OP_GLOBALSET)
             {
@@ -2212,6 +3002,7 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 uint8_t index;
                 index = tin_vmintern_readbyte(est);
                 *est->upvalues[index]->location = tin_vmintern_peek(est, 0);
+                tin_gcmem_writebarrier(est->state, (TinObject*)est->upvalues[index], tin_vmintern_peek(est, 0));
                 continue;
             }
             op_case(OP_UPVALGET)
@@ -2317,6 +3108,14 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 }
                 continue;
             }
+            op_case(OP_TAILCALL)
+            {
+                if(!tin_vmdo_tailcall(est, finalresult))
+                {
+                    return false;
+                }
+                continue;
+            }
             op_case(OP_MAKECLOSURE)
             {
                 if(!tin_vmdo_makeclosure(est, finalresult))
@@ -2357,12 +3156,20 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
             }
             op_case(OP_GETINDEX)
             {
-                tin_vmmac_invokemethod(tin_vmintern_peek(est, 1), "[]", 1);
+                if(tin_vmintern_getindexfast(est))
+                {
+                    continue;
+                }
+                tin_vmmac_invokemethod(tin_vmintern_peek(est, 1), TINSYM_SUBSCRIPT, 1);
                 continue;
             }
             op_case(OP_SETINDEX)
             {
-                tin_vmmac_invokemethod(tin_vmintern_peek(est, 2), "[]", 2);
+                if(tin_vmintern_setindexfast(est))
+                {
+                    continue;
+                }
+                tin_vmmac_invokemethod(tin_vmintern_peek(est, 2), TINSYM_SUBSCRIPT, 2);
                 continue;
             }
             op_case(OP_ARRAYPUSHVALUE)
@@ -2399,7 +3206,10 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
             }
             op_case(OP_FIELDDEFINE)
             {
-                tin_table_set(est->state, &tin_value_asclass(tin_vmintern_peek(est, 1))->methods, tin_vmintern_readstringlong(est), tin_vmintern_peek(est, 0));
+                TinClass* klassobj;
+                klassobj = tin_value_asclass(tin_vmintern_peek(est, 1));
+                tin_table_set(est->state, &klassobj->methods, tin_vmintern_readstringlong(est), tin_vmintern_peek(est, 0));
+                tin_class_touchmethods(est->state, klassobj);
                 tin_vmintern_drop(est);
                 continue;
             }
@@ -2485,6 +3295,7 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 klassobj->initmethod = superklass->initmethod;
                 tin_table_add_all(est->state, &superklass->methods, &klassobj->methods);
                 tin_table_add_all(est->state, &klassobj->parentclass->staticfields, &klassobj->staticfields);
+                tin_class_touchmethods(est->state, klassobj);
                 continue;
             }
             op_case(OP_ISCLASS)
@@ -2578,6 +3389,176 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
                 *tin_value_asreference(reference)->slot = tin_vmintern_peek(est, 0);
                 continue;
             }
+            /*
+            * superinstructions: ip[0] is the operand of the OP_LOCALGET (or OP_LOCALSET) they replaced, the
+            * rest of the sequence follows as it was emitted. when the operands aren't numbers, they do what
+            * that first instruction did, and let the rest of the sequence run as usual.
+            */
+            op_case(OP_LOCALSETPOP)
+            {
+                est->slots[est->ip[0]] = tin_vmintern_pop(est);
+                est->ip += 2;
+                continue;
+            }
+            op_case(OP_LOCALLOCALARITH)
+            op_case(OP_LOCALCONSTARITH)
+            {
+                TinValue vala;
+                TinValue valb;
+                vala = est->slots[est->ip[0]];
+                if(instruction == OP_LOCALLOCALARITH)
+                {
+                    valb = est->slots[est->ip[2]];
+                }
+                else
+                {
+                    valb = tin_vallist_get(&est->currentchunk->constants, est->ip[2]);
+                }
+                tin_vmintern_push(est, vala);
+                if(tin_value_isnumber(vala) && tin_value_isnumber(valb))
+                {
+                    vm_binaryop_actual(est, tin_chunk_genericop(est->ip[3]), vala, valb);
+                    est->ip += 4;
+                    continue;
+                }
+                est->ip += 1;
+                continue;
+            }
+            op_case(OP_LOCALLOCALBRANCH)
+            op_case(OP_LOCALCONSTBRANCH)
+            {
+                uint16_t offset;
+                TinValue vala;
+                TinValue valb;
+                vala = est->slots[est->ip[0]];
+                if(instruction == OP_LOCALLOCALBRANCH)
+                {
+                    valb = est->slots[est->ip[2]];
+                }
+                else
+                {
+                    valb = tin_vallist_get(&est->currentchunk->constants, est->ip[2]);
+                }
+                if(tin_value_isnumber(vala) && tin_value_isnumber(valb))
+                {
+                    offset = (uint16_t)((est->ip[5] << 8) | est->ip[6]);
+                    if(vmutil_numcompare(tin_chunk_genericop(est->ip[3]), vala, valb))
+                    {
+                        est->ip += 7;
+                    }
+                    else
+                    {
+                        est->ip += 7 + offset;
+                    }
+                    continue;
+                }
+                tin_vmintern_push(est, vala);
+                est->ip += 1;
+                continue;
+            }
+            op_case(OP_LOCALINCR)
+            {
+                TinValue vala;
+                TinValue valb;
+                vala = est->slots[est->ip[0]];
+                valb = tin_vallist_get(&est->currentchunk->constants, est->ip[2]);
+                tin_vmintern_push(est, vala);
+                if(tin_value_isnumber(vala) && tin_value_isnumber(valb))
+                {
+                    vm_binaryop_actual(est, tin_chunk_genericop(est->ip[3]), vala, valb);
+                    est->slots[est->ip[0]] = tin_vmintern_pop(est);
+                    est->ip += 7;
+                    continue;
+                }
+                est->ip += 1;
+                continue;
+            }
+            /*
+            * quickened instructions, see tin_chunk_genericop. when their guard fails, they turn back into
+            * the generic instruction and run that, which may quicken them again later.
+            */
+            op_case(OP_MATHADDINT)
+            {
+                tin_vmmac_quickop(OP_MATHADD, tin_value_isfixednumber, tin_value_asrawfixednumber, tin_value_makefixednumber, +);
+            }
+            op_case(OP_MATHADDFLOAT)
+            {
+                tin_vmmac_quickop(OP_MATHADD, tin_value_isfloatnumber, tin_value_asrawfloatnumber, tin_value_makefloatnumber, +);
+            }
+            op_case(OP_MATHSUBINT)
+            {
+                tin_vmmac_quickop(OP_MATHSUB, tin_value_isfixednumber, tin_value_asrawfixednumber, tin_value_makefixednumber, -);
+            }
+            op_case(OP_MATHSUBFLOAT)
+            {
+                tin_vmmac_quickop(OP_MATHSUB, tin_value_isfloatnumber, tin_value_asrawfloatnumber, tin_value_makefloatnumber, -);
+            }
+            op_case(OP_MATHMULTINT)
+            {
+                tin_vmmac_quickop(OP_MATHMULT, tin_value_isfixednumber, tin_value_asrawfixednumber, tin_value_makefixednumber, *);
+            }
+            op_case(OP_MATHMULTFLOAT)
+            {
+                tin_vmmac_quickop(OP_MATHMULT, tin_value_isfloatnumber, tin_value_asrawfloatnumber, tin_value_makefloatnumber, *);
+            }
+            op_case(OP_LESSTHANINT)
+            {
+                tin_vmmac_quickop(OP_LESSTHAN, tin_value_isfixednumber, tin_value_asrawfixednumber, tin_value_makebool, <);
+            }
+            op_case(OP_LESSTHANFLOAT)
+            {
+                tin_vmmac_quickop(OP_LESSTHAN, tin_value_isfloatnumber, tin_value_asrawfloatnumber, tin_value_makebool, <);
+            }
+            op_case(OP_GREATERTHANINT)
+            {
+                tin_vmmac_quickop(OP_GREATERTHAN, tin_value_isfixednumber, tin_value_asrawfixednumber, tin_value_makebool, >);
+            }
+            op_case(OP_GREATERTHANFLOAT)
+            {
+                tin_vmmac_quickop(OP_GREATERTHAN, tin_value_isfloatnumber, tin_value_asrawfloatnumber, tin_value_makebool, >);
+            }
+            op_case(OP_GETINDEXARRAY)
+            {
+                TinValue object;
+                TinValue key;
+                object = tin_vmintern_peek(est, 1);
+                key = tin_vmintern_peek(est, 0);
+                if(tin_value_isarray(object) && tin_value_isnumber(key))
+                {
+                    tin_vmintern_drop(est);
+                    est->fiber->stacktop[-1] = tin_vmintern_arrayget(est, tin_value_asarray(object), key);
+                    continue;
+                }
+                est->ip--;
+                est->ip[0] = OP_GETINDEX;
+                continue;
+            }
+            op_case(OP_GETINDEXTYPED)
+            {
+                TinValue object;
+                TinValue key;
+                object = tin_vmintern_peek(est, 1);
+                key = tin_vmintern_peek(est, 0);
+                if(tin_value_istypedarray(object) && tin_value_isnumber(key))
+                {
+                    tin_vmintern_drop(est);
+                    est->fiber->stacktop[-1] = tin_vmintern_typedget(est, tin_value_astypedarray(object), key);
+                    continue;
+                }
+                est->ip--;
+                est->ip[0] = OP_GETINDEX;
+                continue;
+            }
+            op_case(OP_FIELDGETSLOT)
+            {
+                if(tin_vmintern_fieldgetslot(est))
+                {
+                    continue;
+                }
+                est->ip -= 3;
+                est->ip[0] = OP_FIELDGET;
+                continue;
+            }
             vm_default()
             {
                 tin_vmmac_raiseerrorfmtcont("unknown VM op code '%d'", *est->ip);
@@ -2589,3 +3570,46 @@ bool tin_vmintern_execfiber(TinState* exstate, TinFiber* exfiber, TinValue* fina
     return false;
 }
 
+
+static TinValue objfn_vm_cachehits(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)instance;
+    (void)argc;
+    (void)argv;
+    return tin_value_makefixednumber(vm->state, vm->state->icachehits);
+}
+
+static TinValue objfn_vm_cachemisses(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)instance;
+    (void)argc;
+    (void)argv;
+    return tin_value_makefixednumber(vm->state, vm->state->icachemisses);
+}
+
+static TinValue objfn_vm_resetcachestats(TinVM* vm, TinValue instance, size_t argc, TinValue* argv)
+{
+    (void)instance;
+    (void)argc;
+    (void)argv;
+    vm->state->icachehits = 0;
+    vm->state->icachemisses = 0;
+    return tin_value_makenull(vm->state);
+}
+
+void tin_open_vm_library(TinState* state)
+{
+    TinClass* klass;
+    klass = tin_object_makeclassname(state, "VM");
+    {
+        tin_class_bindgetset(state, klass, "cacheHits", objfn_vm_cachehits, NULL, true);
+        tin_class_bindgetset(state, klass, "cacheMisses", objfn_vm_cachemisses, NULL, true);
+        tin_class_bindstaticmethod(state, klass, "resetCacheStats", objfn_vm_resetcachestats);
+    }
+    tin_state_setglobal(state, klass->name, tin_value_fromobject(klass));
+    if(klass->parentclass == NULL)
+    {
+        tin_class_inheritfrom(state, klass, state->primobjectclass);
+    }
+}
+
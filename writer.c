@@ -214,11 +214,46 @@ void tin_towriter_array(TinState* state, TinWriter* wr, TinArray* array, size_t
     tin_writer_writestring(wr, "]");
 }
 
+void tin_towriter_typedarray(TinState* state, TinWriter* wr, TinTypedArray* ta)
+{
+    size_t i;
+    (void)state;
+    tin_writer_writeformat(wr, "%s(%u) [", (ta->kind == TINTYPED_INT64) ? "Int64Array" : "Float64Array", (unsigned int)ta->count);
+    if(ta->count > 0)
+    {
+        tin_writer_writestring(wr, " ");
+        for(i = 0; i < ta->count; i++)
+        {
+            if(ta->kind == TINTYPED_INT64)
+            {
+                tin_writer_writeformat(wr, "%ld", ta->data.i64[i]);
+            }
+            else
+            {
+                tin_writer_writeformat(wr, "%g", ta->data.f64[i]);
+            }
+            if(i + 1 < ta->count)
+            {
+                tin_writer_writestring(wr, ", ");
+            }
+            else
+            {
+                tin_writer_writestring(wr, " ");
+            }
+        }
+    }
+    tin_writer_writestring(wr, "]");
+}
+
 void tin_towriter_map(TinState* state, TinWriter* wr, TinMap* map, size_t size)
 {
     bool hadbefore;
     size_t i;
     TinTabEntry* entry;
+    if(map == state->vm->globals)
+    {
+        tin_vm_syncglobals(state->vm);
+    }
     tin_writer_writeformat(wr, "(%u) {", (unsigned int)size);
     hadbefore = false;
     if(size > 0)
@@ -290,6 +325,13 @@ void tin_towriter_object(TinState* state, TinWriter* wr, TinValue value, bool wi
                     tin_writer_writeescapedstring(wr, s->data, tin_string_getlength(s), withquot);
                 }
                 break;
+            case TINTYPE_STRINGBUILDER:
+                {
+                    TinStringBuilder* sb;
+                    sb = tin_value_asstringbuilder(value);
+                    tin_writer_writeescapedstring(wr, sb->data, sds_getlength(sb->data), withquot);
+                }
+                break;
             case TINTYPE_FUNCTION:
                 {
                     TinFunction* fn;
@@ -409,6 +451,15 @@ void tin_towriter_object(TinState* state, TinWriter* wr, TinValue value, bool wi
                     tin_writer_writeformat(wr, "<userdata>");
                 }
                 break;
+            case TINTYPE_TYPEDARRAY:
+                {
+                    #ifdef TIN_MINIMIZE_CONTAINERS
+                        tin_writer_writestring(wr, "<typedarray>");
+                    #else
+                        tin_towriter_typedarray(state, wr, tin_value_astypedarray(value));
+                    #endif
+                }
+                break;
             case TINTYPE_RANGE:
                 {
                     range = tin_value_asrange(value);
@@ -459,7 +510,7 @@ void tin_towriter_value(TinState* state, TinWriter* wr, TinValue value, bool wit
     }
     else if(tin_value_isnumber(value))
     {
-        if(value.isfixednumber)
+        if(tin_value_isfixednumber(value))
         {
             tin_writer_writeformat(wr, "%ld", tin_value_asfixednumber(value));
         }
@@ -534,6 +585,10 @@ const char* tin_tostring_typename(TinValue value)
                 return "userdata";
             case TINTYPE_RANGE:
                 return "range";
+            case TINTYPE_TYPEDARRAY:
+                return "typedarray";
+            case TINTYPE_STRINGBUILDER:
+                return "stringbuilder";
             case TINTYPE_FIELD:
                 return "field";
             case TINTYPE_REFERENCE: